@@ -16,124 +16,75 @@
 * 3. This notice may not be removed or altered from any source distribution.
 */
 
+
 #ifndef B2_BROAD_PHASE_H
 #define B2_BROAD_PHASE_H
 
-/*
-This broad phase uses the Sweep and Prune algorithm as described in:
-Collision Detection in Interactive 3D Environments by Gino van den Bergen
-Also, some ideas, such as using integral values for fast compares comes from
-Bullet (http:/www.bulletphysics.com).
-*/
-
 #include "../Common/b2Settings.h"
 #include "b2Collision.h"
 #include "b2PairManager.h"
-#include <climits>
-
-const uint16 b2_invalid = USHRT_MAX;
-const uint16 b2_nullEdge = USHRT_MAX;
-struct b2BoundValues;
-
-struct b2Bound
-{
-	bool IsLower() const { return (value & 1) == 0; }
-	bool IsUpper() const { return (value & 1) == 1; }
-
-	uint16 value;
-	uint16 proxyId;
-	uint16 stabbingCount;
-};
 
-struct b2Proxy
+// Broad-phase implementations. Each world selects one when it is created.
+enum b2BroadPhaseType
 {
-	uint16 GetNext() const { return lowerBounds[0]; }
-	void SetNext(uint16 next) { lowerBounds[0] = next; }
-	bool IsValid() const { return overlapCount != b2_invalid; }
-
-	uint16 lowerBounds[2], upperBounds[2];
-	uint16 overlapCount;
-	uint16 timeStamp;
-	void* userData;
+	e_sweepAndPruneBroadPhase,	// incremental sweep and prune on quantized bounds
+	e_dynamicTreeBroadPhase,	// dynamic AABB tree of fattened AABBs
 };
 
+// The broad-phase keeps proxies for shape AABBs and reports overlapping
+// proxy pairs to the pair callback.
 class b2BroadPhase
 {
 public:
-	b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback);
-	~b2BroadPhase();
+	b2BroadPhase(const b2AABB& worldAABB);
+	virtual ~b2BroadPhase();
+
+	// Create a broad-phase of the given type, allocated with b2Alloc.
+	static b2BroadPhase* Create(b2BroadPhaseType type, const b2AABB& worldAABB, b2PairCallback* callback);
+	static void Destroy(b2BroadPhase* broadPhase);
 
 	// Use this to see if your proxy is in range. If it is not in range,
 	// it should be destroyed. Otherwise you may get O(m^2) pairs, where m
 	// is the number of proxies that are out of range.
 	bool InRange(const b2AABB& aabb) const;
 
-	// Create and destroy proxies. These call Flush first.
-	uint16 CreateProxy(const b2AABB& aabb, void* userData);
-	void DestroyProxy(int32 proxyId);
+	// Create and destroy proxies. These call Flush first. Static proxies
+	// are expected to move rarely and never pair with each other.
+	virtual uint32 CreateProxy(const b2AABB& aabb, void* userData, bool isStatic) = 0;
+	virtual void DestroyProxy(int32 proxyId) = 0;
 
 	// Call MoveProxy as many times as you like, then when you are done
 	// call Commit to finalized the proxy pairs (for your time step).
-	void MoveProxy(int32 proxyId, const b2AABB& aabb);
-	void Commit();
+	virtual void MoveProxy(int32 proxyId, const b2AABB& aabb) = 0;
+	virtual void Commit() = 0;
 
-	// Get a single proxy. Returns NULL if the id is invalid.
-	b2Proxy* GetProxy(int32 proxyId);
+	// Proxies created between BeginBatch and EndBatch are inserted together
+	// and their pairs are reported once, by EndBatch. Until then they are
+	// not returned by Query. Batches nest, the outermost EndBatch inserts.
+	virtual void BeginBatch() = 0;
+	virtual void EndBatch() = 0;
 
 	// Query an AABB for overlapping proxies, returns the user data and
 	// the count, up to the supplied maximum count.
-	int32 Query(const b2AABB& aabb, void** userData, int32 maxCount);
-
-	void Validate();
-	void ValidatePairs();
-
-private:
-	void ComputeBounds(uint16* lowerValues, uint16* upperValues, const b2AABB& aabb);
+	virtual int32 Query(const b2AABB& aabb, void** userData, int32 maxCount) = 0;
 
-	bool TestOverlap(b2Proxy* p1, b2Proxy* p2);
-	bool TestOverlap(const b2BoundValues& b, b2Proxy* p);
+	// Used by the pair manager.
+	virtual bool IsValidProxy(int32 proxyId) const = 0;
+	virtual void* GetUserData(int32 proxyId) const = 0;
+	virtual bool TestOverlap(int32 proxyId1, int32 proxyId2) const = 0;
 
-	void Query(int32* lowerIndex, int32* upperIndex, uint16 lowerValue, uint16 upperValue,
-				b2Bound* bounds, int32 boundCount, int32 axis);
-	void IncrementOverlapCount(int32 proxyId);
-	void IncrementTimeStamp();
-
-public:
-	friend class b2PairManager;
-
-	b2PairManager m_pairManager;
-
-	b2Proxy m_proxyPool[b2_maxProxies];
-	uint16 m_freeProxy;
-
-	b2Bound m_bounds[2][2*b2_maxProxies];
-
-	uint16 m_queryResults[b2_maxProxies];
-	int32 m_queryResultCount;
+	virtual void Validate() = 0;
 
 	b2AABB m_worldAABB;
-	b2Vec2 m_quantizationFactor;
 	int32 m_proxyCount;
-	uint16 m_timeStamp;
 
 	static bool s_validate;
 };
 
-
 inline bool b2BroadPhase::InRange(const b2AABB& aabb) const
 {
 	b2Vec2 d = b2Max(aabb.minVertex - m_worldAABB.maxVertex, m_worldAABB.minVertex - aabb.maxVertex);
 	return b2Max(d.x, d.y) < 0.0f;
 }
 
-inline b2Proxy* b2BroadPhase::GetProxy(int32 proxyId)
-{
-	if (proxyId == b2_nullProxy || m_proxyPool[proxyId].IsValid() == false)
-	{
-		return NULL;
-	}
-
-	return m_proxyPool + proxyId;
-}
-
 #endif
\ No newline at end of file
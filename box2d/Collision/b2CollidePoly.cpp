@@ -19,12 +19,37 @@
 #include "b2Collision.h"
 #include "b2Shape.h"
 
+#include "b2VertexSearch.h"
+
 struct ClipVertex
 {
 	b2Vec2 v;
 	b2ContactID id;
 };
 
+// Small polygons are searched faster by the scalar loop, see b2_minSimdVertices.
+int32 b2FindMaxVertex(const b2Vec2* vertices, int32 count, const b2Vec2& d)
+{
+#ifdef B2_SIMD_COLLISION
+	if (count >= b2_minSimdVertices)
+	{
+		return b2FindExtremeVertexSIMD<true>(vertices, count, d);
+	}
+#endif
+	return b2FindMaxVertexScalar(vertices, count, d);
+}
+
+int32 b2FindMinVertex(const b2Vec2* vertices, int32 count, const b2Vec2& d)
+{
+#ifdef B2_SIMD_COLLISION
+	if (count >= b2_minSimdVertices)
+	{
+		return b2FindExtremeVertexSIMD<false>(vertices, count, d);
+	}
+#endif
+	return b2FindMinVertexScalar(vertices, count, d);
+}
+
 static int32 ClipSegmentToLine(ClipVertex vOut[2], ClipVertex vIn[2],
 					  const b2Vec2& normal, float32 offset)
 {
@@ -72,17 +97,7 @@ static float32 EdgeSeparation(const b2PolyShape* poly1, int32 edge1, const b2Pol
 	b2Vec2 normalLocal2 = b2MulT(poly2->m_R, normal);
 
 	// Find support vertex on poly2 for -normal.
-	int32 vertexIndex2 = 0;
-	float32 minDot = FLT_MAX;
-	for (int32 i = 0; i < count2; ++i)
-	{
-		float32 dot = b2Dot(vert2s[i], normalLocal2);
-		if (dot < minDot)
-		{
-			minDot = dot;
-			vertexIndex2 = i;
-		}
-	}
+	int32 vertexIndex2 = b2FindMinVertex(vert2s, count2, normalLocal2);
 
 	b2Vec2 v1 = poly1->m_position + b2Mul(poly1->m_R, vert1s[edge1]);
 	b2Vec2 v2 = poly2->m_position + b2Mul(poly2->m_R, vert2s[vertexIndex2]);
@@ -100,17 +115,7 @@ static float32 FindMaxSeparation(int32* edgeIndex, const b2PolyShape* poly1, con
 	b2Vec2 dLocal1 = b2MulT(poly1->m_R, d);
 
 	// Find edge normal on poly1 that has the largest projection onto d.
-	int32 edge = 0;
-	float32 maxDot = -FLT_MAX;
-	for (int32 i = 0; i < count1; ++i)
-	{
-		float32 dot = b2Dot(poly1->m_normals[i], dLocal1);
-		if (dot > maxDot)
-		{
-			maxDot = dot;
-			edge = i;
-		}
-	}
+	int32 edge = b2FindMaxVertex(poly1->m_normals, count1, dLocal1);
 
 	// Get the separation for the edge normal.
 	float32 s = EdgeSeparation(poly1, edge, poly2);
@@ -76,7 +76,14 @@ void b2CollideCircle(b2Manifold* manifold, b2CircleShape* circle1, b2CircleShape
 void b2CollidePolyAndCircle(b2Manifold* manifold, const b2PolyShape* poly, const b2CircleShape* circle, bool conservative);
 void b2CollidePoly(b2Manifold* manifold, const b2PolyShape* poly1, const b2PolyShape* poly2, bool conservative);
 
-float32 b2Distance(b2Vec2* x1, b2Vec2* x2, const b2Shape* shape1, const b2Shape* shape2);
+// GJK iteration count is returned through optional iterations, so concurrent worlds don't share a global.
+float32 b2Distance(b2Vec2* x1, b2Vec2* x2, const b2Shape* shape1, const b2Shape* shape2, int32* iterations = NULL);
+
+// Index of the polygon vertex with the largest (smallest) projection onto d, the first
+// one on ties. The array must hold b2_maxPolyVertices vertices, the unused ones are read
+// but ignored.
+int32 b2FindMaxVertex(const b2Vec2* vertices, int32 count, const b2Vec2& d);
+int32 b2FindMinVertex(const b2Vec2* vertices, int32 count, const b2Vec2& d);
 
 inline bool b2AABB::IsValid() const
 {
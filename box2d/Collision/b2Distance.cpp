@@ -19,7 +19,6 @@
 #include "b2Collision.h"
 #include "b2Shape.h"
 
-int32 g_GJK_Iterations = 0;
 
 // GJK using Voronoi regions (Christer Ericson) and region selection
 // optimizations (Casey Muratori).
@@ -147,8 +146,14 @@ static bool InPoints(const b2Vec2& w, const b2Vec2* points, int32 pointCount)
 	return false;
 }
 
-float32 b2Distance(b2Vec2* p1Out, b2Vec2* p2Out, const b2Shape* shape1, const b2Shape* shape2)
+float32 b2Distance(b2Vec2* p1Out, b2Vec2* p2Out, const b2Shape* shape1, const b2Shape* shape2, int32* iterations)
 {
+	int32 dummy;
+	if (iterations == NULL)
+	{
+		iterations = &dummy;
+	}
+
 	b2Vec2 p1s[3], p2s[3];
 	b2Vec2 points[3];
 	int32 pointCount = 0;
@@ -174,7 +179,7 @@ float32 b2Distance(b2Vec2* p1Out, b2Vec2* p2Out, const b2Shape* shape1, const b2
 				*p1Out = w1;
 				*p2Out = w2;
 			}
-			g_GJK_Iterations = iter;
+			*iterations = iter;
 			return sqrtf(vSqr);
 		}
 
@@ -207,7 +212,7 @@ float32 b2Distance(b2Vec2* p1Out, b2Vec2* p2Out, const b2Shape* shape1, const b2
 		// If we have three points, then the origin is in the corresponding triangle.
 		if (pointCount == 3)
 		{
-			g_GJK_Iterations = iter;
+			*iterations = iter;
 			return 0.0f;
 		}
 
@@ -219,11 +224,11 @@ float32 b2Distance(b2Vec2* p1Out, b2Vec2* p2Out, const b2Shape* shape1, const b2
 
 		if (pointCount == 3 || vSqr <= 100.0f * FLT_EPSILON * maxSqr)
 		{
-			g_GJK_Iterations = iter;
+			*iterations = iter;
 			return sqrtf(vSqr);
 		}
 	}
 
-	g_GJK_Iterations = maxIterations;
+	*iterations = maxIterations;
 	return sqrtf(vSqr);
 }
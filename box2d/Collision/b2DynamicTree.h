@@ -0,0 +1,180 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_DYNAMIC_TREE_H
+#define B2_DYNAMIC_TREE_H
+
+#include "b2Collision.h"
+
+const int32 b2_nullNode = -1;
+
+inline b2AABB b2Combine(const b2AABB& a, const b2AABB& b)
+{
+	b2AABB c;
+	c.minVertex = b2Min(a.minVertex, b.minVertex);
+	c.maxVertex = b2Max(a.maxVertex, b.maxVertex);
+	return c;
+}
+
+inline float32 b2Perimeter(const b2AABB& aabb)
+{
+	b2Vec2 d = aabb.maxVertex - aabb.minVertex;
+	return 2.0f * (d.x + d.y);
+}
+
+// Does a contain b?
+inline bool b2Contains(const b2AABB& a, const b2AABB& b)
+{
+	return a.minVertex.x <= b.minVertex.x && a.minVertex.y <= b.minVertex.y &&
+		b.maxVertex.x <= a.maxVertex.x && b.maxVertex.y <= a.maxVertex.y;
+}
+
+struct b2TreeNode
+{
+	bool IsLeaf() const { return child1 == b2_nullNode; }
+
+	b2AABB aabb;
+	void* userData;
+
+	union
+	{
+		int32 parent;
+		int32 next;
+	};
+
+	int32 child1;
+	int32 child2;
+
+	// leaf = 0, free node = -1
+	int32 height;
+};
+
+// A dynamic AABB tree, balanced with tree rotations. Leaves are proxies holding
+// user data. Internal nodes bound their children. Nodes live in a growable pool
+// and are referenced by index, so proxy ids stay valid when the pool grows.
+class b2DynamicTree
+{
+public:
+	b2DynamicTree();
+	~b2DynamicTree();
+
+	// Create a leaf with the given AABB. Returns the proxy id.
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
+	void DestroyProxy(int32 proxyId);
+
+	// Reinsert a leaf with a new AABB.
+	void MoveProxy(int32 proxyId, const b2AABB& aabb);
+
+	bool IsProxy(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	const b2AABB& GetAABB(int32 proxyId) const;
+
+	// Call callback->QueryCallback(proxyId) for each leaf overlapping the AABB.
+	// The callback returns false to terminate the query.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	int32 GetHeight() const;
+	void Validate() const;
+
+private:
+	int32 AllocateNode();
+	void FreeNode(int32 node);
+
+	void InsertLeaf(int32 leaf);
+	void RemoveLeaf(int32 leaf);
+
+	int32 Balance(int32 index);
+
+	void ValidateStructure(int32 index) const;
+
+	int32 m_root;
+
+	b2TreeNode* m_nodes;
+	int32 m_nodeCount;
+	int32 m_nodeCapacity;
+
+	int32 m_freeList;
+};
+
+inline bool b2DynamicTree::IsProxy(int32 proxyId) const
+{
+	return 0 <= proxyId && proxyId < m_nodeCapacity &&
+		m_nodes[proxyId].height == 0 && m_nodes[proxyId].IsLeaf();
+}
+
+inline void* b2DynamicTree::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	return m_nodes[proxyId].userData;
+}
+
+inline const b2AABB& b2DynamicTree::GetAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	return m_nodes[proxyId].aabb;
+}
+
+inline int32 b2DynamicTree::GetHeight() const
+{
+	return m_root == b2_nullNode ? 0 : m_nodes[m_root].height;
+}
+
+template <typename T>
+inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
+{
+	// The tree is balanced, so the stack depth stays close to its height.
+	const int32 k_stackSize = 256;
+	int32 stack[k_stackSize];
+	int32 count = 0;
+
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	stack[count++] = m_root;
+
+	while (count > 0)
+	{
+		int32 nodeId = stack[--count];
+		const b2TreeNode* node = m_nodes + nodeId;
+
+		if (b2TestOverlap(node->aabb, aabb) == false)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf())
+		{
+			if (callback->QueryCallback(nodeId) == false)
+			{
+				return;
+			}
+		}
+		else
+		{
+			b2Assert(count + 2 <= k_stackSize);
+			stack[count++] = node->child1;
+			stack[count++] = node->child2;
+		}
+	}
+}
+
+#endif
@@ -20,12 +20,13 @@
 #include "b2BroadPhase.h"
 
 #include <algorithm>
+#include <memory.h>
 
 // Thomas Wang's hash, see: http://www.concentric.net/~Ttwang/tech/inthash.htm
-// This assumes proxyId1 and proxyId2 are 16-bit.
+// Ids are folded into one key; for 16-bit ids this is the same key as a plain concatenation.
 inline uint32 Hash(uint32 proxyId1, uint32 proxyId2)
 {
-	uint32 key = (proxyId2 << 16) | proxyId1;
+	uint32 key = (proxyId2 << 16) ^ proxyId1;
 	key = ~key + (key << 15);
 	key = key ^ (key >> 12);
 	key = key + (key << 2);
@@ -37,7 +38,7 @@ inline uint32 Hash(uint32 proxyId1, uint32 proxyId2)
 
 inline bool Equals(const b2Pair& pair, int32 proxyId1, int32 proxyId2)
 {
-	return pair.proxyId1 == proxyId1 && pair.proxyId2 == proxyId2;
+	return pair.proxyId1 == uint32(proxyId1) && pair.proxyId2 == uint32(proxyId2);
 }
 
 inline bool Equals(const b2BufferedPair& pair1, const b2BufferedPair& pair2)
@@ -64,23 +65,78 @@ inline bool operator < (const b2BufferedPair& pair1, const b2BufferedPair& pair2
 
 b2PairManager::b2PairManager()
 {
-	b2Assert(b2IsPowerOfTwo(b2_tableCapacity) == true);
-	b2Assert(b2_tableCapacity >= b2_maxPairs);
-	for (int32 i = 0; i < b2_tableCapacity; ++i)
+	b2Assert(b2IsPowerOfTwo(b2_initialPairCapacity) == true);
+	m_pairs = NULL;
+	m_pairBuffer = NULL;
+	m_hashTable = NULL;
+	m_pairCapacity = 0;
+	m_tableMask = 0;
+	m_freePair = b2_nullPair;
+	m_pairCount = 0;
+	m_pairBufferCount = 0;
+	Grow();
+}
+
+b2PairManager::~b2PairManager()
+{
+	b2Free(m_pairs);
+	b2Free(m_pairBuffer);
+	b2Free(m_hashTable);
+}
+
+// The hash table has one bucket per pair slot, so chains stay short as pairs are added.
+void b2PairManager::Grow()
+{
+	int32 oldCapacity = m_pairCapacity;
+	int32 newCapacity = oldCapacity == 0 ? b2_initialPairCapacity : 2 * oldCapacity;
+
+	b2Pair* pairs = (b2Pair*)b2Alloc(newCapacity * sizeof(b2Pair));
+	b2BufferedPair* pairBuffer = (b2BufferedPair*)b2Alloc(newCapacity * sizeof(b2BufferedPair));
+
+	if (oldCapacity > 0)
 	{
-		m_hashTable[i] = b2_nullPair;
+		memcpy(pairs, m_pairs, oldCapacity * sizeof(b2Pair));
+		memcpy(pairBuffer, m_pairBuffer, m_pairBufferCount * sizeof(b2BufferedPair));
+
+		b2Free(m_pairs);
+		b2Free(m_pairBuffer);
+		b2Free(m_hashTable);
 	}
-	m_freePair = 0;
-	for (int32 i = 0; i < b2_maxPairs; ++i)
+
+	m_pairs = pairs;
+	m_pairBuffer = pairBuffer;
+	m_hashTable = (uint32*)b2Alloc(newCapacity * sizeof(uint32));
+	m_tableMask = uint32(newCapacity - 1);
+
+	// Link the new pairs in front of the free list.
+	for (int32 i = oldCapacity; i < newCapacity; ++i)
 	{
 		m_pairs[i].proxyId1 = b2_nullProxy;
 		m_pairs[i].proxyId2 = b2_nullProxy;
 		m_pairs[i].userData = NULL;
 		m_pairs[i].status = 0;
-		m_pairs[i].next = uint16(i + 1);
+		m_pairs[i].next = i + 1 < newCapacity ? uint32(i + 1) : m_freePair;
+	}
+	m_freePair = uint32(oldCapacity);
+	m_pairCapacity = newCapacity;
+
+	// Rehash the pairs in use.
+	for (int32 i = 0; i < newCapacity; ++i)
+	{
+		m_hashTable[i] = b2_nullPair;
+	}
+	for (int32 i = 0; i < oldCapacity; ++i)
+	{
+		b2Pair* pair = m_pairs + i;
+		if (pair->proxyId1 == b2_nullProxy)
+		{
+			continue;
+		}
+
+		uint32 hash = Hash(pair->proxyId1, pair->proxyId2) & m_tableMask;
+		pair->next = m_hashTable[hash];
+		m_hashTable[hash] = uint32(i);
 	}
-	m_pairs[b2_maxPairs-1].next = b2_nullPair;
-	m_pairCount = 0;
 }
 
 void b2PairManager::Initialize(b2BroadPhase* broadPhase, b2PairCallback* callback)
@@ -91,7 +147,7 @@ void b2PairManager::Initialize(b2BroadPhase* broadPhase, b2PairCallback* callbac
 
 b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2, uint32 hash)
 {
-	int32 index = m_hashTable[hash];
+	uint32 index = m_hashTable[hash];
 
 	while (index != b2_nullPair && Equals(m_pairs[index], proxyId1, proxyId2) == false)
 	{
@@ -103,7 +159,7 @@ b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2, uint32 hash)
 		return NULL;
 	}
 
-	b2Assert(index < b2_maxPairs);
+	b2Assert(index < uint32(m_pairCapacity));
 
 	return m_pairs + index;
 }
@@ -112,7 +168,7 @@ b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2)
 {
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	uint32 hash = Hash(proxyId1, proxyId2) & m_tableMask;
 
 	return Find(proxyId1, proxyId2, hash);
 }
@@ -122,7 +178,7 @@ b2Pair* b2PairManager::AddPair(int32 proxyId1, int32 proxyId2)
 {
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	uint32 hash = Hash(proxyId1, proxyId2) & m_tableMask;
 
 	b2Pair* pair = Find(proxyId1, proxyId2, hash);
 	if (pair != NULL)
@@ -130,14 +186,20 @@ b2Pair* b2PairManager::AddPair(int32 proxyId1, int32 proxyId2)
 		return pair;
 	}
 
-	b2Assert(m_pairCount < b2_maxPairs && m_freePair != b2_nullPair);
+	if (m_freePair == b2_nullPair)
+	{
+		Grow();
+		hash = Hash(proxyId1, proxyId2) & m_tableMask;
+	}
+
+	b2Assert(m_pairCount < m_pairCapacity && m_freePair != b2_nullPair);
 
-	uint16 pairIndex = m_freePair;
+	uint32 pairIndex = m_freePair;
 	pair = m_pairs + pairIndex;
 	m_freePair = pair->next;
 
-	pair->proxyId1 = (uint16)proxyId1;
-	pair->proxyId2 = (uint16)proxyId2;
+	pair->proxyId1 = (uint32)proxyId1;
+	pair->proxyId2 = (uint32)proxyId2;
 	pair->status = 0;
 	pair->userData = NULL;
 	pair->next = m_hashTable[hash];
@@ -156,14 +218,14 @@ void* b2PairManager::RemovePair(int32 proxyId1, int32 proxyId2)
 
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	uint32 hash = Hash(proxyId1, proxyId2) & m_tableMask;
 
-	uint16* node = &m_hashTable[hash];
+	uint32* node = &m_hashTable[hash];
 	while (*node != b2_nullPair)
 	{
 		if (Equals(m_pairs[*node], proxyId1, proxyId2))
 		{
-			uint16 index = *node;
+			uint32 index = *node;
 			*node = m_pairs[*node].next;
 			
 			b2Pair* pair = m_pairs + index;
@@ -208,18 +270,22 @@ If the added pair is not a new pair, then it must be in the pair buffer (because
 */
 void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 {
-	b2Assert(id1 != b2_nullProxy && id2 != b2_nullProxy);
-	b2Assert(m_pairBufferCount < b2_maxPairs);
+	b2Assert(id1 != (int32)b2_nullProxy && id2 != (int32)b2_nullProxy);
 
 	b2Pair* pair = AddPair(id1, id2);
 
 	// If this pair is not in the pair buffer ...
 	if (pair->IsBuffered() == false)
 	{
-		// This must be a newly added pair.
-		b2Assert(pair->IsFinal() == false);
+		// An existing pair is reported again. The tree broad-phase reports all
+		// overlaps of a moved proxy, not just the new ones.
+		if (pair->IsFinal() == true)
+		{
+			return;
+		}
 
-		// Add it to the pair buffer.
+		// Add it to the pair buffer. The buffer holds existing pairs only, so it cannot overflow.
+		b2Assert(m_pairBufferCount < m_pairCapacity);
 		pair->SetBuffered();
 		m_pairBuffer[m_pairBufferCount].proxyId1 = pair->proxyId1;
 		m_pairBuffer[m_pairBufferCount].proxyId2 = pair->proxyId2;
@@ -240,8 +306,8 @@ void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 // Buffer a pair for removal.
 void b2PairManager::RemoveBufferedPair(int32 id1, int32 id2)
 {
-	b2Assert(id1 != b2_nullProxy && id2 != b2_nullProxy);
-	b2Assert(m_pairBufferCount < b2_maxPairs);
+	b2Assert(id1 != (int32)b2_nullProxy && id2 != (int32)b2_nullProxy);
+	b2Assert(m_pairBufferCount < m_pairCapacity);
 
 	b2Pair* pair = Find(id1, id2);
 
@@ -277,21 +343,17 @@ void b2PairManager::Commit()
 {
 	int32 removeCount = 0;
 
-	b2Proxy* proxies = m_broadPhase->m_proxyPool;
-
 	for (int32 i = 0; i < m_pairBufferCount; ++i)
 	{
 		b2Pair* pair = Find(m_pairBuffer[i].proxyId1, m_pairBuffer[i].proxyId2);
 		b2Assert(pair->IsBuffered());
 		pair->ClearBuffered();
 
-		b2Assert(pair->proxyId1 < b2_maxProxies && pair->proxyId2 < b2_maxProxies);
-
-		b2Proxy* proxy1 = proxies + pair->proxyId1;
-		b2Proxy* proxy2 = proxies + pair->proxyId2;
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId1));
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId2));
 
-		b2Assert(proxy1->IsValid());
-		b2Assert(proxy2->IsValid());
+		void* proxyUserData1 = m_broadPhase->GetUserData(pair->proxyId1);
+		void* proxyUserData2 = m_broadPhase->GetUserData(pair->proxyId2);
 
 		if (pair->IsRemoved())
 		{
@@ -300,7 +362,7 @@ void b2PairManager::Commit()
 			// the user didn't receive a matching add.
 			if (pair->IsFinal() == true)
 			{
-				m_callback->PairRemoved(proxy1->userData, proxy2->userData, pair->userData);
+				m_callback->PairRemoved(proxyUserData1, proxyUserData2, pair->userData);
 			}
 
 			// Store the ids so we can actually remove the pair below.
@@ -310,11 +372,11 @@ void b2PairManager::Commit()
 		}
 		else
 		{
-			b2Assert(m_broadPhase->TestOverlap(proxy1, proxy2) == true);
+			b2Assert(m_broadPhase->TestOverlap(pair->proxyId1, pair->proxyId2) == true);
 
 			if (pair->IsFinal() == false)
 			{
-				pair->userData = m_callback->PairAdded(proxy1->userData, proxy2->userData);
+				pair->userData = m_callback->PairAdded(proxyUserData1, proxyUserData2);
 				pair->SetFinal();
 			}
 		}
@@ -351,14 +413,8 @@ void b2PairManager::ValidateBuffer()
 		b2Assert(pair->IsBuffered());
 
 		b2Assert(pair->proxyId1 != pair->proxyId2);
-		b2Assert(pair->proxyId1 < b2_maxProxies);
-		b2Assert(pair->proxyId2 < b2_maxProxies);
-
-		b2Proxy* proxy1 = m_broadPhase->m_proxyPool + pair->proxyId1;
-		b2Proxy* proxy2 = m_broadPhase->m_proxyPool + pair->proxyId2;
-
-		b2Assert(proxy1->IsValid() == true);
-		b2Assert(proxy2->IsValid() == true);
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId1) == true);
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId2) == true);
 	}
 #endif
 }
@@ -366,9 +422,9 @@ void b2PairManager::ValidateBuffer()
 void b2PairManager::ValidateTable()
 {
 #ifdef _DEBUG
-	for (int32 i = 0; i < b2_tableCapacity; ++i)
+	for (int32 i = 0; i < m_pairCapacity; ++i)
 	{
-		uint16 index = m_hashTable[i];
+		uint32 index = m_hashTable[i];
 		while (index != b2_nullPair)
 		{
 			b2Pair* pair = m_pairs + index;
@@ -377,16 +433,10 @@ void b2PairManager::ValidateTable()
 			b2Assert(pair->IsRemoved() == false);
 
 			b2Assert(pair->proxyId1 != pair->proxyId2);
-			b2Assert(pair->proxyId1 < b2_maxProxies);
-			b2Assert(pair->proxyId2 < b2_maxProxies);
-
-			b2Proxy* proxy1 = m_broadPhase->m_proxyPool + pair->proxyId1;
-			b2Proxy* proxy2 = m_broadPhase->m_proxyPool + pair->proxyId2;
-
-			b2Assert(proxy1->IsValid() == true);
-			b2Assert(proxy2->IsValid() == true);
+			b2Assert(m_broadPhase->IsValidProxy(pair->proxyId1) == true);
+			b2Assert(m_broadPhase->IsValidProxy(pair->proxyId2) == true);
 
-			b2Assert(m_broadPhase->TestOverlap(proxy1, proxy2) == true);
+			b2Assert(m_broadPhase->TestOverlap(pair->proxyId1, pair->proxyId2) == true);
 
 			index = pair->next;
 		}
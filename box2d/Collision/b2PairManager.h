@@ -29,12 +29,9 @@
 #include <climits>
 
 class b2BroadPhase;
-struct b2Proxy;
 
-const uint16 b2_nullPair = USHRT_MAX;
-const uint16 b2_nullProxy = USHRT_MAX;
-const int32 b2_tableCapacity = b2_maxPairs;	// must be a power of two
-const int32 b2_tableMask = b2_tableCapacity - 1;
+const uint32 b2_nullPair = UINT_MAX;
+const uint32 b2_nullProxy = UINT_MAX;
 
 struct b2Pair
 {
@@ -57,16 +54,16 @@ struct b2Pair
 	bool IsFinal()		{ return (status & e_pairFinal) == e_pairFinal; }
 
 	void* userData;
-	uint16 proxyId1;
-	uint16 proxyId2;
-	uint16 next;
+	uint32 proxyId1;
+	uint32 proxyId2;
+	uint32 next;
 	uint16 status;
 };
 
 struct b2BufferedPair
 {
-	uint16 proxyId1;
-	uint16 proxyId2;
+	uint32 proxyId1;
+	uint32 proxyId2;
 };
 
 class b2PairCallback
@@ -87,6 +84,7 @@ class b2PairManager
 {
 public:
 	b2PairManager();
+	~b2PairManager();
 
 	void Initialize(b2BroadPhase* broadPhase, b2PairCallback* callback);
 
@@ -102,20 +100,25 @@ private:
 	b2Pair* AddPair(int32 proxyId1, int32 proxyId2);
 	void* RemovePair(int32 proxyId1, int32 proxyId2);
 
+	// Doubles pair storage and rebuilds the hash table. Invalidates pair pointers.
+	void Grow();
+
 	void ValidateBuffer();
 	void ValidateTable();
 
 public:
 	b2BroadPhase *m_broadPhase;
 	b2PairCallback *m_callback;
-	b2Pair m_pairs[b2_maxPairs];
-	uint16 m_freePair;
+	b2Pair* m_pairs;
+	uint32 m_freePair;
 	int32 m_pairCount;
+	int32 m_pairCapacity;	// also capacity of the pair buffer and the hash table, a power of two
 
-	b2BufferedPair m_pairBuffer[b2_maxPairs];
+	b2BufferedPair* m_pairBuffer;
 	int32 m_pairBufferCount;
 
-	uint16 m_hashTable[b2_tableCapacity];
+	uint32* m_hashTable;
+	uint32 m_tableMask;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1230 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2SAPBroadPhase.h"
+#include <algorithm>
+#include <memory.h>
+
+// Notes:
+// - we use bound arrays instead of linked lists for cache coherence.
+// - we use quantized integral values for fast compares.
+// - we use 32-bit indices rather than pointers to save memory; storage grows on demand.
+// - we use a stabbing count for fast overlap queries (less than order N).
+// - we also use a time stamp on each proxy to speed up the registration of
+//   overlap query results.
+// - where possible, we compare bound indices instead of values to reduce
+//   cache misses (TODO_ERIN).
+// - static proxies are kept out of the bound arrays in an AABB tree. They do not
+//   pay for sorting, and moving proxies only look at them when they move.
+// - no broadphase is perfect and neither is this one: it is not great for huge
+//   worlds (use a multi-SAP instead), it is not great for large objects.
+
+struct b2BoundValues
+{
+	uint16 lowerValues[2];
+	uint16 upperValues[2];
+};
+
+static bool b2TestOverlap(const b2BoundValues& a, const b2BoundValues& b)
+{
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		if (a.lowerValues[axis] > b.upperValues[axis])
+			return false;
+
+		if (a.upperValues[axis] < b.lowerValues[axis])
+			return false;
+	}
+
+	return true;
+}
+
+// Static and pending proxies keep their bound values in place of bound indices.
+static void b2GetStoredValues(const b2Proxy* proxy, b2BoundValues* values)
+{
+	b2Assert(proxy->IsStatic() || proxy->IsPending());
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		values->lowerValues[axis] = (uint16)proxy->lowerBounds[axis];
+		values->upperValues[axis] = (uint16)proxy->upperBounds[axis];
+	}
+}
+
+// Adds the pairs a moving proxy gained with static proxies and removes the ones
+// it lost. The static tree only finds candidates, the bound values decide.
+struct b2StaticPairUpdater
+{
+	bool QueryCallback(int32 nodeId)
+	{
+		int32 staticId = (int32)(size_t)broadPhase->m_staticTree.GetUserData(nodeId);
+		b2BoundValues staticValues;
+		b2GetStoredValues(broadPhase->m_proxyPool + staticId, &staticValues);
+
+		bool wasOverlapping = oldValues && b2TestOverlap(*oldValues, staticValues);
+		bool isOverlapping = newValues && b2TestOverlap(*newValues, staticValues);
+
+		if (isOverlapping && wasOverlapping == false)
+		{
+			broadPhase->m_pairManager.AddBufferedPair(proxyId, staticId);
+		}
+		else if (wasOverlapping && isOverlapping == false)
+		{
+			broadPhase->m_pairManager.RemoveBufferedPair(proxyId, staticId);
+		}
+
+		return true;
+	}
+
+	b2SAPBroadPhase* broadPhase;
+	int32 proxyId;
+	const b2BoundValues* oldValues;
+	const b2BoundValues* newValues;
+};
+
+struct b2StaticQueryCollector
+{
+	bool QueryCallback(int32 nodeId)
+	{
+		if (count == maxCount)
+		{
+			return false;
+		}
+
+		const b2Proxy* proxy = broadPhase->m_proxyPool + (size_t)broadPhase->m_staticTree.GetUserData(nodeId);
+		b2BoundValues staticValues;
+		b2GetStoredValues(proxy, &staticValues);
+
+		if (b2TestOverlap(values, staticValues))
+		{
+			userData[count++] = proxy->userData;
+		}
+
+		return true;
+	}
+
+	const b2SAPBroadPhase* broadPhase;
+	b2BoundValues values;
+	void** userData;
+	int32 count;
+	int32 maxCount;
+};
+
+static void b2SetStoredValues(b2Proxy* proxy, const b2BoundValues& values)
+{
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		proxy->lowerBounds[axis] = values.lowerValues[axis];
+		proxy->upperBounds[axis] = values.upperValues[axis];
+	}
+}
+
+static bool b2BoundLess(const b2Bound& a, const b2Bound& b)
+{
+	return a.value < b.value;
+}
+
+static int32 BinarySearch(b2Bound* bounds, int32 count, uint16 value)
+{
+	int32 low = 0;
+	int32 high = count - 1;
+	while (low <= high)
+	{
+		int32 mid = (low + high) >> 1;
+		if (bounds[mid].value > value)
+		{
+			high = mid - 1;
+		}
+		else if (bounds[mid].value < value)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			return mid;
+		}
+	}
+	
+	return low;
+}
+
+b2SAPBroadPhase::b2SAPBroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
+	: b2BroadPhase(worldAABB)
+{
+	m_pairManager.Initialize(this, callback);
+
+	b2Vec2 d = worldAABB.maxVertex - worldAABB.minVertex;
+	m_quantizationFactor.x = USHRT_MAX / d.x;
+	m_quantizationFactor.y = USHRT_MAX / d.y;
+
+	m_proxyPool = NULL;
+	m_bounds[0] = NULL;
+	m_bounds[1] = NULL;
+	m_queryResults = NULL;
+	m_proxyCapacity = 0;
+	m_freeProxy = b2_nullProxy;
+	m_staticProxyCount = 0;
+	m_pendingProxies = NULL;
+	m_pendingProxyCount = 0;
+	m_batchDepth = 0;
+	Grow();
+
+	m_timeStamp = 1;
+	m_queryResultCount = 0;
+}
+
+b2SAPBroadPhase::~b2SAPBroadPhase()
+{
+	b2Free(m_proxyPool);
+	b2Free(m_bounds[0]);
+	b2Free(m_bounds[1]);
+	b2Free(m_queryResults);
+	b2Free(m_pendingProxies);
+}
+
+void b2SAPBroadPhase::Grow()
+{
+	int32 oldCapacity = m_proxyCapacity;
+	int32 newCapacity = oldCapacity == 0 ? b2_initialProxyCapacity : 2 * oldCapacity;
+
+	b2Proxy* proxyPool = (b2Proxy*)b2Alloc(newCapacity * sizeof(b2Proxy));
+	b2Bound* bounds0 = (b2Bound*)b2Alloc(2 * newCapacity * sizeof(b2Bound));
+	b2Bound* bounds1 = (b2Bound*)b2Alloc(2 * newCapacity * sizeof(b2Bound));
+	uint32* queryResults = (uint32*)b2Alloc(newCapacity * sizeof(uint32));
+	uint32* pendingProxies = (uint32*)b2Alloc(newCapacity * sizeof(uint32));
+
+	if (oldCapacity > 0)
+	{
+		memcpy(proxyPool, m_proxyPool, oldCapacity * sizeof(b2Proxy));
+		memcpy(bounds0, m_bounds[0], GetBoundCount() * sizeof(b2Bound));
+		memcpy(bounds1, m_bounds[1], GetBoundCount() * sizeof(b2Bound));
+		memcpy(queryResults, m_queryResults, m_queryResultCount * sizeof(uint32));
+		memcpy(pendingProxies, m_pendingProxies, m_pendingProxyCount * sizeof(uint32));
+
+		b2Free(m_proxyPool);
+		b2Free(m_bounds[0]);
+		b2Free(m_bounds[1]);
+		b2Free(m_queryResults);
+		b2Free(m_pendingProxies);
+	}
+
+	m_proxyPool = proxyPool;
+	m_bounds[0] = bounds0;
+	m_bounds[1] = bounds1;
+	m_queryResults = queryResults;
+	m_pendingProxies = pendingProxies;
+
+	// Link the new proxies in front of the free list.
+	for (int32 i = oldCapacity; i < newCapacity; ++i)
+	{
+		m_proxyPool[i].SetNext(i + 1 < newCapacity ? uint32(i + 1) : m_freeProxy);
+		m_proxyPool[i].timeStamp = 0;
+		m_proxyPool[i].overlapCount = b2_invalid;
+		m_proxyPool[i].staticNode = b2_nullNode;
+		m_proxyPool[i].userData = NULL;
+	}
+	m_freeProxy = uint32(oldCapacity);
+	m_proxyCapacity = newCapacity;
+}
+
+// This one is only used for validation.
+bool b2SAPBroadPhase::TestOverlap(const b2Proxy* p1, const b2Proxy* p2) const
+{
+	b2BoundValues values1, values2;
+	GetBoundValues(p1, &values1);
+	GetBoundValues(p2, &values2);
+	return b2TestOverlap(values1, values2);
+}
+
+bool b2SAPBroadPhase::TestOverlap(int32 proxyId1, int32 proxyId2) const
+{
+	return TestOverlap(m_proxyPool + proxyId1, m_proxyPool + proxyId2);
+}
+
+bool b2SAPBroadPhase::TestOverlap(const b2BoundValues& b, b2Proxy* p)
+{
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2Bound* bounds = m_bounds[axis];
+
+		b2Assert(p->lowerBounds[axis] < uint32(GetBoundCount()));
+		b2Assert(p->upperBounds[axis] < uint32(GetBoundCount()));
+
+		if (b.lowerValues[axis] > bounds[p->upperBounds[axis]].value)
+			return false;
+
+		if (b.upperValues[axis] < bounds[p->lowerBounds[axis]].value)
+			return false;
+	}
+
+	return true;
+}
+
+void b2SAPBroadPhase::ComputeBounds(uint16* lowerValues, uint16* upperValues, const b2AABB& aabb)
+{
+	b2Assert(aabb.maxVertex.x > aabb.minVertex.x);
+	b2Assert(aabb.maxVertex.y > aabb.minVertex.y);
+
+	b2Vec2 minVertex = b2Clamp(aabb.minVertex, m_worldAABB.minVertex, m_worldAABB.maxVertex);
+	b2Vec2 maxVertex = b2Clamp(aabb.maxVertex, m_worldAABB.minVertex, m_worldAABB.maxVertex);
+
+	// Bump lower bounds downs and upper bounds up. This ensures correct sorting of
+	// lower/upper bounds that would have equal values.
+	// TODO_ERIN implement fast float to uint16 conversion.
+	lowerValues[0] = (uint16)(m_quantizationFactor.x * (minVertex.x - m_worldAABB.minVertex.x)) & (USHRT_MAX - 1);
+	upperValues[0] = (uint16)(m_quantizationFactor.x * (maxVertex.x - m_worldAABB.minVertex.x)) | 1;
+
+	lowerValues[1] = (uint16)(m_quantizationFactor.y * (minVertex.y - m_worldAABB.minVertex.y)) & (USHRT_MAX - 1);
+	upperValues[1] = (uint16)(m_quantizationFactor.y * (maxVertex.y - m_worldAABB.minVertex.y)) | 1;
+}
+
+// The inverse of ComputeBounds, grown by one quantum so float rounding cannot
+// lose an overlap. Used for the static tree only.
+void b2SAPBroadPhase::ComputeAABB(b2AABB* aabb, const b2BoundValues& values) const
+{
+	aabb->minVertex.x = m_worldAABB.minVertex.x + (values.lowerValues[0] - 1.0f) / m_quantizationFactor.x;
+	aabb->minVertex.y = m_worldAABB.minVertex.y + (values.lowerValues[1] - 1.0f) / m_quantizationFactor.y;
+	aabb->maxVertex.x = m_worldAABB.minVertex.x + (values.upperValues[0] + 1.0f) / m_quantizationFactor.x;
+	aabb->maxVertex.y = m_worldAABB.minVertex.y + (values.upperValues[1] + 1.0f) / m_quantizationFactor.y;
+}
+
+void b2SAPBroadPhase::GetBoundValues(const b2Proxy* proxy, b2BoundValues* values) const
+{
+	if (proxy->IsStatic() || proxy->IsPending())
+	{
+		b2GetStoredValues(proxy, values);
+		return;
+	}
+
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2Assert(proxy->lowerBounds[axis] < uint32(GetBoundCount()));
+		b2Assert(proxy->upperBounds[axis] < uint32(GetBoundCount()));
+
+		values->lowerValues[axis] = m_bounds[axis][proxy->lowerBounds[axis]].value;
+		values->upperValues[axis] = m_bounds[axis][proxy->upperBounds[axis]].value;
+	}
+}
+
+void b2SAPBroadPhase::IncrementTimeStamp()
+{
+	if (m_timeStamp == USHRT_MAX)
+	{
+		for (int32 i = 0; i < m_proxyCapacity; ++i)
+		{
+			m_proxyPool[i].timeStamp = 0;
+		}
+		m_timeStamp = 1;
+	}
+	else
+	{
+		++m_timeStamp;
+	}
+}
+
+void b2SAPBroadPhase::IncrementOverlapCount(int32 proxyId)
+{
+	b2Proxy* proxy = m_proxyPool + proxyId;
+	if (proxy->timeStamp < m_timeStamp)
+	{
+		proxy->timeStamp = m_timeStamp;
+		proxy->overlapCount = 1;
+	}
+	else
+	{
+		proxy->overlapCount = 2;
+		b2Assert(m_queryResultCount < m_proxyCapacity);
+		m_queryResults[m_queryResultCount] = (uint32)proxyId;
+		++m_queryResultCount;
+	}
+}
+
+void b2SAPBroadPhase::Query(int32* lowerQueryOut, int32* upperQueryOut,
+					   uint16 lowerValue, uint16 upperValue,
+					   b2Bound* bounds, int32 boundCount, int32 axis)
+{
+	int32 lowerQuery = BinarySearch(bounds, boundCount, lowerValue);
+	int32 upperQuery = BinarySearch(bounds, boundCount, upperValue);
+
+	// Easy case: lowerQuery <= lowerIndex(i) < upperQuery
+	// Solution: search query range for min bounds.
+	for (int32 i = lowerQuery; i < upperQuery; ++i)
+	{
+		if (bounds[i].IsLower())
+		{
+			IncrementOverlapCount(bounds[i].proxyId);
+		}
+	}
+
+	// Hard case: lowerIndex(i) < lowerQuery < upperIndex(i)
+	// Solution: use the stabbing count to search down the bound array.
+	if (lowerQuery > 0)
+	{
+		int32 i = lowerQuery - 1;
+		int32 s = bounds[i].stabbingCount;
+
+		// Find the s overlaps.
+		while (s)
+		{
+			b2Assert(i >= 0);
+
+			if (bounds[i].IsLower())
+			{
+				b2Proxy* proxy = m_proxyPool + bounds[i].proxyId;
+				if (lowerQuery <= (int32)proxy->upperBounds[axis])
+				{
+					IncrementOverlapCount(bounds[i].proxyId);
+					--s;
+				}
+			}
+			--i;
+		}
+	}
+
+	*lowerQueryOut = lowerQuery;
+	*upperQueryOut = upperQuery;
+}
+
+// Collect the moving proxies overlapping the values in m_queryResults.
+void b2SAPBroadPhase::QueryBounds(const b2BoundValues& values)
+{
+	int32 lowerIndex, upperIndex;
+	Query(&lowerIndex, &upperIndex, values.lowerValues[0], values.upperValues[0], m_bounds[0], GetBoundCount(), 0);
+	Query(&lowerIndex, &upperIndex, values.lowerValues[1], values.upperValues[1], m_bounds[1], GetBoundCount(), 1);
+
+	b2Assert(m_queryResultCount < m_proxyCapacity);
+}
+
+void b2SAPBroadPhase::UpdateStaticPairs(int32 proxyId, const b2BoundValues* oldValues, const b2BoundValues* newValues)
+{
+	if (m_staticProxyCount == 0)
+	{
+		return;
+	}
+
+	b2AABB aabb;
+	if (oldValues && newValues)
+	{
+		if (memcmp(oldValues, newValues, sizeof(b2BoundValues)) == 0)
+		{
+			return;
+		}
+
+		b2AABB oldAABB, newAABB;
+		ComputeAABB(&oldAABB, *oldValues);
+		ComputeAABB(&newAABB, *newValues);
+		aabb = b2Combine(oldAABB, newAABB);
+	}
+	else
+	{
+		b2Assert(oldValues || newValues);
+		ComputeAABB(&aabb, oldValues ? *oldValues : *newValues);
+	}
+
+	b2StaticPairUpdater updater;
+	updater.broadPhase = this;
+	updater.proxyId = proxyId;
+	updater.oldValues = oldValues;
+	updater.newValues = newValues;
+	m_staticTree.Query(&updater, aabb);
+}
+
+void b2SAPBroadPhase::CreateStaticProxy(int32 proxyId, const b2BoundValues& values)
+{
+	b2Proxy* proxy = m_proxyPool + proxyId;
+	b2SetStoredValues(proxy, values);
+
+	b2AABB aabb;
+	ComputeAABB(&aabb, values);
+	proxy->staticNode = m_staticTree.CreateProxy(aabb, (void*)(size_t)proxyId);
+
+	// Only moving proxies can pair with a static one.
+	QueryBounds(values);
+
+	++m_staticProxyCount;
+	++m_proxyCount;
+
+	for (int32 i = 0; i < m_queryResultCount; ++i)
+	{
+		b2Assert(m_proxyPool[m_queryResults[i]].IsValid());
+		m_pairManager.AddBufferedPair(proxyId, m_queryResults[i]);
+	}
+
+	m_pairManager.Commit();
+
+	// Prepare for next query.
+	m_queryResultCount = 0;
+	IncrementTimeStamp();
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+void b2SAPBroadPhase::DestroyStaticProxy(int32 proxyId)
+{
+	b2Proxy* proxy = m_proxyPool + proxyId;
+
+	b2BoundValues values;
+	b2GetStoredValues(proxy, &values);
+	QueryBounds(values);
+
+	for (int32 i = 0; i < m_queryResultCount; ++i)
+	{
+		b2Assert(m_proxyPool[m_queryResults[i]].IsValid());
+		m_pairManager.RemoveBufferedPair(proxyId, m_queryResults[i]);
+	}
+
+	m_pairManager.Commit();
+
+	// Prepare for next query.
+	m_queryResultCount = 0;
+	IncrementTimeStamp();
+
+	m_staticTree.DestroyProxy(proxy->staticNode);
+	proxy->staticNode = b2_nullNode;
+	--m_staticProxyCount;
+}
+
+// Static proxies may be repositioned by the user. Pairs are buffered for the
+// next commit like those of a moving proxy.
+void b2SAPBroadPhase::MoveStaticProxy(int32 proxyId, const b2BoundValues& newValues)
+{
+	b2Proxy* proxy = m_proxyPool + proxyId;
+
+	b2BoundValues oldValues;
+	b2GetStoredValues(proxy, &oldValues);
+
+	if (memcmp(&oldValues, &newValues, sizeof(b2BoundValues)) == 0)
+	{
+		return;
+	}
+
+	// Remove the pairs that are lost.
+	QueryBounds(oldValues);
+	for (int32 i = 0; i < m_queryResultCount; ++i)
+	{
+		b2Proxy* other = m_proxyPool + m_queryResults[i];
+		if (TestOverlap(newValues, other) == false)
+		{
+			m_pairManager.RemoveBufferedPair(proxyId, m_queryResults[i]);
+		}
+	}
+
+	m_queryResultCount = 0;
+	IncrementTimeStamp();
+
+	// Add the pairs that are gained.
+	QueryBounds(newValues);
+	for (int32 i = 0; i < m_queryResultCount; ++i)
+	{
+		b2Proxy* other = m_proxyPool + m_queryResults[i];
+		if (TestOverlap(oldValues, other) == false)
+		{
+			m_pairManager.AddBufferedPair(proxyId, m_queryResults[i]);
+		}
+	}
+
+	m_queryResultCount = 0;
+	IncrementTimeStamp();
+
+	b2SetStoredValues(proxy, newValues);
+
+	b2AABB aabb;
+	ComputeAABB(&aabb, newValues);
+	m_staticTree.MoveProxy(proxy->staticNode, aabb);
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+uint32 b2SAPBroadPhase::CreateProxy(const b2AABB& aabb, void* userData, bool isStatic)
+{
+	if (m_freeProxy == b2_nullProxy)
+	{
+		Grow();
+	}
+
+	b2Assert(m_proxyCount < m_proxyCapacity);
+	b2Assert(m_freeProxy != b2_nullProxy);
+
+	uint32 proxyId = m_freeProxy;
+	b2Proxy* proxy = m_proxyPool + proxyId;
+	m_freeProxy = proxy->GetNext();
+
+	proxy->overlapCount = 0;
+	proxy->staticNode = b2_nullNode;
+	proxy->userData = userData;
+
+	b2BoundValues values;
+	ComputeBounds(values.lowerValues, values.upperValues, aabb);
+
+	if (isStatic)
+	{
+		CreateStaticProxy(proxyId, values);
+		return proxyId;
+	}
+
+	if (m_batchDepth > 0)
+	{
+		proxy->overlapCount = b2_pending;
+		b2SetStoredValues(proxy, values);
+		m_pendingProxies[m_pendingProxyCount] = proxyId;
+		++m_pendingProxyCount;
+		++m_proxyCount;
+		return proxyId;
+	}
+
+	int32 boundCount = GetBoundCount();
+	const uint16* lowerValues = values.lowerValues;
+	const uint16* upperValues = values.upperValues;
+
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2Bound* bounds = m_bounds[axis];
+		int32 lowerIndex, upperIndex;
+		Query(&lowerIndex, &upperIndex, lowerValues[axis], upperValues[axis], bounds, boundCount, axis);
+
+		memmove(bounds + upperIndex + 2, bounds + upperIndex, (boundCount - upperIndex) * sizeof(b2Bound));
+		memmove(bounds + lowerIndex + 1, bounds + lowerIndex, (upperIndex - lowerIndex) * sizeof(b2Bound));
+
+		// The upper index has increased because of the lower bound insertion.
+		++upperIndex;
+
+		// Copy in the new bounds.
+		bounds[lowerIndex].value = lowerValues[axis];
+		bounds[lowerIndex].proxyId = proxyId;
+		bounds[upperIndex].value = upperValues[axis];
+		bounds[upperIndex].proxyId = proxyId;
+
+		bounds[lowerIndex].stabbingCount = lowerIndex == 0 ? 0 : bounds[lowerIndex-1].stabbingCount;
+		bounds[upperIndex].stabbingCount = bounds[upperIndex-1].stabbingCount;
+
+		// Adjust the stabbing count between the new bounds.
+		for (int32 index = lowerIndex; index < upperIndex; ++index)
+		{
+			++bounds[index].stabbingCount;
+		}
+
+		// Adjust the all the affected bound indices.
+		for (int32 index = lowerIndex; index < boundCount + 2; ++index)
+		{
+			b2Proxy* proxy = m_proxyPool + bounds[index].proxyId;
+			if (bounds[index].IsLower())
+			{
+				proxy->lowerBounds[axis] = (uint32)index;
+			}
+			else
+			{
+				proxy->upperBounds[axis] = (uint32)index;
+			}
+		}
+	}
+
+	++m_proxyCount;
+
+	b2Assert(m_queryResultCount < m_proxyCapacity);
+
+	// Create pairs if the AABB is in range.
+	for (int32 i = 0; i < m_queryResultCount; ++i)
+	{
+		b2Assert(m_queryResults[i] < uint32(m_proxyCapacity));
+		b2Assert(m_proxyPool[m_queryResults[i]].IsValid());
+
+		m_pairManager.AddBufferedPair(proxyId, m_queryResults[i]);
+	}
+
+	UpdateStaticPairs(proxyId, NULL, &values);
+
+	m_pairManager.Commit();
+
+	if (s_validate)
+	{
+		Validate();
+	}
+
+	// Prepare for next query.
+	m_queryResultCount = 0;
+	IncrementTimeStamp();
+
+	return proxyId;
+}
+
+void b2SAPBroadPhase::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 < m_proxyCount && m_proxyCount <= m_proxyCapacity);
+	b2Proxy* proxy = m_proxyPool + proxyId;
+	b2Assert(proxy->IsValid());
+
+	if (proxy->IsStatic())
+	{
+		DestroyStaticProxy(proxyId);
+	}
+	else if (proxy->IsPending())
+	{
+		DestroyPendingProxy(proxyId);
+	}
+	else
+	{
+		DestroyMovingProxy(proxyId);
+	}
+
+	// Return the proxy to the pool.
+	proxy->userData = NULL;
+	proxy->overlapCount = b2_invalid;
+	proxy->lowerBounds[0] = b2_invalid;
+	proxy->lowerBounds[1] = b2_invalid;
+	proxy->upperBounds[0] = b2_invalid;
+	proxy->upperBounds[1] = b2_invalid;
+
+	proxy->SetNext(m_freeProxy);
+	m_freeProxy = (uint32)proxyId;
+	--m_proxyCount;
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+void b2SAPBroadPhase::DestroyMovingProxy(int32 proxyId)
+{
+	b2Proxy* proxy = m_proxyPool + proxyId;
+
+	int32 boundCount = GetBoundCount();
+
+	b2BoundValues values;
+	GetBoundValues(proxy, &values);
+
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2Bound* bounds = m_bounds[axis];
+
+		int32 lowerIndex = proxy->lowerBounds[axis];
+		int32 upperIndex = proxy->upperBounds[axis];
+		uint16 lowerValue = bounds[lowerIndex].value;
+		uint16 upperValue = bounds[upperIndex].value;
+
+		memmove(bounds + lowerIndex, bounds + lowerIndex + 1, (upperIndex - lowerIndex - 1) * sizeof(b2Bound));
+		memmove(bounds + upperIndex-1, bounds + upperIndex + 1, (boundCount - upperIndex - 1) * sizeof(b2Bound));
+
+		// Fix bound indices.
+		for (int32 index = lowerIndex; index < boundCount - 2; ++index)
+		{
+			b2Proxy* proxy = m_proxyPool + bounds[index].proxyId;
+			if (bounds[index].IsLower())
+			{
+				proxy->lowerBounds[axis] = (uint32)index;
+			}
+			else
+			{
+				proxy->upperBounds[axis] = (uint32)index;
+			}
+		}
+
+		// Fix stabbing count.
+		for (int32 index = lowerIndex; index < upperIndex - 1; ++index)
+		{
+			--bounds[index].stabbingCount;
+		}
+
+		// Query for pairs to be removed. lowerIndex and upperIndex are not needed.
+		Query(&lowerIndex, &upperIndex, lowerValue, upperValue, bounds, boundCount - 2, axis);
+	}
+
+	b2Assert(m_queryResultCount < m_proxyCapacity);
+
+	for (int32 i = 0; i < m_queryResultCount; ++i)
+	{
+		b2Assert(m_proxyPool[m_queryResults[i]].IsValid());
+		m_pairManager.RemoveBufferedPair(proxyId, m_queryResults[i]);
+	}
+
+	UpdateStaticPairs(proxyId, &values, NULL);
+
+	m_pairManager.Commit();
+
+	// Prepare for next query.
+	m_queryResultCount = 0;
+	IncrementTimeStamp();
+}
+
+void b2SAPBroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb)
+{
+	if (proxyId == (int32)b2_nullProxy || m_proxyCapacity <= proxyId)
+	{
+		b2Assert(false);
+		return;
+	}
+
+	if (aabb.IsValid() == false)
+	{
+		b2Assert(false);
+		return;
+	}
+
+	int32 boundCount = GetBoundCount();
+
+	b2Proxy* proxy = m_proxyPool + proxyId;
+
+	// Get new bound values
+	b2BoundValues newValues;
+	ComputeBounds(newValues.lowerValues, newValues.upperValues, aabb);
+
+	if (proxy->IsStatic())
+	{
+		MoveStaticProxy(proxyId, newValues);
+		return;
+	}
+
+	if (proxy->IsPending())
+	{
+		b2SetStoredValues(proxy, newValues);
+		return;
+	}
+
+	// Get old bound values
+	b2BoundValues oldValues;
+	GetBoundValues(proxy, &oldValues);
+
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2Bound* bounds = m_bounds[axis];
+
+		int32 lowerIndex = proxy->lowerBounds[axis];
+		int32 upperIndex = proxy->upperBounds[axis];
+
+		uint16 lowerValue = newValues.lowerValues[axis];
+		uint16 upperValue = newValues.upperValues[axis];
+
+		int32 deltaLower = lowerValue - bounds[lowerIndex].value;
+		int32 deltaUpper = upperValue - bounds[upperIndex].value;
+
+		bounds[lowerIndex].value = lowerValue;
+		bounds[upperIndex].value = upperValue;
+
+		//
+		// Expanding adds overlaps
+		//
+
+		// Should we move the lower bound down?
+		if (deltaLower < 0)
+		{
+			int32 index = lowerIndex;
+			while (index > 0 && lowerValue < bounds[index-1].value)
+			{
+				b2Bound* bound = bounds + index;
+				b2Bound* prevBound = bound - 1;
+
+				int32 prevProxyId = prevBound->proxyId;
+				b2Proxy* prevProxy = m_proxyPool + prevBound->proxyId;
+
+				++prevBound->stabbingCount;
+
+				if (prevBound->IsUpper() == true)
+				{
+					if (TestOverlap(newValues, prevProxy))
+					{
+						m_pairManager.AddBufferedPair(proxyId, prevProxyId);
+					}
+
+					++prevProxy->upperBounds[axis];
+					++bound->stabbingCount;
+				}
+				else
+				{
+					++prevProxy->lowerBounds[axis];
+					--bound->stabbingCount;
+				}
+
+				--proxy->lowerBounds[axis];
+				b2Swap(*bound, *prevBound);
+				--index;
+			}
+		}
+
+		// Should we move the upper bound up?
+		if (deltaUpper > 0)
+		{
+			int32 index = upperIndex;
+			while (index < boundCount-1 && bounds[index+1].value <= upperValue)
+			{
+				b2Bound* bound = bounds + index;
+				b2Bound* nextBound = bound + 1;
+				int32 nextProxyId = nextBound->proxyId;
+				b2Proxy* nextProxy = m_proxyPool + nextProxyId;
+
+				++nextBound->stabbingCount;
+
+				if (nextBound->IsLower() == true)
+				{
+					if (TestOverlap(newValues, nextProxy))
+					{
+						m_pairManager.AddBufferedPair(proxyId, nextProxyId);
+					}
+
+					--nextProxy->lowerBounds[axis];
+					++bound->stabbingCount;
+				}
+				else
+				{
+					--nextProxy->upperBounds[axis];
+					--bound->stabbingCount;
+				}
+
+				++proxy->upperBounds[axis];
+				b2Swap(*bound, *nextBound);
+				++index;
+			}
+		}
+
+		//
+		// Shrinking removes overlaps
+		//
+
+		// Should we move the lower bound up?
+		if (deltaLower > 0)
+		{
+			int32 index = lowerIndex;
+			while (index < boundCount-1 && bounds[index+1].value <= lowerValue)
+			{
+				b2Bound* bound = bounds + index;
+				b2Bound* nextBound = bound + 1;
+
+				int32 nextProxyId = nextBound->proxyId;
+				b2Proxy* nextProxy = m_proxyPool + nextProxyId;
+
+				--nextBound->stabbingCount;
+
+				if (nextBound->IsUpper())
+				{
+					if (TestOverlap(oldValues, nextProxy))
+					{
+						m_pairManager.RemoveBufferedPair(proxyId, nextProxyId);
+					}
+
+					--nextProxy->upperBounds[axis];
+					--bound->stabbingCount;
+				}
+				else
+				{
+					--nextProxy->lowerBounds[axis];
+					++bound->stabbingCount;
+				}
+
+				++proxy->lowerBounds[axis];
+				b2Swap(*bound, *nextBound);
+				++index;
+			}
+		}
+
+		// Should we move the upper bound down?
+		if (deltaUpper < 0)
+		{
+			int32 index = upperIndex;
+			while (index > 0 && upperValue < bounds[index-1].value)
+			{
+				b2Bound* bound = bounds + index;
+				b2Bound* prevBound = bound - 1;
+
+				int32 prevProxyId = prevBound->proxyId;
+				b2Proxy* prevProxy = m_proxyPool + prevProxyId;
+
+				--prevBound->stabbingCount;
+
+				if (prevBound->IsLower() == true)
+				{
+					if (TestOverlap(oldValues, prevProxy))
+					{
+						m_pairManager.RemoveBufferedPair(proxyId, prevProxyId);
+					}
+
+					++prevProxy->lowerBounds[axis];
+					--bound->stabbingCount;
+				}
+				else
+				{
+					++prevProxy->upperBounds[axis];
+					++bound->stabbingCount;
+				}
+
+				--proxy->upperBounds[axis];
+				b2Swap(*bound, *prevBound);
+				--index;
+			}
+		}
+	}
+
+	UpdateStaticPairs(proxyId, &oldValues, &newValues);
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+void b2SAPBroadPhase::Commit()
+{
+	m_pairManager.Commit();
+}
+
+void b2SAPBroadPhase::BeginBatch()
+{
+	++m_batchDepth;
+}
+
+void b2SAPBroadPhase::EndBatch()
+{
+	b2Assert(m_batchDepth > 0);
+	--m_batchDepth;
+
+	if (m_batchDepth > 0 || m_pendingProxyCount == 0)
+	{
+		return;
+	}
+
+	InsertPendingProxies();
+
+	m_pairManager.Commit();
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+void b2SAPBroadPhase::InsertPendingProxies()
+{
+	int32 oldBoundCount = GetBoundCount();
+	int32 addedBoundCount = 2 * m_pendingProxyCount;
+	int32 boundCount = oldBoundCount + addedBoundCount;
+
+	b2Bound* added = (b2Bound*)b2Alloc(addedBoundCount * sizeof(b2Bound));
+
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2Bound* bounds = m_bounds[axis];
+
+		// Sort the new bounds. The values of this axis are still stored in the proxies.
+		for (int32 i = 0; i < m_pendingProxyCount; ++i)
+		{
+			const b2Proxy* proxy = m_proxyPool + m_pendingProxies[i];
+			added[2*i].value = (uint16)proxy->lowerBounds[axis];
+			added[2*i].proxyId = m_pendingProxies[i];
+			added[2*i+1].value = (uint16)proxy->upperBounds[axis];
+			added[2*i+1].proxyId = m_pendingProxies[i];
+		}
+
+		std::sort(added, added + addedBoundCount, b2BoundLess);
+
+		// Merge from the back, the bound arrays have room for all proxies.
+		int32 i = oldBoundCount - 1;
+		int32 j = addedBoundCount - 1;
+		for (int32 index = boundCount - 1; j >= 0; --index)
+		{
+			if (i >= 0 && bounds[i].value > added[j].value)
+			{
+				bounds[index] = bounds[i--];
+			}
+			else
+			{
+				bounds[index] = added[j--];
+			}
+		}
+
+		// Rebuild the bound indices and the stabbing counts.
+		uint32 stabbingCount = 0;
+		for (int32 index = 0; index < boundCount; ++index)
+		{
+			b2Proxy* proxy = m_proxyPool + bounds[index].proxyId;
+			if (bounds[index].IsLower())
+			{
+				proxy->lowerBounds[axis] = (uint32)index;
+				++stabbingCount;
+			}
+			else
+			{
+				proxy->upperBounds[axis] = (uint32)index;
+				--stabbingCount;
+			}
+			bounds[index].stabbingCount = stabbingCount;
+		}
+	}
+
+	b2Free(added);
+
+	// Sweep the x-axis once. Proxies whose x-intervals are open when a lower
+	// bound is reached overlap it on x, the y bound indices decide the rest.
+	// Pairs between old proxies are known already, so an old proxy only looks
+	// at the open pending proxies.
+	int32* active = (int32*)b2Alloc(4 * m_proxyCapacity * sizeof(int32));
+	int32* activePending = active + m_proxyCapacity;
+	int32* activeSlot = activePending + m_proxyCapacity;
+	int32* activePendingSlot = activeSlot + m_proxyCapacity;
+	int32 activeCount = 0;
+	int32 activePendingCount = 0;
+
+	const b2Bound* bounds = m_bounds[0];
+	for (int32 index = 0; index < boundCount; ++index)
+	{
+		int32 proxyId = bounds[index].proxyId;
+		const b2Proxy* proxy = m_proxyPool + proxyId;
+
+		if (bounds[index].IsUpper())
+		{
+			int32 slot = activeSlot[proxyId];
+			active[slot] = active[--activeCount];
+			activeSlot[active[slot]] = slot;
+
+			if (proxy->IsPending())
+			{
+				slot = activePendingSlot[proxyId];
+				activePending[slot] = activePending[--activePendingCount];
+				activePendingSlot[activePending[slot]] = slot;
+			}
+			continue;
+		}
+
+		const int32* candidates = proxy->IsPending() ? active : activePending;
+		int32 candidateCount = proxy->IsPending() ? activeCount : activePendingCount;
+		for (int32 i = 0; i < candidateCount; ++i)
+		{
+			const b2Proxy* other = m_proxyPool + candidates[i];
+			if (proxy->lowerBounds[1] < other->upperBounds[1] && other->lowerBounds[1] < proxy->upperBounds[1])
+			{
+				m_pairManager.AddBufferedPair(proxyId, candidates[i]);
+			}
+		}
+
+		activeSlot[proxyId] = activeCount;
+		active[activeCount++] = proxyId;
+
+		if (proxy->IsPending())
+		{
+			activePendingSlot[proxyId] = activePendingCount;
+			activePending[activePendingCount++] = proxyId;
+		}
+	}
+
+	b2Assert(activeCount == 0 && activePendingCount == 0);
+	b2Free(active);
+
+	// The pending proxies are regular moving proxies from now on.
+	int32 pendingCount = m_pendingProxyCount;
+	m_pendingProxyCount = 0;
+
+	for (int32 i = 0; i < pendingCount; ++i)
+	{
+		b2Proxy* proxy = m_proxyPool + m_pendingProxies[i];
+		proxy->overlapCount = 0;
+
+		b2BoundValues values;
+		GetBoundValues(proxy, &values);
+		UpdateStaticPairs(m_pendingProxies[i], NULL, &values);
+	}
+}
+
+void b2SAPBroadPhase::DestroyPendingProxy(int32 proxyId)
+{
+	// A pending proxy has no pairs yet.
+	for (int32 i = 0; i < m_pendingProxyCount; ++i)
+	{
+		if (m_pendingProxies[i] == uint32(proxyId))
+		{
+			m_pendingProxies[i] = m_pendingProxies[m_pendingProxyCount - 1];
+			--m_pendingProxyCount;
+			break;
+		}
+	}
+}
+
+int32 b2SAPBroadPhase::Query(const b2AABB& aabb, void** userData, int32 maxCount)
+{
+	b2BoundValues values;
+	ComputeBounds(values.lowerValues, values.upperValues, aabb);
+
+	QueryBounds(values);
+
+	int32 count = 0;
+	for (int32 i = 0; i < m_queryResultCount && count < maxCount; ++i, ++count)
+	{
+		b2Assert(m_queryResults[i] < uint32(m_proxyCapacity));
+		b2Proxy* proxy = m_proxyPool + m_queryResults[i];
+		b2Assert(proxy->IsValid());
+		userData[i] = proxy->userData;
+	}
+
+	// Prepare for next query.
+	m_queryResultCount = 0;
+	IncrementTimeStamp();
+
+	if (count < maxCount && m_staticProxyCount > 0)
+	{
+		b2StaticQueryCollector collector;
+		collector.broadPhase = this;
+		collector.values = values;
+		collector.userData = userData;
+		collector.count = count;
+		collector.maxCount = maxCount;
+
+		b2AABB staticAABB;
+		ComputeAABB(&staticAABB, values);
+		m_staticTree.Query(&collector, staticAABB);
+		count = collector.count;
+	}
+
+	return count;
+}
+
+void b2SAPBroadPhase::Validate()
+{
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2Bound* bounds = m_bounds[axis];
+
+		int32 boundCount = GetBoundCount();
+		uint32 stabbingCount = 0;
+
+		for (int32 i = 0; i < boundCount; ++i)
+		{
+			b2Bound* bound = bounds + i;
+			b2Assert(i == 0 || bounds[i-1].value <= bound->value);
+			b2Assert(bound->proxyId != b2_nullProxy);
+			b2Assert(m_proxyPool[bound->proxyId].IsValid());
+			b2Assert(m_proxyPool[bound->proxyId].IsStatic() == false);
+			b2Assert(m_proxyPool[bound->proxyId].IsPending() == false);
+
+			if (bound->IsLower() == true)
+			{
+				b2Assert(m_proxyPool[bound->proxyId].lowerBounds[axis] == uint32(i));
+				++stabbingCount;
+			}
+			else
+			{
+				b2Assert(m_proxyPool[bound->proxyId].upperBounds[axis] == uint32(i));
+				--stabbingCount;
+			}
+
+			b2Assert(bound->stabbingCount == stabbingCount);
+		}
+	}
+
+	m_staticTree.Validate();
+}
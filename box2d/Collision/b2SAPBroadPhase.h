@@ -0,0 +1,170 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SAP_BROAD_PHASE_H
+#define B2_SAP_BROAD_PHASE_H
+
+/*
+This broad phase uses the Sweep and Prune algorithm as described in:
+Collision Detection in Interactive 3D Environments by Gino van den Bergen
+Also, some ideas, such as using integral values for fast compares comes from
+Bullet (http:/www.bulletphysics.com).
+*/
+
+#include "b2BroadPhase.h"
+#include "b2DynamicTree.h"
+#include <climits>
+
+const uint32 b2_invalid = UINT_MAX;
+const uint32 b2_pending = UINT_MAX - 1;	// overlap count of a proxy waiting for EndBatch
+const uint32 b2_nullEdge = UINT_MAX;
+struct b2BoundValues;
+
+struct b2Bound
+{
+	bool IsLower() const { return (value & 1) == 0; }
+	bool IsUpper() const { return (value & 1) == 1; }
+
+	uint16 value;
+	uint32 proxyId;
+	uint32 stabbingCount;
+};
+
+struct b2Proxy
+{
+	uint32 GetNext() const { return lowerBounds[0]; }
+	void SetNext(uint32 next) { lowerBounds[0] = next; }
+	bool IsValid() const { return overlapCount != b2_invalid; }
+	bool IsStatic() const { return staticNode != b2_nullNode; }
+	bool IsPending() const { return overlapCount == b2_pending; }
+
+	// Bound indices. Static and pending proxies are not in the bound arrays,
+	// they keep their quantized bound values here instead.
+	uint32 lowerBounds[2], upperBounds[2];
+	uint32 overlapCount;
+	uint16 timeStamp;
+	int32 staticNode;	// node in the static tree, b2_nullNode for moving proxies
+	void* userData;
+};
+
+class b2SAPBroadPhase : public b2BroadPhase
+{
+public:
+	b2SAPBroadPhase(const b2AABB& worldAABB, b2PairCallback* callback);
+	~b2SAPBroadPhase();
+
+	uint32 CreateProxy(const b2AABB& aabb, void* userData, bool isStatic);
+	void DestroyProxy(int32 proxyId);
+
+	void MoveProxy(int32 proxyId, const b2AABB& aabb);
+	void Commit();
+
+	void BeginBatch();
+	void EndBatch();
+
+	// Get a single proxy. Returns NULL if the id is invalid.
+	b2Proxy* GetProxy(int32 proxyId);
+
+	int32 Query(const b2AABB& aabb, void** userData, int32 maxCount);
+
+	bool IsValidProxy(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	bool TestOverlap(int32 proxyId1, int32 proxyId2) const;
+
+	void Validate();
+	void ValidatePairs();
+
+private:
+	void ComputeBounds(uint16* lowerValues, uint16* upperValues, const b2AABB& aabb);
+	void ComputeAABB(b2AABB* aabb, const b2BoundValues& values) const;
+
+	bool TestOverlap(const b2Proxy* p1, const b2Proxy* p2) const;
+	bool TestOverlap(const b2BoundValues& b, b2Proxy* p);
+
+	void Query(int32* lowerIndex, int32* upperIndex, uint16 lowerValue, uint16 upperValue,
+				b2Bound* bounds, int32 boundCount, int32 axis);
+	void QueryBounds(const b2BoundValues& values);
+	void IncrementOverlapCount(int32 proxyId);
+	void IncrementTimeStamp();
+
+	// Static proxies live in the static tree, so moving proxies never shift
+	// bounds past them and static pairs with each other are never created.
+	void CreateStaticProxy(int32 proxyId, const b2BoundValues& values);
+	void DestroyStaticProxy(int32 proxyId);
+	void DestroyMovingProxy(int32 proxyId);
+	void MoveStaticProxy(int32 proxyId, const b2BoundValues& newValues);
+
+	// Add and remove pairs of a moving proxy with the static proxies. Pass
+	// NULL old values for a new proxy and NULL new values for a destroyed one.
+	void UpdateStaticPairs(int32 proxyId, const b2BoundValues* oldValues, const b2BoundValues* newValues);
+
+	// Merge the pending proxies into the bound arrays and find their pairs
+	// with one sweep.
+	void InsertPendingProxies();
+	void DestroyPendingProxy(int32 proxyId);
+
+	void GetBoundValues(const b2Proxy* proxy, b2BoundValues* values) const;
+	int32 GetBoundCount() const { return 2 * (m_proxyCount - m_staticProxyCount - m_pendingProxyCount); }
+
+	// Doubles proxy, bound and query result storage. Invalidates proxy pointers.
+	void Grow();
+
+public:
+	b2PairManager m_pairManager;
+
+	b2Proxy* m_proxyPool;
+	uint32 m_freeProxy;
+	int32 m_proxyCapacity;
+
+	b2Bound* m_bounds[2];		// 2 * m_proxyCapacity each
+
+	uint32* m_queryResults;		// m_proxyCapacity
+	int32 m_queryResultCount;
+
+	b2Vec2 m_quantizationFactor;
+	uint16 m_timeStamp;
+
+	b2DynamicTree m_staticTree;
+	int32 m_staticProxyCount;
+
+	uint32* m_pendingProxies;	// m_proxyCapacity
+	int32 m_pendingProxyCount;
+	int32 m_batchDepth;
+};
+
+inline b2Proxy* b2SAPBroadPhase::GetProxy(int32 proxyId)
+{
+	if (proxyId == (int32)b2_nullProxy || m_proxyCapacity <= proxyId || m_proxyPool[proxyId].IsValid() == false)
+	{
+		return NULL;
+	}
+
+	return m_proxyPool + proxyId;
+}
+
+inline bool b2SAPBroadPhase::IsValidProxy(int32 proxyId) const
+{
+	return 0 <= proxyId && proxyId < m_proxyCapacity && m_proxyPool[proxyId].IsValid();
+}
+
+inline void* b2SAPBroadPhase::GetUserData(int32 proxyId) const
+{
+	return m_proxyPool[proxyId].userData;
+}
+
+#endif
\ No newline at end of file
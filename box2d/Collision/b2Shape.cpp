@@ -298,7 +298,7 @@ b2CircleShape::b2CircleShape(const b2ShapeDef* def, b2Body* body, const b2Vec2&
 	b2BroadPhase* broadPhase = m_body->m_world->m_broadPhase;
 	if (broadPhase->InRange(aabb))
 	{
-		m_proxyId = broadPhase->CreateProxy(aabb, this);
+		m_proxyId = broadPhase->CreateProxy(aabb, this, m_body->IsStatic());
 	}
 	else
 	{
@@ -369,10 +369,7 @@ void b2CircleShape::ResetProxy(b2BroadPhase* broadPhase)
 		return;
 	}
 
-	b2Proxy* proxy = broadPhase->GetProxy(m_proxyId);
-
 	broadPhase->DestroyProxy(m_proxyId);
-	proxy = NULL;
 
 	b2AABB aabb;
 	aabb.minVertex.Set(m_position.x - m_radius, m_position.y - m_radius);
@@ -380,7 +377,7 @@ void b2CircleShape::ResetProxy(b2BroadPhase* broadPhase)
 
 	if (broadPhase->InRange(aabb))
 	{
-		m_proxyId = broadPhase->CreateProxy(aabb, this);
+		m_proxyId = broadPhase->CreateProxy(aabb, this, m_body->IsStatic());
 	}
 	else
 	{
@@ -497,7 +494,7 @@ b2PolyShape::b2PolyShape(const b2ShapeDef* def, b2Body* body,
 	b2BroadPhase* broadPhase = m_body->m_world->m_broadPhase;
 	if (broadPhase->InRange(aabb))
 	{
-		m_proxyId = broadPhase->CreateProxy(aabb, this);
+		m_proxyId = broadPhase->CreateProxy(aabb, this, m_body->IsStatic());
 	}
 	else
 	{
@@ -567,18 +564,7 @@ b2Vec2 b2PolyShape::Support(const b2Vec2& d) const
 {
 	b2Vec2 dLocal = b2MulT(m_R, d);
 
-	int32 bestIndex = 0;
-	float32 bestValue = b2Dot(m_coreVertices[0], dLocal);
-	for (int32 i = 1; i < m_vertexCount; ++i)
-	{
-		float32 value = b2Dot(m_coreVertices[i], dLocal);
-		if (value > bestValue)
-		{
-			bestIndex = i;
-			bestValue = value;
-		}
-	}
-
+	int32 bestIndex = b2FindMaxVertex(m_coreVertices, m_vertexCount, dLocal);
 	return m_position + b2Mul(m_R, m_coreVertices[bestIndex]);
 }
 
@@ -605,10 +591,7 @@ void b2PolyShape::ResetProxy(b2BroadPhase* broadPhase)
 		return;
 	}
 
-	b2Proxy* proxy = broadPhase->GetProxy(m_proxyId);
-
 	broadPhase->DestroyProxy(m_proxyId);
-	proxy = NULL;
 
 	b2Mat22 R = b2Mul(m_R, m_localOBB.R);
 	b2Mat22 absR = b2Abs(R);
@@ -620,7 +603,7 @@ void b2PolyShape::ResetProxy(b2BroadPhase* broadPhase)
 
 	if (broadPhase->InRange(aabb))
 	{
-		m_proxyId = broadPhase->CreateProxy(aabb, this);
+		m_proxyId = broadPhase->CreateProxy(aabb, this, m_body->IsStatic());
 	}
 	else
 	{
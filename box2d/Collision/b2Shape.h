@@ -181,7 +181,7 @@ public:
 
 	float32 m_maxRadius;
 
-	uint16 m_proxyId;
+	uint32 m_proxyId;
 	uint16 m_categoryBits;
 	uint16 m_maskBits;
 	int16 m_groupIndex;
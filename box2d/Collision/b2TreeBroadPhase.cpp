@@ -0,0 +1,429 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "b2TreeBroadPhase.h"
+#include <memory.h>
+
+// Collects user data of proxies overlapping a query AABB.
+struct b2TreeQueryCollector
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		// Proxies of an open batch are not inserted yet.
+		if (broadPhase->IsBatchedProxy(proxyId))
+		{
+			return true;
+		}
+
+		if (count == maxCount)
+		{
+			return false;
+		}
+
+		userData[count++] = broadPhase->GetUserData(proxyId);
+		return true;
+	}
+
+	const b2TreeBroadPhase* broadPhase;
+	void** userData;
+	int32 maxCount;
+	int32 count;
+};
+
+b2TreeBroadPhase::b2TreeBroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
+	: b2BroadPhase(worldAABB)
+{
+	m_pairManager.Initialize(this, callback);
+
+	m_moveCapacity = 16;
+	m_moveCount = 0;
+	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+
+	m_queryProxyId = b2_nullNode;
+	m_queryStamp = 0;
+	m_batchDepth = 0;
+
+	m_proxies = NULL;
+	m_proxyCapacity = 0;
+
+	m_links = NULL;
+	m_linkCapacity = 0;
+	m_freeLink = b2_nullNode;
+}
+
+b2TreeBroadPhase::~b2TreeBroadPhase()
+{
+	b2Free(m_moveBuffer);
+	b2Free(m_proxies);
+	b2Free(m_links);
+}
+
+uint32 b2TreeBroadPhase::CreateProxy(const b2AABB& aabb, void* userData, bool isStatic)
+{
+	b2Assert(aabb.IsValid());
+
+	// Fatten the AABB, so small movements do not touch the tree. Static
+	// proxies rarely move and keep a tight AABB.
+	b2AABB fatAABB = aabb;
+	if (isStatic == false)
+	{
+		b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+		fatAABB.minVertex = aabb.minVertex - r;
+		fatAABB.maxVertex = aabb.maxVertex + r;
+	}
+
+	int32 proxyId = m_tree.CreateProxy(fatAABB, userData);
+	GrowProxies(proxyId);
+	b2TreeProxy* proxy = m_proxies + proxyId;
+	proxy->pairList = b2_nullNode;
+	proxy->queryStamp = 0;
+	proxy->isStatic = isStatic;
+	proxy->isBatched = m_batchDepth > 0;
+	++m_proxyCount;
+
+	// Pairs of the batch are found together by EndBatch.
+	if (m_batchDepth > 0)
+	{
+		BufferMove(proxyId);
+		return uint32(proxyId);
+	}
+
+	// Find pairs of the new proxy now, like the sweep and prune does.
+	NextQueryStamp();
+	m_queryProxyId = proxyId;
+	m_tree.Query(this, fatAABB);
+	m_queryProxyId = b2_nullNode;
+
+	m_pairManager.Commit();
+
+	if (s_validate)
+	{
+		Validate();
+	}
+
+	return uint32(proxyId);
+}
+
+void b2TreeBroadPhase::DestroyProxy(int32 proxyId)
+{
+	b2Assert(m_tree.IsProxy(proxyId));
+
+	// Pairs of moved proxies may be stale until the next commit, so take
+	// the pairs from the pair list, not from a query of the tree.
+	while (m_proxies[proxyId].pairList != b2_nullNode)
+	{
+		RemovePair(proxyId, m_links[m_proxies[proxyId].pairList].proxyId);
+	}
+
+	m_pairManager.Commit();
+
+	UnBufferMove(proxyId);
+	m_tree.DestroyProxy(proxyId);
+	--m_proxyCount;
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+void b2TreeBroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb)
+{
+	if (m_tree.IsProxy(proxyId) == false || aabb.IsValid() == false)
+	{
+		b2Assert(false);
+		return;
+	}
+
+	if (b2Contains(m_tree.GetAABB(proxyId), aabb))
+	{
+		return;
+	}
+
+	// Static proxies keep a tight AABB, as in CreateProxy.
+	b2AABB fatAABB = aabb;
+	if (IsStaticProxy(proxyId) == false)
+	{
+		b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+		fatAABB.minVertex = aabb.minVertex - r;
+		fatAABB.maxVertex = aabb.maxVertex + r;
+	}
+
+	m_tree.MoveProxy(proxyId, fatAABB);
+	BufferMove(proxyId);
+}
+
+void b2TreeBroadPhase::Commit()
+{
+	// Bodies placed during a batch commit too. Leave the move buffer to EndBatch.
+	if (m_batchDepth == 0)
+	{
+		UpdatePairs();
+	}
+
+	m_pairManager.Commit();
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+void b2TreeBroadPhase::BeginBatch()
+{
+	++m_batchDepth;
+}
+
+void b2TreeBroadPhase::EndBatch()
+{
+	b2Assert(m_batchDepth > 0);
+	--m_batchDepth;
+
+	if (m_batchDepth == 0)
+	{
+		Commit();
+	}
+}
+
+void b2TreeBroadPhase::UpdatePairs()
+{
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		int32 proxyId = m_moveBuffer[i];
+		if (proxyId == b2_nullNode)
+		{
+			continue;
+		}
+
+		m_proxies[proxyId].isBatched = false;
+
+		// Remove pairs that separated. Pairs only separate when one of
+		// their proxies moved, so only the pairs of moved proxies are tested.
+		// The query below skips the other proxies of the remaining pairs.
+		NextQueryStamp();
+		int32 link = m_proxies[proxyId].pairList;
+		while (link != b2_nullNode)
+		{
+			int32 otherId = m_links[link].proxyId;
+			link = m_links[link].next;
+
+			if (TestOverlap(proxyId, otherId) == false)
+			{
+				RemovePair(proxyId, otherId);
+			}
+			else
+			{
+				m_proxies[otherId].queryStamp = m_queryStamp;
+			}
+		}
+
+		// Add new pairs of the moved proxy.
+		m_queryProxyId = proxyId;
+		m_tree.Query(this, m_tree.GetAABB(proxyId));
+	}
+	m_queryProxyId = b2_nullNode;
+
+	m_moveCount = 0;
+}
+
+bool b2TreeBroadPhase::QueryCallback(int32 proxyId)
+{
+	if (proxyId != m_queryProxyId && m_proxies[proxyId].queryStamp != m_queryStamp &&
+		(IsStaticProxy(proxyId) == false || IsStaticProxy(m_queryProxyId) == false))
+	{
+		AddPair(m_queryProxyId, proxyId);
+	}
+
+	// Continue the query.
+	return true;
+}
+
+int32 b2TreeBroadPhase::Query(const b2AABB& aabb, void** userData, int32 maxCount)
+{
+	b2TreeQueryCollector collector;
+	collector.broadPhase = this;
+	collector.userData = userData;
+	collector.maxCount = maxCount;
+	collector.count = 0;
+
+	m_tree.Query(&collector, aabb);
+
+	return collector.count;
+}
+
+// The pair must not exist yet.
+void b2TreeBroadPhase::AddPair(int32 proxyId1, int32 proxyId2)
+{
+	m_pairManager.AddBufferedPair(proxyId1, proxyId2);
+	Link(proxyId1, proxyId2);
+	Link(proxyId2, proxyId1);
+}
+
+void b2TreeBroadPhase::RemovePair(int32 proxyId1, int32 proxyId2)
+{
+	m_pairManager.RemoveBufferedPair(proxyId1, proxyId2);
+	Unlink(proxyId1, proxyId2);
+	Unlink(proxyId2, proxyId1);
+}
+
+bool b2TreeBroadPhase::HasLink(int32 proxyId, int32 otherId) const
+{
+	for (int32 link = m_proxies[proxyId].pairList; link != b2_nullNode; link = m_links[link].next)
+	{
+		if (m_links[link].proxyId == otherId)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void b2TreeBroadPhase::NextQueryStamp()
+{
+	++m_queryStamp;
+
+	// Clear stale stamps when the counter wraps around.
+	if (m_queryStamp == 0)
+	{
+		for (int32 i = 0; i < m_proxyCapacity; ++i)
+		{
+			m_proxies[i].queryStamp = 0;
+		}
+		m_queryStamp = 1;
+	}
+}
+
+void b2TreeBroadPhase::Link(int32 proxyId, int32 otherId)
+{
+	if (m_freeLink == b2_nullNode)
+	{
+		int32 oldCapacity = m_linkCapacity;
+		m_linkCapacity = oldCapacity == 0 ? 2 * b2_initialPairCapacity : 2 * oldCapacity;
+
+		b2TreePairLink* links = (b2TreePairLink*)b2Alloc(m_linkCapacity * sizeof(b2TreePairLink));
+		if (m_links)
+		{
+			memcpy(links, m_links, oldCapacity * sizeof(b2TreePairLink));
+			b2Free(m_links);
+		}
+		m_links = links;
+
+		for (int32 i = oldCapacity; i < m_linkCapacity - 1; ++i)
+		{
+			m_links[i].next = i + 1;
+		}
+		m_links[m_linkCapacity - 1].next = b2_nullNode;
+		m_freeLink = oldCapacity;
+	}
+
+	int32 link = m_freeLink;
+	m_freeLink = m_links[link].next;
+
+	m_links[link].proxyId = otherId;
+	m_links[link].next = m_proxies[proxyId].pairList;
+	m_proxies[proxyId].pairList = link;
+}
+
+void b2TreeBroadPhase::Unlink(int32 proxyId, int32 otherId)
+{
+	int32* node = &m_proxies[proxyId].pairList;
+	while (*node != b2_nullNode)
+	{
+		int32 link = *node;
+		if (m_links[link].proxyId == otherId)
+		{
+			*node = m_links[link].next;
+			m_links[link].next = m_freeLink;
+			m_freeLink = link;
+			return;
+		}
+
+		node = &m_links[link].next;
+	}
+
+	b2Assert(false);
+}
+
+void b2TreeBroadPhase::BufferMove(int32 proxyId)
+{
+	if (m_moveCount == m_moveCapacity)
+	{
+		int32* oldBuffer = m_moveBuffer;
+		m_moveCapacity *= 2;
+		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+		memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(int32));
+		b2Free(oldBuffer);
+	}
+
+	m_moveBuffer[m_moveCount] = proxyId;
+	++m_moveCount;
+}
+
+void b2TreeBroadPhase::UnBufferMove(int32 proxyId)
+{
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		if (m_moveBuffer[i] == proxyId)
+		{
+			m_moveBuffer[i] = b2_nullNode;
+		}
+	}
+}
+
+void b2TreeBroadPhase::GrowProxies(int32 proxyId)
+{
+	if (proxyId < m_proxyCapacity)
+	{
+		return;
+	}
+
+	// Proxy ids are node indices, so grow like the node pool does.
+	int32 newCapacity = b2Max(2 * m_proxyCapacity, proxyId + 1);
+	b2TreeProxy* proxies = (b2TreeProxy*)b2Alloc(newCapacity * sizeof(b2TreeProxy));
+	if (m_proxies)
+	{
+		memcpy(proxies, m_proxies, m_proxyCapacity * sizeof(b2TreeProxy));
+		b2Free(m_proxies);
+	}
+	m_proxies = proxies;
+	m_proxyCapacity = newCapacity;
+}
+
+void b2TreeBroadPhase::Validate()
+{
+	m_tree.Validate();
+
+#ifdef _DEBUG
+	// Both proxies of a pair are linked to each other.
+	for (int32 proxyId = 0; proxyId < m_proxyCapacity; ++proxyId)
+	{
+		if (m_tree.IsProxy(proxyId) == false)
+		{
+			continue;
+		}
+
+		for (int32 link = m_proxies[proxyId].pairList; link != b2_nullNode; link = m_links[link].next)
+		{
+			b2Assert(m_tree.IsProxy(m_links[link].proxyId));
+			b2Assert(HasLink(m_links[link].proxyId, proxyId));
+		}
+	}
+#endif
+}
@@ -0,0 +1,144 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_TREE_BROAD_PHASE_H
+#define B2_TREE_BROAD_PHASE_H
+
+#include "b2BroadPhase.h"
+#include "b2DynamicTree.h"
+
+// Per proxy data, indexed by proxy id.
+struct b2TreeProxy
+{
+	int32 pairList;		// first link of the pairs of this proxy
+	uint32 queryStamp;	// equals m_queryStamp if paired with the querying proxy
+	bool isStatic;		// static proxies are not paired with each other
+	bool isBatched;		// created in an open batch and not inserted yet
+};
+
+// Every pair is linked into the pair lists of both its proxies, so moved and
+// destroyed proxies find their pairs without a search of the pair table.
+struct b2TreePairLink
+{
+	int32 proxyId;		// the other proxy of the pair
+	int32 next;
+};
+
+// Broad-phase keeping fattened proxy AABBs in a dynamic AABB tree. A proxy
+// whose AABB stays inside its fattened AABB is not touched when it moves,
+// and pairs are only updated for proxies that left their fattened AABB.
+// Unlike sweep and prune, the cost does not depend on how many proxies
+// move together along one axis.
+class b2TreeBroadPhase : public b2BroadPhase
+{
+public:
+	b2TreeBroadPhase(const b2AABB& worldAABB, b2PairCallback* callback);
+	~b2TreeBroadPhase();
+
+	uint32 CreateProxy(const b2AABB& aabb, void* userData, bool isStatic);
+	void DestroyProxy(int32 proxyId);
+
+	void MoveProxy(int32 proxyId, const b2AABB& aabb);
+	void Commit();
+
+	void BeginBatch();
+	void EndBatch();
+
+	int32 Query(const b2AABB& aabb, void** userData, int32 maxCount);
+
+	bool IsValidProxy(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	bool TestOverlap(int32 proxyId1, int32 proxyId2) const;
+
+	void Validate();
+
+	// Called by the tree during pair queries.
+	bool QueryCallback(int32 proxyId);
+
+	// Proxies created in an open batch are skipped by Query.
+	bool IsBatchedProxy(int32 proxyId) const;
+
+private:
+	void BufferMove(int32 proxyId);
+	void UnBufferMove(int32 proxyId);
+
+	bool IsStaticProxy(int32 proxyId) const;
+	void GrowProxies(int32 proxyId);
+
+	// Buffer a pair in the pair manager and keep the pair lists in step.
+	void AddPair(int32 proxyId1, int32 proxyId2);
+	void RemovePair(int32 proxyId1, int32 proxyId2);
+
+	bool HasLink(int32 proxyId, int32 otherId) const;
+	void NextQueryStamp();
+	void Link(int32 proxyId, int32 otherId);
+	void Unlink(int32 proxyId, int32 otherId);
+
+	// Buffers removal of pairs of the moved proxies whose fattened AABBs no
+	// longer overlap, and addition of their new pairs.
+	void UpdatePairs();
+
+public:
+	b2DynamicTree m_tree;
+	b2PairManager m_pairManager;
+
+	int32* m_moveBuffer;
+	int32 m_moveCapacity;
+	int32 m_moveCount;
+
+	int32 m_queryProxyId;
+	uint32 m_queryStamp;
+	int32 m_batchDepth;		// new proxies only go to the move buffer while > 0
+
+	b2TreeProxy* m_proxies;
+	int32 m_proxyCapacity;
+
+	b2TreePairLink* m_links;
+	int32 m_linkCapacity;
+	int32 m_freeLink;
+};
+
+inline bool b2TreeBroadPhase::IsValidProxy(int32 proxyId) const
+{
+	return m_tree.IsProxy(proxyId);
+}
+
+inline void* b2TreeBroadPhase::GetUserData(int32 proxyId) const
+{
+	return m_tree.GetUserData(proxyId);
+}
+
+inline bool b2TreeBroadPhase::IsStaticProxy(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].isStatic;
+}
+
+inline bool b2TreeBroadPhase::IsBatchedProxy(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].isBatched;
+}
+
+inline bool b2TreeBroadPhase::TestOverlap(int32 proxyId1, int32 proxyId2) const
+{
+	return b2TestOverlap(m_tree.GetAABB(proxyId1), m_tree.GetAABB(proxyId2));
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_VERTEX_SEARCH_H
+#define B2_VERTEX_SEARCH_H
+
+// Scalar and SIMD kernels behind b2FindMaxVertex and b2FindMinVertex. They are
+// in a header so tools can check both against each other.
+
+#include "../Common/b2Settings.h"
+#include "../Common/b2Math.h"
+#include <float.h>
+
+// The SIMD vertex search needs SSE2, which every x86-64 target has.
+#if !defined(B2_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define B2_SIMD_COLLISION
+#include <emmintrin.h>
+#endif
+
+// Polygons with fewer vertices are searched by the scalar loop. Measured with
+// vertexsearchtest, the SIMD search takes about 6.5 ns for any count, the
+// scalar loop 3.6, 5.2 and 5.0 ns for three to five vertices and 6-11 ns for
+// six, growing to 9-15 ns for eight, depending on how well its branch predicts.
+const int32 b2_minSimdVertices = 6;
+
+inline int32 b2FindMaxVertexScalar(const b2Vec2* vertices, int32 count, const b2Vec2& d)
+{
+	int32 bestIndex = 0;
+	float32 maxDot = -FLT_MAX;
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 dot = b2Dot(vertices[i], d);
+		if (dot > maxDot)
+		{
+			maxDot = dot;
+			bestIndex = i;
+		}
+	}
+
+	return bestIndex;
+}
+
+inline int32 b2FindMinVertexScalar(const b2Vec2* vertices, int32 count, const b2Vec2& d)
+{
+	int32 bestIndex = 0;
+	float32 minDot = FLT_MAX;
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 dot = b2Dot(vertices[i], d);
+		if (dot < minDot)
+		{
+			minDot = dot;
+			bestIndex = i;
+		}
+	}
+
+	return bestIndex;
+}
+
+#ifdef B2_SIMD_COLLISION
+
+// Projects four vertices onto d, computed like b2Dot so the results match the scalar search.
+inline __m128 b2ProjectVertices(const b2Vec2* vertices, __m128 dX, __m128 dY)
+{
+	// Deinterleave x0 y0 x1 y1 | x2 y2 x3 y3 into the x and y lanes.
+	__m128 v01 = _mm_loadu_ps(&vertices[0].x);
+	__m128 v23 = _mm_loadu_ps(&vertices[2].x);
+	__m128 x = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 y = _mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1));
+	return _mm_add_ps(_mm_mul_ps(x, dX), _mm_mul_ps(y, dY));
+}
+
+// Searches up to eight vertices in two groups of four lanes. Lanes past the
+// vertex count hold a padding value that never wins. The vertex array is read
+// up to b2_maxPolyVertices, like polygon shapes store it.
+template <bool findMax>
+inline int32 b2FindExtremeVertexSIMD(const b2Vec2* vertices, int32 count, const b2Vec2& d)
+{
+	b2Assert(0 < count && count <= b2_maxPolyVertices && count <= 8);
+
+	__m128 dX = _mm_set1_ps(d.x);
+	__m128 dY = _mm_set1_ps(d.y);
+	__m128 pad = _mm_set1_ps(findMax ? -FLT_MAX : FLT_MAX);
+
+	__m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i countLanes = _mm_set1_epi32(count);
+	__m128 dot0 = b2ProjectVertices(vertices, dX, dY);
+	__m128 dot1 = b2ProjectVertices(vertices + 4, dX, dY);
+	__m128 valid1 = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_add_epi32(lanes, _mm_set1_epi32(4)), countLanes));
+	dot1 = _mm_or_ps(_mm_and_ps(valid1, dot1), _mm_andnot_ps(valid1, pad));
+	if (count < 4)
+	{
+		__m128 valid0 = _mm_castsi128_ps(_mm_cmplt_epi32(lanes, countLanes));
+		dot0 = _mm_or_ps(_mm_and_ps(valid0, dot0), _mm_andnot_ps(valid0, pad));
+	}
+
+	// Clamp to the padding. max and min return their second operand for NaN,
+	// so NaN projections become padding and never win, as in the scalar search.
+	dot0 = findMax ? _mm_max_ps(dot0, pad) : _mm_min_ps(dot0, pad);
+	dot1 = findMax ? _mm_max_ps(dot1, pad) : _mm_min_ps(dot1, pad);
+
+	// Spread the extreme value over all lanes.
+	__m128 best = findMax ? _mm_max_ps(dot0, dot1) : _mm_min_ps(dot0, dot1);
+	__m128 swapped = _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2));
+	best = findMax ? _mm_max_ps(best, swapped) : _mm_min_ps(best, swapped);
+	swapped = _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1));
+	best = findMax ? _mm_max_ps(best, swapped) : _mm_min_ps(best, swapped);
+
+	int32 mask = _mm_movemask_ps(_mm_cmpeq_ps(dot0, best)) | (_mm_movemask_ps(_mm_cmpeq_ps(dot1, best)) << 4);
+
+	// Index of the lowest set bit without branches, a bit scan loop mispredicts.
+	// Gives 0 when no projection beats the padding, as in the scalar search:
+	// the first lane is clamped to the padding then, so it matches.
+	mask &= -mask;
+	return ((mask & 0xaa) != 0) | (((mask & 0xcc) != 0) << 1) | (((mask & 0xf0) != 0) << 2);
+}
+
+#endif
+
+#endif
@@ -41,6 +41,17 @@ int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] =
 uint8 b2BlockAllocator::s_blockSizeLookup[b2_maxBlockSize + 1];
 bool b2BlockAllocator::s_blockSizeLookupInitialized;
 
+// Fills the lookup table during static initialization, before any thread can create a world.
+struct b2BlockSizeLookupInitializer
+{
+	b2BlockSizeLookupInitializer()
+	{
+		b2BlockAllocator::InitializeBlockSizeLookup();
+	}
+};
+
+static b2BlockSizeLookupInitializer s_blockSizeLookupInitializer;
+
 struct b2Chunk
 {
 	int32 blockSize;
@@ -62,7 +73,15 @@ b2BlockAllocator::b2BlockAllocator()
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_liveBlockCounts, 0, sizeof(m_liveBlockCounts));
+	memset(m_allocationCounts, 0, sizeof(m_allocationCounts));
 
+	// Already done by static initializer, unless allocator is created during static initialization.
+	InitializeBlockSizeLookup();
+}
+
+void b2BlockAllocator::InitializeBlockSizeLookup()
+{
 	if (s_blockSizeLookupInitialized == false)
 	{
 		int32 j = 0;
@@ -104,6 +123,9 @@ void* b2BlockAllocator::Allocate(int32 size)
 	int32 index = s_blockSizeLookup[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
+	++m_liveBlockCounts[index];
+	++m_allocationCounts[index];
+
 	if (m_freeLists[index])
 	{
 		b2Block* block = m_freeLists[index];
@@ -159,6 +181,9 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	int32 index = s_blockSizeLookup[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
+	b2Assert(m_liveBlockCounts[index] > 0);
+	--m_liveBlockCounts[index];
+
 #ifdef _DEBUG
 	// Verify the memory address and size is valid.
 	int32 blockSize = s_blockSizes[index];
@@ -202,4 +227,33 @@ void b2BlockAllocator::Clear()
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_liveBlockCounts, 0, sizeof(m_liveBlockCounts));
+}
+
+int32 b2BlockAllocator::GetBlockSize(int32 sizeClass)
+{
+	b2Assert(0 <= sizeClass && sizeClass < b2_blockSizes);
+	return s_blockSizes[sizeClass];
+}
+
+int32 b2BlockAllocator::GetLiveBlockCount(int32 sizeClass) const
+{
+	b2Assert(0 <= sizeClass && sizeClass < b2_blockSizes);
+	return m_liveBlockCounts[sizeClass];
+}
+
+int32 b2BlockAllocator::GetAllocationCount(int32 sizeClass) const
+{
+	b2Assert(0 <= sizeClass && sizeClass < b2_blockSizes);
+	return m_allocationCounts[sizeClass];
+}
+
+int32 b2BlockAllocator::GetChunkCount() const
+{
+	return m_chunkCount;
+}
+
+int32 b2BlockAllocator::GetReservedBytes() const
+{
+	return m_chunkCount * b2_chunkSize + m_chunkSpace * (int32)sizeof(b2Chunk);
 }
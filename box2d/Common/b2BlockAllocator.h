@@ -32,6 +32,8 @@ struct b2Chunk;
 // This is a small block allocator used for allocating small
 // objects that persist for more than one time step.
 // See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
+// It is not thread-safe. Each world has its own, and the parallel parts of
+// a step do not allocate blocks.
 class b2BlockAllocator
 {
 public:
@@ -43,6 +45,14 @@ public:
 
 	void Clear();
 
+	// Statistics, to measure the churn of contacts and other objects.
+	// Size classes are 0 to b2_blockSizes - 1.
+	static int32 GetBlockSize(int32 sizeClass);
+	int32 GetLiveBlockCount(int32 sizeClass) const;
+	int32 GetAllocationCount(int32 sizeClass) const;	// since construction
+	int32 GetChunkCount() const;
+	int32 GetReservedBytes() const;	// chunks and the chunk array
+
 private:
 
 	b2Chunk* m_chunks;
@@ -51,9 +61,16 @@ private:
 
 	b2Block* m_freeLists[b2_blockSizes];
 
+	int32 m_liveBlockCounts[b2_blockSizes];
+	int32 m_allocationCounts[b2_blockSizes];
+
+	static void InitializeBlockSizeLookup();
+
 	static int32 s_blockSizes[b2_blockSizes];
 	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
 	static bool s_blockSizeLookupInitialized;
+
+	friend struct b2BlockSizeLookupInitializer;
 };
 
 #endif
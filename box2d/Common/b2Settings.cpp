@@ -19,13 +19,17 @@
 #include "b2Settings.h"
 #include <cstdlib>
 
+#ifdef B2_COUNT_BYTES
 int32 b2_byteCount = 0;
+#endif
 
 // Memory allocators. Modify these to use your own allocator.
 void* b2Alloc(int32 size)
 {
 	size += 4;
+#ifdef B2_COUNT_BYTES
 	b2_byteCount += size;
+#endif
 	char* bytes = (char*)malloc(size);
 	*(int32*)bytes = size;
 	return bytes + 4;
@@ -40,8 +44,10 @@ void b2Free(void* mem)
 
 	char* bytes = (char*)mem;
 	bytes -= 4;
+#ifdef B2_COUNT_BYTES
 	int32 size = *(int32*)bytes;
 	b2Assert(b2_byteCount >= size);
 	b2_byteCount -= size;
+#endif
 	free(bytes);
 }
\ No newline at end of file
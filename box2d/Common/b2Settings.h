@@ -53,8 +53,11 @@ const float32 b2_timeUnitsPerSecond = 1.0f;
 const int32 b2_maxManifoldPoints = 2;
 const int32 b2_maxShapesPerBody = 1024; // NOTE: MACIEK was 64
 const int32 b2_maxPolyVertices = 8;
-const int32 b2_maxProxies = 1<<12;				// this must be a power of two // NOTE: MACIEK, was 512
-const int32 b2_maxPairs = 8 * b2_maxProxies;	// this must be a power of two
+const int32 b2_initialProxyCapacity = 64;						// broad-phase storage grows from this, must be a power of two
+const int32 b2_initialPairCapacity = 8 * b2_initialProxyCapacity;	// this must be a power of two
+const float32 b2_aabbExtension = 0.1f * b2_lengthUnitsPerMeter;		// fattening of tree broad-phase proxies
+const int32 b2_contactChunkSize = 32;		// contacts evaluated by one narrow-phase task
+const int32 b2_initialWorldCapacity = 64;	// world body and contact arrays grow from this
 
 // Dynamics
 const float32 b2_linearSlop = 0.005f * b2_lengthUnitsPerMeter;	// 0.5 cm
@@ -63,6 +66,12 @@ const float32 b2_velocityThreshold = 1.0f * b2_lengthUnitsPerMeter / b2_timeUnit
 const float32 b2_maxLinearCorrection = 0.2f * b2_lengthUnitsPerMeter;	// 20 cm
 const float32 b2_maxAngularCorrection = 8.0f / 180.0f * b2_pi;			// 8 degrees
 const float32 b2_contactBaumgarte = 0.2f;
+const int32 b2_minVelocityIterations = 2;	// before an island may stop early
+const float32 b2_velocityTolerance = 0.00025f * b2_lengthUnitsPerMeter / b2_timeUnitsPerSecond;	// 0.25 mm/s, largest correction of a converged iteration
+const float32 b2_angularVelocityTolerance = 0.05f / 180.0f * b2_pi / b2_timeUnitsPerSecond;		// 0.05 degrees/s, the same for joint rotations
+const int32 b2_minColoredConstraints = 256;	// smaller islands keep the sequential constraint order
+const int32 b2_maxConstraintColors = 32;	// constraints left without a color are solved serially
+const int32 b2_colorChunkSize = 16;			// constraints of one color solved by one task, a multiple of 4
 
 // Sleep
 const float32 b2_timeToSleep = 0.5f * b2_timeUnitsPerSecond;	// half a second
@@ -71,7 +80,10 @@ const float32 b2_angularSleepTolerance = 2.0f / 180.0f / b2_timeUnitsPerSecond;
 
 
 // Memory Allocation
+#ifdef B2_COUNT_BYTES
+// Global counter is not thread safe - define B2_COUNT_BYTES only for single-threaded debugging.
 extern int32 b2_byteCount;
+#endif
 void* b2Alloc(int32 size);
 void b2Free(void* mem);
 
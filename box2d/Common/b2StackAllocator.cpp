@@ -21,9 +21,12 @@
 
 b2StackAllocator::b2StackAllocator()
 {
+	m_capacity = b2_stackSize;
+	m_data = (char*)b2Alloc(m_capacity);
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_mallocCount = 0;
 	m_entryCount = 0;
 }
 
@@ -31,6 +34,7 @@ b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+	b2Free(m_data);
 }
 
 void* b2StackAllocator::Allocate(int32 size)
@@ -39,10 +43,11 @@ void* b2StackAllocator::Allocate(int32 size)
 
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_index + size > m_capacity)
 	{
 		entry->data = (char*)b2Alloc(size);
 		entry->usedMalloc = true;
+		++m_mallocCount;
 	}
 	else
 	{
@@ -77,7 +82,36 @@ void b2StackAllocator::Free(void* p)
 	p = NULL;
 }
 
+void b2StackAllocator::Reset()
+{
+	b2Assert(m_entryCount == 0);
+	m_index = 0;
+	m_allocation = 0;
+
+	// The arena cannot move while blocks are out, so it only grows here.
+	// Grow in steps of half, so a slowly rising peak reallocates rarely.
+	if (m_maxAllocation > m_capacity)
+	{
+		while (m_capacity < m_maxAllocation)
+		{
+			m_capacity += m_capacity / 2;
+		}
+		b2Free(m_data);
+		m_data = (char*)b2Alloc(m_capacity);
+	}
+}
+
 int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+int32 b2StackAllocator::GetMallocCount() const
+{
+	return m_mallocCount;
+}
+
+int32 b2StackAllocator::GetCapacity() const
+{
+	return m_capacity;
+}
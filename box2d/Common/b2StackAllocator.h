@@ -21,7 +21,7 @@
 
 #include "b2Settings.h"
 
-const int32 b2_stackSize = 100 * 1024;	// 100k
+const int32 b2_stackSize = 100 * 1024;	// 100k to start with, grows to the peak
 const int32 b2_maxStackEntries = 32;
 
 struct b2StackEntry
@@ -34,6 +34,8 @@ struct b2StackEntry
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// Allocations that do not fit the arena use b2Alloc. Reset grows the
+// arena to the peak, so steps like the previous ones use no heap.
 class b2StackAllocator
 {
 public:
@@ -43,15 +45,26 @@ public:
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	// Call at the start of a step, with nothing allocated.
+	void Reset();
+
+	// Largest amount allocated at once, in bytes.
 	int32 GetMaxAllocation() const;
 
+	// Allocations that did not fit the arena.
+	int32 GetMallocCount() const;
+
+	int32 GetCapacity() const;
+
 private:
 
-	char m_data[b2_stackSize];
+	char* m_data;
+	int32 m_capacity;
 	int32 m_index;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_mallocCount;
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
@@ -29,6 +29,21 @@
 b2ContactRegister b2Contact::s_registers[e_shapeTypeCount][e_shapeTypeCount];
 bool b2Contact::s_initialized = false;
 
+// Registers contact types during static initialization, before any thread can create a contact.
+struct b2ContactRegistersInitializer
+{
+	b2ContactRegistersInitializer()
+	{
+		if (b2Contact::s_initialized == false)
+		{
+			b2Contact::InitializeRegisters();
+			b2Contact::s_initialized = true;
+		}
+	}
+};
+
+static b2ContactRegistersInitializer s_contactRegistersInitializer;
+
 void b2Contact::InitializeRegisters()
 {
 	AddType(b2CircleContact::Create, b2CircleContact::Destroy, e_circleShape, e_circleShape);
@@ -123,8 +138,9 @@ b2Contact::b2Contact(b2Shape* s1, b2Shape* s2)
 
 	m_friction = sqrtf(m_shape1->m_friction * m_shape2->m_friction);
 	m_restitution = b2Max(m_shape1->m_restitution, m_shape2->m_restitution);
-	m_prev = NULL;
-	m_next = NULL;
+	m_worldIndex = -1;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
 
 	m_node1.contact = NULL;
 	m_node1.prev = NULL;
@@ -55,8 +55,6 @@ public:
 		return m_manifoldCount;
 	}
 
-	b2Contact* GetNext();
-
 	b2Shape* GetShape1();
 
 	b2Shape* GetShape2();
@@ -86,14 +84,17 @@ public:
 
 	uint32 m_flags;
 
-	// World pool and list pointers.
-	b2Contact* m_prev;
-	b2Contact* m_next;
+	// Index in b2World::m_contacts.
+	int32 m_worldIndex;
 
 	// Nodes for connecting bodies.
 	b2ContactNode m_node1;
 	b2ContactNode m_node2;
 
+	// Persistent island list, while touching.
+	b2Contact* m_islandPrev;
+	b2Contact* m_islandNext;
+
 	b2Shape* m_shape1;
 	b2Shape* m_shape2;
 
@@ -104,11 +105,6 @@ public:
 	float32 m_restitution;
 };
 
-inline b2Contact* b2Contact::GetNext()
-{
-	return m_next;
-}
-
 inline b2Shape* b2Contact::GetShape1()
 {
 	return m_shape1;
@@ -22,8 +22,14 @@
 #include "../b2World.h"
 #include "../../Common/b2StackAllocator.h"
 
-b2ContactSolver::b2ContactSolver(b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator)
+#ifdef B2_SIMD_CONTACTS
+#include <emmintrin.h>
+#include <string.h>
+#endif
+
+b2ContactSolver::b2ContactSolver(const b2TimeStep* step, b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator)
 {
+	m_step = step;
 	m_allocator = allocator;
 
 	m_constraintCount = 0;
@@ -144,7 +150,7 @@ void b2ContactSolver::PreSolve()
 		b2Vec2 normal = c->normal;
 		b2Vec2 tangent = b2Cross(normal, 1.0f);
 
-		if (b2World::s_enableWarmStarting)
+		if (m_step->warmStarting)
 		{
 			for (int32 j = 0; j < c->pointCount; ++j)
 			{
@@ -152,10 +158,16 @@ void b2ContactSolver::PreSolve()
 				b2Vec2 P = ccp->normalImpulse * normal + ccp->tangentImpulse * tangent;
 				b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
 				b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
-				b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
-				b1->m_linearVelocity -= invMass1 * P;
-				b2->m_angularVelocity += invI2 * b2Cross(r2, P);
-				b2->m_linearVelocity += invMass2 * P;
+				if (b1->m_invMass != 0.0f)
+				{
+					b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
+					b1->m_linearVelocity -= invMass1 * P;
+				}
+				if (b2->m_invMass != 0.0f)
+				{
+					b2->m_angularVelocity += invI2 * b2Cross(r2, P);
+					b2->m_linearVelocity += invMass2 * P;
+				}
 
 				ccp->positionImpulse = 0.0f;
 			}
@@ -174,145 +186,207 @@ void b2ContactSolver::PreSolve()
 	}
 }
 
-void b2ContactSolver::SolveVelocityConstraints()
+// The correction is estimated from the linear velocity change of the impulses.
+float32 b2ContactSolver::SolveVelocityConstraint(b2ContactConstraint* c, float32 maxCorrection)
 {
-	for (int32 i = 0; i < m_constraintCount; ++i)
+	b2Body* b1 = c->body1;
+	b2Body* b2 = c->body2;
+	float32 invMass1 = b1->m_invMass;
+	float32 invI1 = b1->m_invI;
+	float32 invMass2 = b2->m_invMass;
+	float32 invI2 = b2->m_invI;
+	float32 invMassSum = invMass1 + invMass2;
+	b2Vec2 normal = c->normal;
+	b2Vec2 tangent = b2Cross(normal, 1.0f);
+
+	// Solver normal constraints
+	for (int32 j = 0; j < c->pointCount; ++j)
 	{
-		b2ContactConstraint* c = m_constraints + i;
-		b2Body* b1 = c->body1;
-		b2Body* b2 = c->body2;
-		float32 invMass1 = b1->m_invMass;
-		float32 invI1 = b1->m_invI;
-		float32 invMass2 = b2->m_invMass;
-		float32 invI2 = b2->m_invI;
-		b2Vec2 normal = c->normal;
-		b2Vec2 tangent = b2Cross(normal, 1.0f);
+		b2ContactConstraintPoint* ccp = c->points + j;
 
-		// Solver normal constraints
-		for (int32 j = 0; j < c->pointCount; ++j)
-		{
-			b2ContactConstraintPoint* ccp = c->points + j;
-
-			b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
-			b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
+		b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
+		b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
 
-			// Relative velocity at contact
-			b2Vec2 dv = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2) - b1->m_linearVelocity - b2Cross(b1->m_angularVelocity, r1);
+		// Relative velocity at contact
+		b2Vec2 dv = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2) - b1->m_linearVelocity - b2Cross(b1->m_angularVelocity, r1);
 
-			// Compute normal impulse
-			float32 vn = b2Dot(dv, normal);
-			float32 lambda = -ccp->normalMass * (vn - ccp->velocityBias);
+		// Compute normal impulse
+		float32 vn = b2Dot(dv, normal);
+		float32 lambda = -ccp->normalMass * (vn - ccp->velocityBias);
 
-			// b2Clamp the accumulated impulse
-			float32 newImpulse = b2Max(ccp->normalImpulse + lambda, 0.0f);
-			lambda = newImpulse - ccp->normalImpulse;
+		// b2Clamp the accumulated impulse
+		float32 newImpulse = b2Max(ccp->normalImpulse + lambda, 0.0f);
+		lambda = newImpulse - ccp->normalImpulse;
+		maxCorrection = b2Max(maxCorrection, b2Abs(lambda) * invMassSum);
 
-			// Apply contact impulse
-			b2Vec2 P = lambda * normal;
+		// Apply contact impulse
+		b2Vec2 P = lambda * normal;
 
+		if (b1->m_invMass != 0.0f)
+		{
 			b1->m_linearVelocity -= invMass1 * P;
 			b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
+		}
 
+		if (b2->m_invMass != 0.0f)
+		{
 			b2->m_linearVelocity += invMass2 * P;
 			b2->m_angularVelocity += invI2 * b2Cross(r2, P);
-
-			ccp->normalImpulse = newImpulse;
 		}
 
-		// Solver tangent constraints
-		for (int32 j = 0; j < c->pointCount; ++j)
-		{
-			b2ContactConstraintPoint* ccp = c->points + j;
+		ccp->normalImpulse = newImpulse;
+	}
 
-			b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
-			b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
+	// Solver tangent constraints
+	for (int32 j = 0; j < c->pointCount; ++j)
+	{
+		b2ContactConstraintPoint* ccp = c->points + j;
 
-			// Relative velocity at contact
-			b2Vec2 dv = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2) - b1->m_linearVelocity - b2Cross(b1->m_angularVelocity, r1);
+		b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
+		b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
 
-			// Compute tangent impulse
-			float32 vt = b2Dot(dv, tangent);
-			float32 lambda = ccp->tangentMass * (-vt);
+		// Relative velocity at contact
+		b2Vec2 dv = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2) - b1->m_linearVelocity - b2Cross(b1->m_angularVelocity, r1);
 
-			// b2Clamp the accumulated impulse
-			float32 maxFriction = c->friction * ccp->normalImpulse;
-			float32 newImpulse = b2Clamp(ccp->tangentImpulse + lambda, -maxFriction, maxFriction);
-			lambda = newImpulse - ccp->tangentImpulse;
+		// Compute tangent impulse
+		float32 vt = b2Dot(dv, tangent);
+		float32 lambda = ccp->tangentMass * (-vt);
 
-			// Apply contact impulse
-			b2Vec2 P = lambda * tangent;
+		// b2Clamp the accumulated impulse
+		float32 maxFriction = c->friction * ccp->normalImpulse;
+		float32 newImpulse = b2Clamp(ccp->tangentImpulse + lambda, -maxFriction, maxFriction);
+		lambda = newImpulse - ccp->tangentImpulse;
+		maxCorrection = b2Max(maxCorrection, b2Abs(lambda) * invMassSum);
+
+		// Apply contact impulse
+		b2Vec2 P = lambda * tangent;
 
+		if (b1->m_invMass != 0.0f)
+		{
 			b1->m_linearVelocity -= invMass1 * P;
 			b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
+		}
 
+		if (b2->m_invMass != 0.0f)
+		{
 			b2->m_linearVelocity += invMass2 * P;
 			b2->m_angularVelocity += invI2 * b2Cross(r2, P);
-
-			ccp->tangentImpulse = newImpulse;
 		}
+
+		ccp->tangentImpulse = newImpulse;
 	}
+
+	return maxCorrection;
 }
 
-bool b2ContactSolver::SolvePositionConstraints(float32 beta)
+float32 b2ContactSolver::SolveVelocityConstraints()
 {
-	float32 minSeparation = 0.0f;
+	float32 maxCorrection = 0.0f;
 
 	for (int32 i = 0; i < m_constraintCount; ++i)
 	{
-		b2ContactConstraint* c = m_constraints + i;
-		b2Body* b1 = c->body1;
-		b2Body* b2 = c->body2;
-		float32 invMass1 = b1->m_invMass;
-		float32 invI1 = b1->m_invI;
-		float32 invMass2 = b2->m_invMass;
-		float32 invI2 = b2->m_invI;
-		b2Vec2 normal = c->normal;
-		b2Vec2 tangent = b2Cross(normal, 1.0f);
+		maxCorrection = SolveVelocityConstraint(m_constraints + i, maxCorrection);
+	}
 
-		// Solver normal constraints
-		for (int32 j = 0; j < c->pointCount; ++j)
-		{
-			b2ContactConstraintPoint* ccp = c->points + j;
+	return maxCorrection;
+}
 
-			b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
-			b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
+float32 b2ContactSolver::SolveVelocityConstraints(const int32* indices, int32 count)
+{
+	float32 maxCorrection = 0.0f;
 
-			b2Vec2 p1 = b1->m_position + r1;
-			b2Vec2 p2 = b2->m_position + r2;
-			b2Vec2 dp = p2 - p1;
+	for (int32 i = 0; i < count; ++i)
+	{
+		maxCorrection = SolveVelocityConstraint(m_constraints + indices[i], maxCorrection);
+	}
 
-			// Approximate the current separation.
-			float32 separation = b2Dot(dp, normal) + ccp->separation;
+	return maxCorrection;
+}
 
-			// Track max constraint error.
-			minSeparation = b2Min(minSeparation, separation);
+float32 b2ContactSolver::SolvePositionConstraint(b2ContactConstraint* c, float32 beta, float32 minSeparation)
+{
+	b2Body* b1 = c->body1;
+	b2Body* b2 = c->body2;
+	float32 invMass1 = b1->m_invMass;
+	float32 invI1 = b1->m_invI;
+	float32 invMass2 = b2->m_invMass;
+	float32 invI2 = b2->m_invI;
+	b2Vec2 normal = c->normal;
+	b2Vec2 tangent = b2Cross(normal, 1.0f);
+
+	// Solver normal constraints
+	for (int32 j = 0; j < c->pointCount; ++j)
+	{
+		b2ContactConstraintPoint* ccp = c->points + j;
 
-			// Prevent large corrections and allow slop.
-			float32 C = beta * b2Clamp(separation + b2_linearSlop, -b2_maxLinearCorrection, 0.0f);
+		b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
+		b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
 
-			// Compute normal impulse
-			float32 dImpulse = -ccp->normalMass * C;
+		b2Vec2 p1 = b1->m_position + r1;
+		b2Vec2 p2 = b2->m_position + r2;
+		b2Vec2 dp = p2 - p1;
 
-			// b2Clamp the accumulated impulse
-			float32 impulse0 = ccp->positionImpulse;
-			ccp->positionImpulse = b2Max(impulse0 + dImpulse, 0.0f);
-			dImpulse = ccp->positionImpulse - impulse0;
+		// Approximate the current separation.
+		float32 separation = b2Dot(dp, normal) + ccp->separation;
+
+		// Track max constraint error.
+		minSeparation = b2Min(minSeparation, separation);
+
+		// Prevent large corrections and allow slop.
+		float32 C = beta * b2Clamp(separation + b2_linearSlop, -b2_maxLinearCorrection, 0.0f);
+
+		// Compute normal impulse
+		float32 dImpulse = -ccp->normalMass * C;
 
-			b2Vec2 impulse = dImpulse * normal;
+		// b2Clamp the accumulated impulse
+		float32 impulse0 = ccp->positionImpulse;
+		ccp->positionImpulse = b2Max(impulse0 + dImpulse, 0.0f);
+		dImpulse = ccp->positionImpulse - impulse0;
 
+		b2Vec2 impulse = dImpulse * normal;
+
+		if (b1->m_invMass != 0.0f)
+		{
 			b1->m_position -= invMass1 * impulse;
 			b1->m_rotation -= invI1 * b2Cross(r1, impulse);
 			b1->m_R.Set(b1->m_rotation);
+		}
 
+		if (b2->m_invMass != 0.0f)
+		{
 			b2->m_position += invMass2 * impulse;
 			b2->m_rotation += invI2 * b2Cross(r2, impulse);
 			b2->m_R.Set(b2->m_rotation);
 		}
 	}
 
+	return minSeparation;
+}
+
+bool b2ContactSolver::SolvePositionConstraints(float32 beta)
+{
+	float32 minSeparation = 0.0f;
+
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		minSeparation = SolvePositionConstraint(m_constraints + i, beta, minSeparation);
+	}
+
 	return minSeparation >= -b2_linearSlop;
 }
 
+float32 b2ContactSolver::SolvePositionConstraints(float32 beta, const int32* indices, int32 count)
+{
+	float32 minSeparation = 0.0f;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		minSeparation = SolvePositionConstraint(m_constraints + indices[i], beta, minSeparation);
+	}
+
+	return minSeparation;
+}
+
 void b2ContactSolver::PostSolve()
 {
 	for (int32 i = 0; i < m_constraintCount; ++i)
@@ -326,4 +400,389 @@ void b2ContactSolver::PostSolve()
 			m->points[j].tangentImpulse = c->points[j].tangentImpulse;
 		}
 	}
-}
\ No newline at end of file
+}
+
+#ifdef B2_SIMD_CONTACTS
+
+// The wide solver repeats the operations of the scalar one in the same order,
+// so both give the same results.
+
+struct b2WideBody
+{
+	__m128 vX, vY, w;
+	__m128 pX, pY, rotation;
+	__m128 r11, r21, r12, r22;	// rotation matrix, rij is row i of column j
+	__m128 dynamic;				// all bits set for lanes with a dynamic body
+};
+
+static inline __m128 b2Negate(__m128 a)
+{
+	return _mm_xor_ps(a, _mm_set1_ps(-0.0f));
+}
+
+static inline __m128 b2Abs(__m128 a)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+
+static inline __m128 b2Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline void b2GatherBodies(b2WideBody* wide, b2Body* const* bodies)
+{
+	float32 data[11][4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		const b2Body* b = bodies[i];
+		if (b == NULL)
+		{
+			for (int32 j = 0; j < 11; ++j)
+			{
+				data[j][i] = 0.0f;
+			}
+			continue;
+		}
+
+		data[0][i] = b->m_linearVelocity.x;
+		data[1][i] = b->m_linearVelocity.y;
+		data[2][i] = b->m_angularVelocity;
+		data[3][i] = b->m_position.x;
+		data[4][i] = b->m_position.y;
+		data[5][i] = b->m_rotation;
+		data[6][i] = b->m_R.col1.x;
+		data[7][i] = b->m_R.col1.y;
+		data[8][i] = b->m_R.col2.x;
+		data[9][i] = b->m_R.col2.y;
+		data[10][i] = b->m_invMass;
+	}
+
+	wide->vX = _mm_loadu_ps(data[0]);
+	wide->vY = _mm_loadu_ps(data[1]);
+	wide->w = _mm_loadu_ps(data[2]);
+	wide->pX = _mm_loadu_ps(data[3]);
+	wide->pY = _mm_loadu_ps(data[4]);
+	wide->rotation = _mm_loadu_ps(data[5]);
+	wide->r11 = _mm_loadu_ps(data[6]);
+	wide->r21 = _mm_loadu_ps(data[7]);
+	wide->r12 = _mm_loadu_ps(data[8]);
+	wide->r22 = _mm_loadu_ps(data[9]);
+	wide->dynamic = _mm_cmpneq_ps(_mm_loadu_ps(data[10]), _mm_setzero_ps());
+}
+
+static inline void b2ScatterVelocities(const b2WideBody* wide, b2Body* const* bodies)
+{
+	float32 vX[4], vY[4], w[4];
+	_mm_storeu_ps(vX, wide->vX);
+	_mm_storeu_ps(vY, wide->vY);
+	_mm_storeu_ps(w, wide->w);
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		b2Body* b = bodies[i];
+		if (b && b->m_invMass != 0.0f)
+		{
+			b->m_linearVelocity.Set(vX[i], vY[i]);
+			b->m_angularVelocity = w[i];
+		}
+	}
+}
+
+static inline void b2ScatterPositions(const b2WideBody* wide, b2Body* const* bodies, __m128 active)
+{
+	int32 mask = _mm_movemask_ps(active);
+	float32 pX[4], pY[4], rotation[4];
+	_mm_storeu_ps(pX, wide->pX);
+	_mm_storeu_ps(pY, wide->pY);
+	_mm_storeu_ps(rotation, wide->rotation);
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		b2Body* b = bodies[i];
+		if (b && b->m_invMass != 0.0f && (mask & (1 << i)))
+		{
+			b->m_position.Set(pX[i], pY[i]);
+			b->m_rotation = rotation[i];
+			b->m_R.Set(b->m_rotation);
+		}
+	}
+}
+
+void b2ContactSolver::GatherWide(b2WideContactConstraint* wide, const int32* indices, int32 count)
+{
+	b2Assert(0 < count && count <= 4);
+
+	memset(wide, 0, sizeof(b2WideContactConstraint));
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2ContactConstraint* c = m_constraints + indices[i];
+		wide->index[i] = indices[i];
+		wide->body1[i] = c->body1;
+		wide->body2[i] = c->body2;
+		wide->pointCount[i] = c->pointCount;
+		wide->normalX[i] = c->normal.x;
+		wide->normalY[i] = c->normal.y;
+		wide->invMass1[i] = c->body1->m_invMass;
+		wide->invI1[i] = c->body1->m_invI;
+		wide->invMass2[i] = c->body2->m_invMass;
+		wide->invI2[i] = c->body2->m_invI;
+		wide->friction[i] = c->friction;
+
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			const b2ContactConstraintPoint* ccp = c->points + j;
+			b2WideContactConstraint::Point* wp = wide->points + j;
+			wp->localAnchor1X[i] = ccp->localAnchor1.x;
+			wp->localAnchor1Y[i] = ccp->localAnchor1.y;
+			wp->localAnchor2X[i] = ccp->localAnchor2.x;
+			wp->localAnchor2Y[i] = ccp->localAnchor2.y;
+			wp->normalImpulse[i] = ccp->normalImpulse;
+			wp->tangentImpulse[i] = ccp->tangentImpulse;
+			wp->positionImpulse[i] = ccp->positionImpulse;
+			wp->normalMass[i] = ccp->normalMass;
+			wp->tangentMass[i] = ccp->tangentMass;
+			wp->separation[i] = ccp->separation;
+			wp->velocityBias[i] = ccp->velocityBias;
+		}
+	}
+}
+
+void b2ContactSolver::ScatterWide(const b2WideContactConstraint* wide)
+{
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (wide->body1[i] == NULL)
+		{
+			continue;
+		}
+
+		b2ContactConstraint* c = m_constraints + wide->index[i];
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			b2ContactConstraintPoint* ccp = c->points + j;
+			const b2WideContactConstraint::Point* wp = wide->points + j;
+			ccp->normalImpulse = wp->normalImpulse[i];
+			ccp->tangentImpulse = wp->tangentImpulse[i];
+			ccp->positionImpulse = wp->positionImpulse[i];
+		}
+	}
+}
+
+float32 b2ContactSolver::SolveVelocityConstraints(b2WideContactConstraint* wide, int32 count)
+{
+	const __m128 zero = _mm_setzero_ps();
+	__m128 maxCorrection = zero;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2WideContactConstraint* c = wide + i;
+
+		b2WideBody b1, b2;
+		b2GatherBodies(&b1, c->body1);
+		b2GatherBodies(&b2, c->body2);
+
+		__m128 invMass1 = _mm_loadu_ps(c->invMass1);
+		__m128 invI1 = _mm_loadu_ps(c->invI1);
+		__m128 invMass2 = _mm_loadu_ps(c->invMass2);
+		__m128 invI2 = _mm_loadu_ps(c->invI2);
+		__m128 invMassSum = _mm_add_ps(invMass1, invMass2);
+		__m128 normalX = _mm_loadu_ps(c->normalX);
+		__m128 normalY = _mm_loadu_ps(c->normalY);
+		__m128 tangentX = normalY;
+		__m128 tangentY = b2Negate(normalX);
+		__m128i pointCount = _mm_loadu_si128((const __m128i*)c->pointCount);
+
+		// Solver normal constraints
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2WideContactConstraint::Point* ccp = c->points + j;
+			__m128 active = _mm_castsi128_ps(_mm_cmpgt_epi32(pointCount, _mm_set1_epi32(j)));
+
+			__m128 a1X = _mm_loadu_ps(ccp->localAnchor1X);
+			__m128 a1Y = _mm_loadu_ps(ccp->localAnchor1Y);
+			__m128 a2X = _mm_loadu_ps(ccp->localAnchor2X);
+			__m128 a2Y = _mm_loadu_ps(ccp->localAnchor2Y);
+			__m128 r1X = _mm_add_ps(_mm_mul_ps(b1.r11, a1X), _mm_mul_ps(b1.r12, a1Y));
+			__m128 r1Y = _mm_add_ps(_mm_mul_ps(b1.r21, a1X), _mm_mul_ps(b1.r22, a1Y));
+			__m128 r2X = _mm_add_ps(_mm_mul_ps(b2.r11, a2X), _mm_mul_ps(b2.r12, a2Y));
+			__m128 r2Y = _mm_add_ps(_mm_mul_ps(b2.r21, a2X), _mm_mul_ps(b2.r22, a2Y));
+
+			// Relative velocity at contact
+			__m128 dvX = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(b2.vX, _mm_mul_ps(b2Negate(b2.w), r2Y)), b1.vX), _mm_mul_ps(b2Negate(b1.w), r1Y));
+			__m128 dvY = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(b2.vY, _mm_mul_ps(b2.w, r2X)), b1.vY), _mm_mul_ps(b1.w, r1X));
+
+			// Compute normal impulse
+			__m128 vn = _mm_add_ps(_mm_mul_ps(dvX, normalX), _mm_mul_ps(dvY, normalY));
+			__m128 normalImpulse = _mm_loadu_ps(ccp->normalImpulse);
+			__m128 lambda = _mm_mul_ps(b2Negate(_mm_loadu_ps(ccp->normalMass)), _mm_sub_ps(vn, _mm_loadu_ps(ccp->velocityBias)));
+
+			// b2Clamp the accumulated impulse
+			__m128 newImpulse = _mm_max_ps(_mm_add_ps(normalImpulse, lambda), zero);
+			newImpulse = b2Select(active, newImpulse, normalImpulse);
+			lambda = _mm_sub_ps(newImpulse, normalImpulse);
+			maxCorrection = _mm_max_ps(maxCorrection, _mm_mul_ps(b2Abs(lambda), invMassSum));
+
+			// Apply contact impulse
+			__m128 PX = _mm_mul_ps(lambda, normalX);
+			__m128 PY = _mm_mul_ps(lambda, normalY);
+			__m128 cross1 = _mm_sub_ps(_mm_mul_ps(r1X, PY), _mm_mul_ps(r1Y, PX));
+			__m128 cross2 = _mm_sub_ps(_mm_mul_ps(r2X, PY), _mm_mul_ps(r2Y, PX));
+
+			__m128 update1 = _mm_and_ps(b1.dynamic, active);
+			b1.vX = b2Select(update1, _mm_sub_ps(b1.vX, _mm_mul_ps(invMass1, PX)), b1.vX);
+			b1.vY = b2Select(update1, _mm_sub_ps(b1.vY, _mm_mul_ps(invMass1, PY)), b1.vY);
+			b1.w = b2Select(update1, _mm_sub_ps(b1.w, _mm_mul_ps(invI1, cross1)), b1.w);
+
+			__m128 update2 = _mm_and_ps(b2.dynamic, active);
+			b2.vX = b2Select(update2, _mm_add_ps(b2.vX, _mm_mul_ps(invMass2, PX)), b2.vX);
+			b2.vY = b2Select(update2, _mm_add_ps(b2.vY, _mm_mul_ps(invMass2, PY)), b2.vY);
+			b2.w = b2Select(update2, _mm_add_ps(b2.w, _mm_mul_ps(invI2, cross2)), b2.w);
+
+			_mm_storeu_ps(ccp->normalImpulse, newImpulse);
+		}
+
+		// Solver tangent constraints
+		__m128 friction = _mm_loadu_ps(c->friction);
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2WideContactConstraint::Point* ccp = c->points + j;
+			__m128 active = _mm_castsi128_ps(_mm_cmpgt_epi32(pointCount, _mm_set1_epi32(j)));
+
+			__m128 a1X = _mm_loadu_ps(ccp->localAnchor1X);
+			__m128 a1Y = _mm_loadu_ps(ccp->localAnchor1Y);
+			__m128 a2X = _mm_loadu_ps(ccp->localAnchor2X);
+			__m128 a2Y = _mm_loadu_ps(ccp->localAnchor2Y);
+			__m128 r1X = _mm_add_ps(_mm_mul_ps(b1.r11, a1X), _mm_mul_ps(b1.r12, a1Y));
+			__m128 r1Y = _mm_add_ps(_mm_mul_ps(b1.r21, a1X), _mm_mul_ps(b1.r22, a1Y));
+			__m128 r2X = _mm_add_ps(_mm_mul_ps(b2.r11, a2X), _mm_mul_ps(b2.r12, a2Y));
+			__m128 r2Y = _mm_add_ps(_mm_mul_ps(b2.r21, a2X), _mm_mul_ps(b2.r22, a2Y));
+
+			// Relative velocity at contact
+			__m128 dvX = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(b2.vX, _mm_mul_ps(b2Negate(b2.w), r2Y)), b1.vX), _mm_mul_ps(b2Negate(b1.w), r1Y));
+			__m128 dvY = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(b2.vY, _mm_mul_ps(b2.w, r2X)), b1.vY), _mm_mul_ps(b1.w, r1X));
+
+			// Compute tangent impulse
+			__m128 vt = _mm_add_ps(_mm_mul_ps(dvX, tangentX), _mm_mul_ps(dvY, tangentY));
+			__m128 lambda = _mm_mul_ps(_mm_loadu_ps(ccp->tangentMass), b2Negate(vt));
+
+			// b2Clamp the accumulated impulse
+			__m128 tangentImpulse = _mm_loadu_ps(ccp->tangentImpulse);
+			__m128 maxFriction = _mm_mul_ps(friction, _mm_loadu_ps(ccp->normalImpulse));
+			__m128 newImpulse = _mm_max_ps(b2Negate(maxFriction), _mm_min_ps(_mm_add_ps(tangentImpulse, lambda), maxFriction));
+			newImpulse = b2Select(active, newImpulse, tangentImpulse);
+			lambda = _mm_sub_ps(newImpulse, tangentImpulse);
+			maxCorrection = _mm_max_ps(maxCorrection, _mm_mul_ps(b2Abs(lambda), invMassSum));
+
+			// Apply contact impulse
+			__m128 PX = _mm_mul_ps(lambda, tangentX);
+			__m128 PY = _mm_mul_ps(lambda, tangentY);
+			__m128 cross1 = _mm_sub_ps(_mm_mul_ps(r1X, PY), _mm_mul_ps(r1Y, PX));
+			__m128 cross2 = _mm_sub_ps(_mm_mul_ps(r2X, PY), _mm_mul_ps(r2Y, PX));
+
+			__m128 update1 = _mm_and_ps(b1.dynamic, active);
+			b1.vX = b2Select(update1, _mm_sub_ps(b1.vX, _mm_mul_ps(invMass1, PX)), b1.vX);
+			b1.vY = b2Select(update1, _mm_sub_ps(b1.vY, _mm_mul_ps(invMass1, PY)), b1.vY);
+			b1.w = b2Select(update1, _mm_sub_ps(b1.w, _mm_mul_ps(invI1, cross1)), b1.w);
+
+			__m128 update2 = _mm_and_ps(b2.dynamic, active);
+			b2.vX = b2Select(update2, _mm_add_ps(b2.vX, _mm_mul_ps(invMass2, PX)), b2.vX);
+			b2.vY = b2Select(update2, _mm_add_ps(b2.vY, _mm_mul_ps(invMass2, PY)), b2.vY);
+			b2.w = b2Select(update2, _mm_add_ps(b2.w, _mm_mul_ps(invI2, cross2)), b2.w);
+
+			_mm_storeu_ps(ccp->tangentImpulse, newImpulse);
+		}
+
+		b2ScatterVelocities(&b1, c->body1);
+		b2ScatterVelocities(&b2, c->body2);
+	}
+
+	float32 corrections[4];
+	_mm_storeu_ps(corrections, maxCorrection);
+	return b2Max(b2Max(corrections[0], corrections[1]), b2Max(corrections[2], corrections[3]));
+}
+
+float32 b2ContactSolver::SolvePositionConstraints(float32 beta, b2WideContactConstraint* wide, int32 count)
+{
+	const __m128 zero = _mm_setzero_ps();
+	__m128 minSeparation = zero;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2WideContactConstraint* c = wide + i;
+
+		__m128 invMass1 = _mm_loadu_ps(c->invMass1);
+		__m128 invI1 = _mm_loadu_ps(c->invI1);
+		__m128 invMass2 = _mm_loadu_ps(c->invMass2);
+		__m128 invI2 = _mm_loadu_ps(c->invI2);
+		__m128 normalX = _mm_loadu_ps(c->normalX);
+		__m128 normalY = _mm_loadu_ps(c->normalY);
+		__m128i pointCount = _mm_loadu_si128((const __m128i*)c->pointCount);
+
+		// Solver normal constraints
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2WideContactConstraint::Point* ccp = c->points + j;
+			__m128 active = _mm_castsi128_ps(_mm_cmpgt_epi32(pointCount, _mm_set1_epi32(j)));
+
+			// The rotation matrices change with each point.
+			b2WideBody b1, b2;
+			b2GatherBodies(&b1, c->body1);
+			b2GatherBodies(&b2, c->body2);
+
+			__m128 a1X = _mm_loadu_ps(ccp->localAnchor1X);
+			__m128 a1Y = _mm_loadu_ps(ccp->localAnchor1Y);
+			__m128 a2X = _mm_loadu_ps(ccp->localAnchor2X);
+			__m128 a2Y = _mm_loadu_ps(ccp->localAnchor2Y);
+			__m128 r1X = _mm_add_ps(_mm_mul_ps(b1.r11, a1X), _mm_mul_ps(b1.r12, a1Y));
+			__m128 r1Y = _mm_add_ps(_mm_mul_ps(b1.r21, a1X), _mm_mul_ps(b1.r22, a1Y));
+			__m128 r2X = _mm_add_ps(_mm_mul_ps(b2.r11, a2X), _mm_mul_ps(b2.r12, a2Y));
+			__m128 r2Y = _mm_add_ps(_mm_mul_ps(b2.r21, a2X), _mm_mul_ps(b2.r22, a2Y));
+
+			__m128 dpX = _mm_sub_ps(_mm_add_ps(b2.pX, r2X), _mm_add_ps(b1.pX, r1X));
+			__m128 dpY = _mm_sub_ps(_mm_add_ps(b2.pY, r2Y), _mm_add_ps(b1.pY, r1Y));
+
+			// Approximate the current separation.
+			__m128 separation = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dpX, normalX), _mm_mul_ps(dpY, normalY)), _mm_loadu_ps(ccp->separation));
+
+			// Track max constraint error.
+			minSeparation = b2Select(active, _mm_min_ps(minSeparation, separation), minSeparation);
+
+			// Prevent large corrections and allow slop.
+			__m128 C = _mm_mul_ps(_mm_set1_ps(beta), _mm_max_ps(_mm_set1_ps(-b2_maxLinearCorrection), _mm_min_ps(_mm_add_ps(separation, _mm_set1_ps(b2_linearSlop)), zero)));
+
+			// Compute normal impulse
+			__m128 dImpulse = _mm_mul_ps(b2Negate(_mm_loadu_ps(ccp->normalMass)), C);
+
+			// b2Clamp the accumulated impulse
+			__m128 impulse0 = _mm_loadu_ps(ccp->positionImpulse);
+			__m128 positionImpulse = _mm_max_ps(_mm_add_ps(impulse0, dImpulse), zero);
+			positionImpulse = b2Select(active, positionImpulse, impulse0);
+			dImpulse = _mm_sub_ps(positionImpulse, impulse0);
+			_mm_storeu_ps(ccp->positionImpulse, positionImpulse);
+
+			__m128 impulseX = _mm_mul_ps(dImpulse, normalX);
+			__m128 impulseY = _mm_mul_ps(dImpulse, normalY);
+			__m128 cross1 = _mm_sub_ps(_mm_mul_ps(r1X, impulseY), _mm_mul_ps(r1Y, impulseX));
+			__m128 cross2 = _mm_sub_ps(_mm_mul_ps(r2X, impulseY), _mm_mul_ps(r2Y, impulseX));
+
+			b1.pX = _mm_sub_ps(b1.pX, _mm_mul_ps(invMass1, impulseX));
+			b1.pY = _mm_sub_ps(b1.pY, _mm_mul_ps(invMass1, impulseY));
+			b1.rotation = _mm_sub_ps(b1.rotation, _mm_mul_ps(invI1, cross1));
+
+			b2.pX = _mm_add_ps(b2.pX, _mm_mul_ps(invMass2, impulseX));
+			b2.pY = _mm_add_ps(b2.pY, _mm_mul_ps(invMass2, impulseY));
+			b2.rotation = _mm_add_ps(b2.rotation, _mm_mul_ps(invI2, cross2));
+
+			b2ScatterPositions(&b1, c->body1, active);
+			b2ScatterPositions(&b2, c->body2, active);
+		}
+	}
+
+	float32 separations[4];
+	_mm_storeu_ps(separations, minSeparation);
+	return b2Min(b2Min(separations[0], separations[1]), b2Min(separations[2], separations[3]));
+}
+
+#endif
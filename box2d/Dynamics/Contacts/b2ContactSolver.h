@@ -22,10 +22,16 @@
 #include "../../Common/b2Math.h"
 #include "../../Collision/b2Collision.h"
 
+// The SIMD contact solver needs SSE2, which every x86-64 target has.
+#if !defined(B2_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define B2_SIMD_CONTACTS
+#endif
+
 class b2Contact;
 class b2Body;
 class b2Island;
 class b2StackAllocator;
+struct b2TimeStep;
 
 struct b2ContactConstraintPoint
 {
@@ -52,17 +58,64 @@ struct b2ContactConstraint
 	int32 pointCount;
 };
 
+// Four contact constraints laid out for SIMD, one per lane. The lanes must
+// not share a dynamic body. Unused lanes have no bodies.
+struct b2WideContactConstraint
+{
+	struct Point
+	{
+		float32 localAnchor1X[4], localAnchor1Y[4];
+		float32 localAnchor2X[4], localAnchor2Y[4];
+		float32 normalImpulse[4];
+		float32 tangentImpulse[4];
+		float32 positionImpulse[4];
+		float32 normalMass[4];
+		float32 tangentMass[4];
+		float32 separation[4];
+		float32 velocityBias[4];
+	};
+
+	Point points[b2_maxManifoldPoints];
+	float32 normalX[4], normalY[4];
+	float32 invMass1[4], invI1[4];
+	float32 invMass2[4], invI2[4];
+	float32 friction[4];
+	int32 pointCount[4];
+	int32 index[4];		// of the b2ContactConstraint
+	b2Body* body1[4];
+	b2Body* body2[4];
+};
+
 class b2ContactSolver
 {
 public:
-	b2ContactSolver(b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator);
+	b2ContactSolver(const b2TimeStep* step, b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator);
 	~b2ContactSolver();
 
 	void PreSolve();
-	void SolveVelocityConstraints();
+	float32 SolveVelocityConstraints();	// returns the largest velocity correction
 	bool SolvePositionConstraints(float32 beta);
 	void PostSolve();
 
+	// Solve only the listed constraints. Lists solved at the same time must
+	// not share a dynamic body. Return the largest velocity correction and
+	// the minimum separation.
+	float32 SolveVelocityConstraints(const int32* indices, int32 count);
+	float32 SolvePositionConstraints(float32 beta, const int32* indices, int32 count);
+
+	float32 SolveVelocityConstraint(b2ContactConstraint* c, float32 maxCorrection);
+	float32 SolvePositionConstraint(b2ContactConstraint* c, float32 beta, float32 minSeparation);
+
+#ifdef B2_SIMD_CONTACTS
+	// Same results as the indexed methods above, four constraints at a time.
+	// Gather copies up to four listed constraints, Scatter stores the impulses back.
+	void GatherWide(b2WideContactConstraint* wide, const int32* indices, int32 count);
+	void ScatterWide(const b2WideContactConstraint* wide);
+	float32 SolveVelocityConstraints(b2WideContactConstraint* wide, int32 count);
+	float32 SolvePositionConstraints(float32 beta, b2WideContactConstraint* wide, int32 count);
+#endif
+
+	const b2TimeStep* m_step;
 	b2StackAllocator* m_allocator;
 	b2ContactConstraint* m_constraints;
 	int m_constraintCount;
@@ -39,7 +39,7 @@ b2DistanceJoint::b2DistanceJoint(const b2DistanceJointDef* def)
 	m_impulse = 0.0f;
 }
 
-void b2DistanceJoint::PrepareVelocitySolver()
+void b2DistanceJoint::PrepareVelocitySolver(const b2TimeStep* step)
 {
 	// Compute the effective mass matrix.
 	b2Vec2 r1 = b2Mul(m_body1->m_R, m_localAnchor1);
@@ -63,13 +63,19 @@ void b2DistanceJoint::PrepareVelocitySolver()
 	b2Assert(m_mass > FLT_EPSILON);
 	m_mass = 1.0f / m_mass;
 
-	if (b2World::s_enableWarmStarting)
+	if (step->warmStarting)
 	{
 		b2Vec2 P = m_impulse * m_u;
-		m_body1->m_linearVelocity -= m_body1->m_invMass * P;
-		m_body1->m_angularVelocity -= m_body1->m_invI * b2Cross(r1, P);
-		m_body2->m_linearVelocity += m_body2->m_invMass * P;
-		m_body2->m_angularVelocity += m_body2->m_invI * b2Cross(r2, P);
+		if (m_body1->m_invMass != 0.0f)
+		{
+			m_body1->m_linearVelocity -= m_body1->m_invMass * P;
+			m_body1->m_angularVelocity -= m_body1->m_invI * b2Cross(r1, P);
+		}
+		if (m_body2->m_invMass != 0.0f)
+		{
+			m_body2->m_linearVelocity += m_body2->m_invMass * P;
+			m_body2->m_angularVelocity += m_body2->m_invI * b2Cross(r2, P);
+		}
 	}
 	else
 	{
@@ -77,7 +83,7 @@ void b2DistanceJoint::PrepareVelocitySolver()
 	}
 }
 
-void b2DistanceJoint::SolveVelocityConstraints(const b2TimeStep* step)
+float32 b2DistanceJoint::SolveVelocityConstraints(const b2TimeStep* step)
 {
 	NOT_USED(step);
 
@@ -92,10 +98,18 @@ void b2DistanceJoint::SolveVelocityConstraints(const b2TimeStep* step)
 	m_impulse += impulse;
 
 	b2Vec2 P = impulse * m_u;
-	m_body1->m_linearVelocity -= m_body1->m_invMass * P;
-	m_body1->m_angularVelocity -= m_body1->m_invI * b2Cross(r1, P);
-	m_body2->m_linearVelocity += m_body2->m_invMass * P;
-	m_body2->m_angularVelocity += m_body2->m_invI * b2Cross(r2, P);
+	if (m_body1->m_invMass != 0.0f)
+	{
+		m_body1->m_linearVelocity -= m_body1->m_invMass * P;
+		m_body1->m_angularVelocity -= m_body1->m_invI * b2Cross(r1, P);
+	}
+	if (m_body2->m_invMass != 0.0f)
+	{
+		m_body2->m_linearVelocity += m_body2->m_invMass * P;
+		m_body2->m_angularVelocity += m_body2->m_invI * b2Cross(r2, P);
+	}
+
+	return b2Abs(impulse) / m_mass;
 }
 
 bool b2DistanceJoint::SolvePositionConstraints()
@@ -112,13 +126,18 @@ bool b2DistanceJoint::SolvePositionConstraints()
 	m_u = d;
 	b2Vec2 P = impulse * m_u;
 
-	m_body1->m_position -= m_body1->m_invMass * P;
-	m_body1->m_rotation -= m_body1->m_invI * b2Cross(r1, P);
-	m_body2->m_position += m_body2->m_invMass * P;
-	m_body2->m_rotation += m_body2->m_invI * b2Cross(r2, P);
-
-	m_body1->m_R.Set(m_body1->m_rotation);
-	m_body2->m_R.Set(m_body2->m_rotation);
+	if (m_body1->m_invMass != 0.0f)
+	{
+		m_body1->m_position -= m_body1->m_invMass * P;
+		m_body1->m_rotation -= m_body1->m_invI * b2Cross(r1, P);
+		m_body1->m_R.Set(m_body1->m_rotation);
+	}
+	if (m_body2->m_invMass != 0.0f)
+	{
+		m_body2->m_position += m_body2->m_invMass * P;
+		m_body2->m_rotation += m_body2->m_invI * b2Cross(r2, P);
+		m_body2->m_R.Set(m_body2->m_rotation);
+	}
 
 	return b2Abs(C) < b2_linearSlop;
 }
@@ -47,8 +47,8 @@ public:
 
 	b2DistanceJoint(const b2DistanceJointDef* data);
 
-	void PrepareVelocitySolver();
-	void SolveVelocityConstraints(const b2TimeStep* step);
+	void PrepareVelocitySolver(const b2TimeStep* step);
+	float32 SolveVelocityConstraints(const b2TimeStep* step);
 	bool SolvePositionConstraints();
 
 	b2Vec2 m_localAnchor1;
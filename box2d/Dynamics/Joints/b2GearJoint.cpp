@@ -98,7 +98,7 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 	m_impulse = 0.0f;
 }
 
-void b2GearJoint::PrepareVelocitySolver()
+void b2GearJoint::PrepareVelocitySolver(const b2TimeStep* /*step*/)
 {
 	b2Body* g1 = m_ground1;
 	b2Body* g2 = m_ground2;
@@ -143,13 +143,19 @@ void b2GearJoint::PrepareVelocitySolver()
 	m_mass = 1.0f / K;
 
 	// Warm starting.
-	b1->m_linearVelocity += b1->m_invMass * m_impulse * m_J.linear1;
-	b1->m_angularVelocity += b1->m_invI * m_impulse * m_J.angular1;
-	b2->m_linearVelocity += b2->m_invMass * m_impulse * m_J.linear2;
-	b2->m_angularVelocity += b2->m_invI * m_impulse * m_J.angular2;
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_linearVelocity += b1->m_invMass * m_impulse * m_J.linear1;
+		b1->m_angularVelocity += b1->m_invI * m_impulse * m_J.angular1;
+	}
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_linearVelocity += b2->m_invMass * m_impulse * m_J.linear2;
+		b2->m_angularVelocity += b2->m_invI * m_impulse * m_J.angular2;
+	}
 }
 
-void b2GearJoint::SolveVelocityConstraints(const b2TimeStep* step)
+float32 b2GearJoint::SolveVelocityConstraints(const b2TimeStep* step)
 {
 	NOT_USED(step);
 
@@ -162,10 +168,20 @@ void b2GearJoint::SolveVelocityConstraints(const b2TimeStep* step)
 	float32 impulse = -m_mass * Cdot;
 	m_impulse += impulse;
 
-	b1->m_linearVelocity += b1->m_invMass * impulse * m_J.linear1;
-	b1->m_angularVelocity += b1->m_invI * impulse * m_J.angular1;
-	b2->m_linearVelocity += b2->m_invMass * impulse * m_J.linear2;
-	b2->m_angularVelocity += b2->m_invI * impulse * m_J.angular2;
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_linearVelocity += b1->m_invMass * impulse * m_J.linear1;
+		b1->m_angularVelocity += b1->m_invI * impulse * m_J.angular1;
+	}
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_linearVelocity += b2->m_invMass * impulse * m_J.linear2;
+		b2->m_angularVelocity += b2->m_invI * impulse * m_J.angular2;
+	}
+
+	// The constraint has the units of the first joint's coordinate.
+	float32 correction = b2Abs(impulse) / m_mass;
+	return m_revolute1 ? b2LinearCorrection(correction) : correction;
 }
 
 bool b2GearJoint::SolvePositionConstraints()
@@ -198,12 +214,18 @@ bool b2GearJoint::SolvePositionConstraints()
 
 	float32 impulse = -m_mass * C;
 
-	b1->m_position += b1->m_invMass * impulse * m_J.linear1;
-	b1->m_rotation += b1->m_invI * impulse * m_J.angular1;
-	b2->m_position += b2->m_invMass * impulse * m_J.linear2;
-	b2->m_rotation += b2->m_invI * impulse * m_J.angular2;
-	b1->m_R.Set(b1->m_rotation);
-	b2->m_R.Set(b2->m_rotation);
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_position += b1->m_invMass * impulse * m_J.linear1;
+		b1->m_rotation += b1->m_invI * impulse * m_J.angular1;
+		b1->m_R.Set(b1->m_rotation);
+	}
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_position += b2->m_invMass * impulse * m_J.linear2;
+		b2->m_rotation += b2->m_invI * impulse * m_J.angular2;
+		b2->m_R.Set(b2->m_rotation);
+	}
 
 	return linearError < b2_linearSlop;
 }
@@ -65,8 +65,8 @@ public:
 
 	b2GearJoint(const b2GearJointDef* data);
 
-	void PrepareVelocitySolver();
-	void SolveVelocityConstraints(const b2TimeStep* step);
+	void PrepareVelocitySolver(const b2TimeStep* step);
+	float32 SolveVelocityConstraints(const b2TimeStep* step);
 	bool SolvePositionConstraints();
 
 	b2Body* m_ground1;
@@ -126,6 +126,8 @@ b2Joint::b2Joint(const b2JointDef* def)
 	m_type = def->type;
 	m_prev = NULL;
 	m_next = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
 	m_body1 = def->body1;
 	m_body2 = def->body2;
 	m_collideConnected = def->collideConnected;
@@ -109,8 +109,11 @@ public:
 	b2Joint(const b2JointDef* def);
 	virtual ~b2Joint() {}
 
-	virtual void PrepareVelocitySolver() = 0;
-	virtual void SolveVelocityConstraints(const b2TimeStep* step) = 0;
+	virtual void PrepareVelocitySolver(const b2TimeStep* step) = 0;
+
+	// This returns the largest velocity correction, estimated from the impulse
+	// changes. Angular corrections are scaled by b2LinearCorrection.
+	virtual float32 SolveVelocityConstraints(const b2TimeStep* step) = 0;
 
 	// This returns true if the position errors are within tolerance.
 	virtual void PreparePositionSolver() {}
@@ -124,6 +127,10 @@ public:
 	b2Body* m_body1;
 	b2Body* m_body2;
 
+	// Persistent island list.
+	b2Joint* m_islandPrev;
+	b2Joint* m_islandNext;
+
 	bool m_islandFlag;
 	bool m_collideConnected;
 
@@ -147,6 +154,13 @@ inline float32 b2Jacobian::Compute(const b2Vec2& x1, float32 a1, const b2Vec2& x
 	return b2Dot(linear1, x1) + angular1 * a1 + b2Dot(linear2, x2) + angular2 * a2;
 }
 
+// Scales an angular velocity correction, so both kinds are compared with
+// b2_velocityTolerance.
+inline float32 b2LinearCorrection(float32 angularCorrection)
+{
+	return angularCorrection * (b2_velocityTolerance / b2_angularVelocityTolerance);
+}
+
 inline b2JointType b2Joint::GetType() const
 {
 	return m_type;
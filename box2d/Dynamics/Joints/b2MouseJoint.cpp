@@ -59,7 +59,7 @@ void b2MouseJoint::SetTarget(const b2Vec2& target)
 	m_target = target;
 }
 
-void b2MouseJoint::PrepareVelocitySolver()
+void b2MouseJoint::PrepareVelocitySolver(const b2TimeStep* /*step*/)
 {
 	b2Body* b = m_body2;
 
@@ -97,7 +97,7 @@ void b2MouseJoint::PrepareVelocitySolver()
 	b->m_angularVelocity += invI * b2Cross(r, P);
 }
 
-void b2MouseJoint::SolveVelocityConstraints(const b2TimeStep* step)
+float32 b2MouseJoint::SolveVelocityConstraints(const b2TimeStep* step)
 {
 	b2Body* body = m_body2;
 
@@ -118,6 +118,8 @@ void b2MouseJoint::SolveVelocityConstraints(const b2TimeStep* step)
 
 	body->m_linearVelocity += body->m_invMass * impulse;
 	body->m_angularVelocity += body->m_invI * b2Cross(r, impulse);
+
+	return impulse.Length() * body->m_invMass;
 }
 
 b2Vec2 b2MouseJoint::GetAnchor1() const
@@ -55,8 +55,8 @@ public:
 
 	b2MouseJoint(const b2MouseJointDef* def);
 
-	void PrepareVelocitySolver();
-	void SolveVelocityConstraints(const b2TimeStep* step);
+	void PrepareVelocitySolver(const b2TimeStep* step);
+	float32 SolveVelocityConstraints(const b2TimeStep* step);
 	bool SolvePositionConstraints()
 	{
 		return true;
@@ -67,7 +67,7 @@ b2PrismaticJoint::b2PrismaticJoint(const b2PrismaticJointDef* def)
 	m_enableMotor = def->enableMotor;
 }
 
-void b2PrismaticJoint::PrepareVelocitySolver()
+void b2PrismaticJoint::PrepareVelocitySolver(const b2TimeStep* step)
 {
 	b2Body* b1 = m_body1;
 	b2Body* b2 = m_body2;
@@ -146,18 +146,24 @@ void b2PrismaticJoint::PrepareVelocitySolver()
 		m_limitImpulse = 0.0f;
 	}
 
-	if (b2World::s_enableWarmStarting)
+	if (step->warmStarting)
 	{
 		b2Vec2 P1 = m_linearImpulse * m_linearJacobian.linear1 + (m_motorImpulse + m_limitImpulse) * m_motorJacobian.linear1;
 		b2Vec2 P2 = m_linearImpulse * m_linearJacobian.linear2 + (m_motorImpulse + m_limitImpulse) * m_motorJacobian.linear2;
 		float32 L1 = m_linearImpulse * m_linearJacobian.angular1 - m_angularImpulse + (m_motorImpulse + m_limitImpulse) * m_motorJacobian.angular1;
 		float32 L2 = m_linearImpulse * m_linearJacobian.angular2 + m_angularImpulse + (m_motorImpulse + m_limitImpulse) * m_motorJacobian.angular2;
 
-		b1->m_linearVelocity += invMass1 * P1;
-		b1->m_angularVelocity += invI1 * L1;
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_linearVelocity += invMass1 * P1;
+			b1->m_angularVelocity += invI1 * L1;
+		}
 
-		b2->m_linearVelocity += invMass2 * P2;
-		b2->m_angularVelocity += invI2 * L2;
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_linearVelocity += invMass2 * P2;
+			b2->m_angularVelocity += invI2 * L2;
+		}
 	}
 	else
 	{
@@ -170,7 +176,7 @@ void b2PrismaticJoint::PrepareVelocitySolver()
 	m_limitPositionImpulse = 0.0f;
 }
 
-void b2PrismaticJoint::SolveVelocityConstraints(const b2TimeStep* step)
+float32 b2PrismaticJoint::SolveVelocityConstraints(const b2TimeStep* step)
 {
 	b2Body* b1 = m_body1;
 	b2Body* b2 = m_body2;
@@ -182,20 +188,34 @@ void b2PrismaticJoint::SolveVelocityConstraints(const b2TimeStep* step)
 	float32 linearCdot = m_linearJacobian.Compute(b1->m_linearVelocity, b1->m_angularVelocity, b2->m_linearVelocity, b2->m_angularVelocity);
 	float32 linearImpulse = -m_linearMass * linearCdot;
 	m_linearImpulse += linearImpulse;
+	float32 maxCorrection = b2Abs(linearImpulse) / m_linearMass;
 
-	b1->m_linearVelocity += (invMass1 * linearImpulse) * m_linearJacobian.linear1;
-	b1->m_angularVelocity += invI1 * linearImpulse * m_linearJacobian.angular1;
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_linearVelocity += (invMass1 * linearImpulse) * m_linearJacobian.linear1;
+		b1->m_angularVelocity += invI1 * linearImpulse * m_linearJacobian.angular1;
+	}
 
-	b2->m_linearVelocity += (invMass2 * linearImpulse) * m_linearJacobian.linear2;
-	b2->m_angularVelocity += invI2 * linearImpulse * m_linearJacobian.angular2;
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_linearVelocity += (invMass2 * linearImpulse) * m_linearJacobian.linear2;
+		b2->m_angularVelocity += invI2 * linearImpulse * m_linearJacobian.angular2;
+	}
 
 	// Solve angular constraint.
 	float32 angularCdot = b2->m_angularVelocity - b1->m_angularVelocity;
 	float32 angularImpulse = -m_angularMass * angularCdot;
 	m_angularImpulse += angularImpulse;
+	maxCorrection = b2Max(maxCorrection, b2LinearCorrection(b2Abs(angularImpulse) * (invI1 + invI2)));
 
-	b1->m_angularVelocity -= invI1 * angularImpulse;
-	b2->m_angularVelocity += invI2 * angularImpulse;
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_angularVelocity -= invI1 * angularImpulse;
+	}
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_angularVelocity += invI2 * angularImpulse;
+	}
 
 	// Solve linear motor constraint.
 	if (m_enableMotor && m_limitState != e_equalLimits)
@@ -205,12 +225,19 @@ void b2PrismaticJoint::SolveVelocityConstraints(const b2TimeStep* step)
 		float32 oldMotorImpulse = m_motorImpulse;
 		m_motorImpulse = b2Clamp(m_motorImpulse + motorImpulse, -step->dt * m_maxMotorForce, step->dt * m_maxMotorForce);
 		motorImpulse = m_motorImpulse - oldMotorImpulse;
+		maxCorrection = b2Max(maxCorrection, b2Abs(motorImpulse) / m_motorMass);
 
-		b1->m_linearVelocity += (invMass1 * motorImpulse) * m_motorJacobian.linear1;
-		b1->m_angularVelocity += invI1 * motorImpulse * m_motorJacobian.angular1;
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_linearVelocity += (invMass1 * motorImpulse) * m_motorJacobian.linear1;
+			b1->m_angularVelocity += invI1 * motorImpulse * m_motorJacobian.angular1;
+		}
 
-		b2->m_linearVelocity += (invMass2 * motorImpulse) * m_motorJacobian.linear2;
-		b2->m_angularVelocity += invI2 * motorImpulse * m_motorJacobian.angular2;
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_linearVelocity += (invMass2 * motorImpulse) * m_motorJacobian.linear2;
+			b2->m_angularVelocity += invI2 * motorImpulse * m_motorJacobian.angular2;
+		}
 	}
 
 	// Solve linear limit constraint.
@@ -235,13 +262,22 @@ void b2PrismaticJoint::SolveVelocityConstraints(const b2TimeStep* step)
 			m_limitImpulse = b2Min(m_limitImpulse + limitImpulse, 0.0f);
 			limitImpulse = m_limitImpulse - oldLimitImpulse;
 		}
+		maxCorrection = b2Max(maxCorrection, b2Abs(limitImpulse) / m_motorMass);
 
-		b1->m_linearVelocity += (invMass1 * limitImpulse) * m_motorJacobian.linear1;
-		b1->m_angularVelocity += invI1 * limitImpulse * m_motorJacobian.angular1;
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_linearVelocity += (invMass1 * limitImpulse) * m_motorJacobian.linear1;
+			b1->m_angularVelocity += invI1 * limitImpulse * m_motorJacobian.angular1;
+		}
 
-		b2->m_linearVelocity += (invMass2 * limitImpulse) * m_motorJacobian.linear2;
-		b2->m_angularVelocity += invI2 * limitImpulse * m_motorJacobian.angular2;
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_linearVelocity += (invMass2 * limitImpulse) * m_motorJacobian.linear2;
+			b2->m_angularVelocity += invI2 * limitImpulse * m_motorJacobian.angular2;
+		}
 	}
+
+	return maxCorrection;
 }
 
 bool b2PrismaticJoint::SolvePositionConstraints()
@@ -265,11 +301,17 @@ bool b2PrismaticJoint::SolvePositionConstraints()
 	linearC = b2Clamp(linearC, -b2_maxLinearCorrection, b2_maxLinearCorrection);
 	float32 linearImpulse = -m_linearMass * linearC;
 
-	b1->m_position += (invMass1 * linearImpulse) * m_linearJacobian.linear1;
-	b1->m_rotation += invI1 * linearImpulse * m_linearJacobian.angular1;
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_position += (invMass1 * linearImpulse) * m_linearJacobian.linear1;
+		b1->m_rotation += invI1 * linearImpulse * m_linearJacobian.angular1;
+	}
 	//b1->m_R.Set(b1->m_rotation); // updated by angular constraint
-	b2->m_position += (invMass2 * linearImpulse) * m_linearJacobian.linear2;
-	b2->m_rotation += invI2 * linearImpulse * m_linearJacobian.angular2;
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_position += (invMass2 * linearImpulse) * m_linearJacobian.linear2;
+		b2->m_rotation += invI2 * linearImpulse * m_linearJacobian.angular2;
+	}
 	//b2->m_R.Set(b2->m_rotation); // updated by angular constraint
 
 	float32 positionError = b2Abs(linearC);
@@ -280,10 +322,16 @@ bool b2PrismaticJoint::SolvePositionConstraints()
 	angularC = b2Clamp(angularC, -b2_maxAngularCorrection, b2_maxAngularCorrection);
 	float32 angularImpulse = -m_angularMass * angularC;
 
-	b1->m_rotation -= b1->m_invI * angularImpulse;
-	b1->m_R.Set(b1->m_rotation);
-	b2->m_rotation += b2->m_invI * angularImpulse;
-	b2->m_R.Set(b2->m_rotation);
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_rotation -= b1->m_invI * angularImpulse;
+		b1->m_R.Set(b1->m_rotation);
+	}
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_rotation += b2->m_invI * angularImpulse;
+		b2->m_R.Set(b2->m_rotation);
+	}
 
 	float32 angularError = b2Abs(angularC);
 
@@ -332,12 +380,18 @@ bool b2PrismaticJoint::SolvePositionConstraints()
 			limitImpulse = m_limitPositionImpulse - oldLimitImpulse;
 		}
 
-		b1->m_position += (invMass1 * limitImpulse) * m_motorJacobian.linear1;
-		b1->m_rotation += invI1 * limitImpulse * m_motorJacobian.angular1;
-		b1->m_R.Set(b1->m_rotation);
-		b2->m_position += (invMass2 * limitImpulse) * m_motorJacobian.linear2;
-		b2->m_rotation += invI2 * limitImpulse * m_motorJacobian.angular2;
-		b2->m_R.Set(b2->m_rotation);
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_position += (invMass1 * limitImpulse) * m_motorJacobian.linear1;
+			b1->m_rotation += invI1 * limitImpulse * m_motorJacobian.angular1;
+			b1->m_R.Set(b1->m_rotation);
+		}
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_position += (invMass2 * limitImpulse) * m_motorJacobian.linear2;
+			b2->m_rotation += invI2 * limitImpulse * m_motorJacobian.angular2;
+			b2->m_R.Set(b2->m_rotation);
+		}
 	}
 
 	return positionError <= b2_linearSlop && angularError <= b2_angularSlop;
@@ -66,7 +66,7 @@ b2PulleyJoint::b2PulleyJoint(const b2PulleyJointDef* def)
 	m_limitImpulse2 = 0.0f;
 }
 
-void b2PulleyJoint::PrepareVelocitySolver()
+void b2PulleyJoint::PrepareVelocitySolver(const b2TimeStep* /*step*/)
 {
 	b2Body* b1 = m_body1;
 	b2Body* b2 = m_body2;
@@ -144,13 +144,19 @@ void b2PulleyJoint::PrepareVelocitySolver()
 	// Warm starting.
 	b2Vec2 P1 = (-m_pulleyImpulse - m_limitImpulse1) * m_u1;
 	b2Vec2 P2 = (-m_ratio * m_pulleyImpulse - m_limitImpulse2) * m_u2;
-	b1->m_linearVelocity += b1->m_invMass * P1;
-	b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
-	b2->m_linearVelocity += b2->m_invMass * P2;
-	b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_linearVelocity += b1->m_invMass * P1;
+		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+	}
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_linearVelocity += b2->m_invMass * P2;
+		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+	}
 }
 
-void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep* step)
+float32 b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep* step)
 {
 	NOT_USED(step);
 
@@ -160,6 +166,7 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep* step)
 	b2Vec2 r1 = b2Mul(b1->m_R, m_localAnchor1);
 	b2Vec2 r2 = b2Mul(b2->m_R, m_localAnchor2);
 
+	float32 maxCorrection;
 	{
 		b2Vec2 v1 = b1->m_linearVelocity + b2Cross(b1->m_angularVelocity, r1);
 		b2Vec2 v2 = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2);
@@ -167,13 +174,20 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep* step)
 		float32 Cdot = -b2Dot(m_u1, v1) - m_ratio * b2Dot(m_u2, v2);
 		float32 impulse = -m_pulleyMass * Cdot;
 		m_pulleyImpulse += impulse;
+		maxCorrection = b2Abs(impulse) / m_pulleyMass;
 
 		b2Vec2 P1 = -impulse * m_u1;
 		b2Vec2 P2 = -m_ratio * impulse * m_u2;
-		b1->m_linearVelocity += b1->m_invMass * P1;
-		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
-		b2->m_linearVelocity += b2->m_invMass * P2;
-		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_linearVelocity += b1->m_invMass * P1;
+			b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+		}
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_linearVelocity += b2->m_invMass * P2;
+			b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		}
 	}
 
 	if (m_limitState1 == e_atUpperLimit)
@@ -184,9 +198,13 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep* step)
 		float32 oldLimitImpulse = m_limitImpulse1;
 		m_limitImpulse1 = b2Max(0.0f, m_limitImpulse1 + impulse);
 		impulse = m_limitImpulse1 - oldLimitImpulse;
+		maxCorrection = b2Max(maxCorrection, b2Abs(impulse) / m_limitMass1);
 		b2Vec2 P1 = -impulse * m_u1;
-		b1->m_linearVelocity += b1->m_invMass * P1;
-		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_linearVelocity += b1->m_invMass * P1;
+			b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+		}
 	}
 
 	if (m_limitState2 == e_atUpperLimit)
@@ -197,10 +215,16 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep* step)
 		float32 oldLimitImpulse = m_limitImpulse2;
 		m_limitImpulse2 = b2Max(0.0f, m_limitImpulse2 + impulse);
 		impulse = m_limitImpulse2 - oldLimitImpulse;
+		maxCorrection = b2Max(maxCorrection, b2Abs(impulse) / m_limitMass2);
 		b2Vec2 P2 = -impulse * m_u2;
-		b2->m_linearVelocity += b2->m_invMass * P2;
-		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_linearVelocity += b2->m_invMass * P2;
+			b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		}
 	}
+
+	return maxCorrection;
 }
 
 bool b2PulleyJoint::SolvePositionConstraints()
@@ -253,13 +277,18 @@ bool b2PulleyJoint::SolvePositionConstraints()
 		b2Vec2 P1 = -impulse * m_u1;
 		b2Vec2 P2 = -m_ratio * impulse * m_u2;
 
-		b1->m_position += b1->m_invMass * P1;
-		b1->m_rotation += b1->m_invI * b2Cross(r1, P1);
-		b2->m_position += b2->m_invMass * P2;
-		b2->m_rotation += b2->m_invI * b2Cross(r2, P2);
-
-		b1->m_R.Set(b1->m_rotation);
-		b2->m_R.Set(b2->m_rotation);
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_position += b1->m_invMass * P1;
+			b1->m_rotation += b1->m_invI * b2Cross(r1, P1);
+			b1->m_R.Set(b1->m_rotation);
+		}
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_position += b2->m_invMass * P2;
+			b2->m_rotation += b2->m_invI * b2Cross(r2, P2);
+			b2->m_R.Set(b2->m_rotation);
+		}
 	}
 
 	if (m_limitState1 == e_atUpperLimit)
@@ -288,9 +317,12 @@ bool b2PulleyJoint::SolvePositionConstraints()
 		impulse = m_limitPositionImpulse1 - oldLimitPositionImpulse;
 
 		b2Vec2 P1 = -impulse * m_u1;
-		b1->m_position += b1->m_invMass * P1;
-		b1->m_rotation += b1->m_invI * b2Cross(r1, P1);
-		b1->m_R.Set(b1->m_rotation);
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_position += b1->m_invMass * P1;
+			b1->m_rotation += b1->m_invI * b2Cross(r1, P1);
+			b1->m_R.Set(b1->m_rotation);
+		}
 	}
 
 	if (m_limitState2 == e_atUpperLimit)
@@ -319,9 +351,12 @@ bool b2PulleyJoint::SolvePositionConstraints()
 		impulse = m_limitPositionImpulse2 - oldLimitPositionImpulse;
 
 		b2Vec2 P2 = -impulse * m_u2;
-		b2->m_position += b2->m_invMass * P2;
-		b2->m_rotation += b2->m_invI * b2Cross(r2, P2);
-		b2->m_R.Set(b2->m_rotation);
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_position += b2->m_invMass * P2;
+			b2->m_rotation += b2->m_invI * b2Cross(r2, P2);
+			b2->m_R.Set(b2->m_rotation);
+		}
 	}
 
 	return linearError < b2_linearSlop;
@@ -76,8 +76,8 @@ public:
 
 	b2PulleyJoint(const b2PulleyJointDef* data);
 
-	void PrepareVelocitySolver();
-	void SolveVelocityConstraints(const b2TimeStep* step);
+	void PrepareVelocitySolver(const b2TimeStep* step);
+	float32 SolveVelocityConstraints(const b2TimeStep* step);
 	bool SolvePositionConstraints();
 
 	b2Body* m_ground;
@@ -56,7 +56,7 @@ b2RevoluteJoint::b2RevoluteJoint(const b2RevoluteJointDef* def)
 	m_enableMotor = def->enableMotor;
 }
 
-void b2RevoluteJoint::PrepareVelocitySolver()
+void b2RevoluteJoint::PrepareVelocitySolver(const b2TimeStep* step)
 {
 	b2Body* b1 = m_body1;
 	b2Body* b2 = m_body2;
@@ -127,13 +127,19 @@ void b2RevoluteJoint::PrepareVelocitySolver()
 		m_limitImpulse = 0.0f;
 	}
 
-	if (b2World::s_enableWarmStarting)
+	if (step->warmStarting)
 	{
-		b1->m_linearVelocity -= invMass1 * m_ptpImpulse;
-		b1->m_angularVelocity -= invI1 * (b2Cross(r1, m_ptpImpulse) + m_motorImpulse + m_limitImpulse);
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_linearVelocity -= invMass1 * m_ptpImpulse;
+			b1->m_angularVelocity -= invI1 * (b2Cross(r1, m_ptpImpulse) + m_motorImpulse + m_limitImpulse);
+		}
 
-		b2->m_linearVelocity += invMass2 * m_ptpImpulse;
-		b2->m_angularVelocity += invI2 * (b2Cross(r2, m_ptpImpulse) + m_motorImpulse + m_limitImpulse);
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_linearVelocity += invMass2 * m_ptpImpulse;
+			b2->m_angularVelocity += invI2 * (b2Cross(r2, m_ptpImpulse) + m_motorImpulse + m_limitImpulse);
+		}
 	}
 	else
 	{
@@ -145,7 +151,7 @@ void b2RevoluteJoint::PrepareVelocitySolver()
 	m_limitPositionImpulse = 0.0f;
 }
 
-void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep* step)
+float32 b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep* step)
 {
 	b2Body* b1 = m_body1;
 	b2Body* b2 = m_body2;
@@ -157,12 +163,19 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep* step)
 	b2Vec2 ptpCdot = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2) - b1->m_linearVelocity - b2Cross(b1->m_angularVelocity, r1);
 	b2Vec2 ptpImpulse = -b2Mul(m_ptpMass, ptpCdot);
 	m_ptpImpulse += ptpImpulse;
+	float32 maxCorrection = ptpImpulse.Length() * (b1->m_invMass + b2->m_invMass);
 
-	b1->m_linearVelocity -= b1->m_invMass * ptpImpulse;
-	b1->m_angularVelocity -= b1->m_invI * b2Cross(r1, ptpImpulse);
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_linearVelocity -= b1->m_invMass * ptpImpulse;
+		b1->m_angularVelocity -= b1->m_invI * b2Cross(r1, ptpImpulse);
+	}
 
-	b2->m_linearVelocity += b2->m_invMass * ptpImpulse;
-	b2->m_angularVelocity += b2->m_invI * b2Cross(r2, ptpImpulse);
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_linearVelocity += b2->m_invMass * ptpImpulse;
+		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, ptpImpulse);
+	}
 
 	if (m_enableMotor && m_limitState != e_equalLimits)
 	{
@@ -171,8 +184,15 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep* step)
 		float32 oldMotorImpulse = m_motorImpulse;
 		m_motorImpulse = b2Clamp(m_motorImpulse + motorImpulse, -step->dt * m_maxMotorTorque, step->dt * m_maxMotorTorque);
 		motorImpulse = m_motorImpulse - oldMotorImpulse;
-		b1->m_angularVelocity -= b1->m_invI * motorImpulse;
-		b2->m_angularVelocity += b2->m_invI * motorImpulse;
+		maxCorrection = b2Max(maxCorrection, b2LinearCorrection(b2Abs(motorImpulse) * (b1->m_invI + b2->m_invI)));
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_angularVelocity -= b1->m_invI * motorImpulse;
+		}
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_angularVelocity += b2->m_invI * motorImpulse;
+		}
 	}
 
 	if (m_enableLimit && m_limitState != e_inactiveLimit)
@@ -196,10 +216,19 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep* step)
 			m_limitImpulse = b2Min(m_limitImpulse + limitImpulse, 0.0f);
 			limitImpulse = m_limitImpulse - oldLimitImpulse;
 		}
+		maxCorrection = b2Max(maxCorrection, b2LinearCorrection(b2Abs(limitImpulse) * (b1->m_invI + b2->m_invI)));
 
-		b1->m_angularVelocity -= b1->m_invI * limitImpulse;
-		b2->m_angularVelocity += b2->m_invI * limitImpulse;
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_angularVelocity -= b1->m_invI * limitImpulse;
+		}
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_angularVelocity += b2->m_invI * limitImpulse;
+		}
 	}
+
+	return maxCorrection;
 }
 
 bool b2RevoluteJoint::SolvePositionConstraints()
@@ -241,13 +270,19 @@ bool b2RevoluteJoint::SolvePositionConstraints()
 	b2Mat22 K = K1 + K2 + K3;
 	b2Vec2 impulse = K.Solve(-ptpC);
 
-	b1->m_position -= b1->m_invMass * impulse;
-	b1->m_rotation -= b1->m_invI * b2Cross(r1, impulse);
-	b1->m_R.Set(b1->m_rotation);
+	if (b1->m_invMass != 0.0f)
+	{
+		b1->m_position -= b1->m_invMass * impulse;
+		b1->m_rotation -= b1->m_invI * b2Cross(r1, impulse);
+		b1->m_R.Set(b1->m_rotation);
+	}
 
-	b2->m_position += b2->m_invMass * impulse;
-	b2->m_rotation += b2->m_invI * b2Cross(r2, impulse);
-	b2->m_R.Set(b2->m_rotation);
+	if (b2->m_invMass != 0.0f)
+	{
+		b2->m_position += b2->m_invMass * impulse;
+		b2->m_rotation += b2->m_invI * b2Cross(r2, impulse);
+		b2->m_R.Set(b2->m_rotation);
+	}
 
 	// Handle limits.
 	float32 angularError = 0.0f;
@@ -289,10 +324,16 @@ bool b2RevoluteJoint::SolvePositionConstraints()
 			limitImpulse = m_limitPositionImpulse - oldLimitImpulse;
 		}
 
-		b1->m_rotation -= b1->m_invI * limitImpulse;
-		b1->m_R.Set(b1->m_rotation);
-		b2->m_rotation += b2->m_invI * limitImpulse;
-		b2->m_R.Set(b2->m_rotation);
+		if (b1->m_invMass != 0.0f)
+		{
+			b1->m_rotation -= b1->m_invI * limitImpulse;
+			b1->m_R.Set(b1->m_rotation);
+		}
+		if (b2->m_invMass != 0.0f)
+		{
+			b2->m_rotation += b2->m_invI * limitImpulse;
+			b2->m_R.Set(b2->m_rotation);
+		}
 	}
 
 	return positionError <= b2_linearSlop && angularError <= b2_angularSlop;
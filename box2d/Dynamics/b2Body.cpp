@@ -25,6 +25,7 @@
 b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 {
 	m_flags = 0;
+	m_islandIndex = 0;
 	m_position = bd->position;
 	m_rotation = bd->rotation;
 	m_R.Set(m_rotation);
@@ -32,6 +33,10 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_rotation0 = m_rotation;
 	m_world = world;
 
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
+
 	m_linearDamping = b2Clamp(1.0f - bd->linearDamping, 0.0f, 1.0f);
 	m_angularDamping = b2Clamp(1.0f - bd->angularDamping, 0.0f, 1.0f);
 
@@ -103,7 +108,7 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 
 	m_jointList = NULL;
 	m_contactList = NULL;
-	m_prev = NULL;
+	m_worldIndex = -1;
 	m_next = NULL;
 
 	// Create the shapes.
@@ -191,6 +196,38 @@ void b2Body::SetCenterPosition(const b2Vec2& position, float rotation)
 	m_world->m_broadPhase->Commit();
 }
 
+void b2Body::WakeUp()
+{
+	m_flags &= ~e_sleepFlag;
+	m_sleepTime = 0.0f;
+
+	// The rest of the island is woken when it is solved.
+	if (m_island)
+	{
+		m_world->m_islandManager.WakeIsland(m_island);
+	}
+}
+
+void b2Body::PutToSleep()
+{
+	m_flags |= e_sleepFlag;
+
+	if (m_island == NULL || m_island->awake == false)
+	{
+		return;
+	}
+
+	for (b2Body* b = m_island->bodyList; b; b = b->m_islandNext)
+	{
+		if ((b->m_flags & e_sleepFlag) == 0)
+		{
+			return;
+		}
+	}
+
+	m_world->m_islandManager.SleepIsland(m_island);
+}
+
 void b2Body::SynchronizeShapes()
 {
 	b2Mat22 R0(m_rotation0);
@@ -29,6 +29,7 @@ class b2Joint;
 class b2Contact;
 class b2World;
 struct b2JointNode;
+struct b2PersistentIsland;
 struct b2ContactNode;
 
 struct b2BodyDef
@@ -141,6 +142,10 @@ public:
 	// Wake up this body so it will begin simulating.
 	void WakeUp();
 
+	// Put this body to sleep, e.g. to restore a stored state. Its island
+	// sleeps once all of its bodies do.
+	void PutToSleep();
+
 	// Get the list of all shapes attached to this body.
 	b2Shape* GetShapeList();
 
@@ -150,9 +155,6 @@ public:
 	// Get the list of all joints attached to this body.
 	b2JointNode* GetJointList();
 
-	// Get the next body in the world's body list.
-	b2Body* GetNext();
-
 	void* GetUserData();
 
 	//--------------- Internals Below -------------------
@@ -166,6 +168,7 @@ public:
 		e_sleepFlag			= 0x0008,
 		e_allowSleepFlag	= 0x0010,
 		e_destroyFlag		= 0x0020,
+		e_resetProxyFlag	= 0x0040,	// proxies are reset by b2World::EndJointBatch
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
@@ -182,6 +185,7 @@ public:
 	void Freeze();
 
 	uint32 m_flags;
+	int32 m_islandIndex;	// set by islands solving colored constraints
 
 	b2Vec2 m_position;	// center of mass position
 	float32 m_rotation;
@@ -200,8 +204,13 @@ public:
 	b2Vec2 m_center;	// local vector from client origin to center of mass
 
 	b2World* m_world;
-	b2Body* m_prev;
-	b2Body* m_next;
+	int32 m_worldIndex;	// in b2World::m_bodies, -1 once destroyed
+	b2Body* m_next;		// deferred destruction list
+
+	// Persistent island list, NULL for static bodies.
+	b2PersistentIsland* m_island;
+	b2Body* m_islandPrev;
+	b2Body* m_islandNext;
 
 	b2Shape* m_shapeList;
 	int32 m_shapeCount;
@@ -356,12 +365,6 @@ inline void b2Body::AllowSleeping(bool flag)
 	}
 }
 
-inline void b2Body::WakeUp()
-{
-	m_flags &= ~e_sleepFlag;
-	m_sleepTime = 0.0f;
-}
-
 inline b2Shape* b2Body::GetShapeList()
 {
 	return m_shapeList;
@@ -377,11 +380,6 @@ inline b2JointNode* b2Body::GetJointList()
 	return m_jointList;
 }
 
-inline b2Body* b2Body::GetNext()
-{
-	return m_next;
-}
-
 inline void* b2Body::GetUserData()
 {
 	return m_userData;
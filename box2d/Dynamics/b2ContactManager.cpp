@@ -19,6 +19,25 @@
 #include "b2ContactManager.h"
 #include "b2World.h"
 #include "b2Body.h"
+#include <memory.h>
+
+// Evaluates gathered contacts, a chunk of them per task index.
+class b2NarrowPhase : public b2Task
+{
+public:
+	void Execute(int32 index, int32 /*threadIndex*/)
+	{
+		int32 start = index * b2_contactChunkSize;
+		int32 end = b2Min(start + b2_contactChunkSize, count);
+		for (int32 i = start; i < end; ++i)
+		{
+			contacts[i]->Evaluate();
+		}
+	}
+
+	b2Contact** contacts;
+	int32 count;
+};
 
 // This is a callback from the broadphase when two AABB proxies begin
 // to overlap. We create a b2Contact to manage the narrow phase.
@@ -67,14 +86,19 @@ void* b2ContactManager::PairAdded(void* proxyUserData1, void* proxyUserData2)
 	else
 	{
 		// Insert into the world.
-		contact->m_prev = NULL;
-		contact->m_next = m_world->m_contactList;
-		if (m_world->m_contactList != NULL)
+		b2World* world = m_world;
+		if (world->m_contactCount == world->m_contactCapacity)
 		{
-			m_world->m_contactList->m_prev = contact;
+			b2Contact** oldContacts = world->m_contacts;
+			world->m_contactCapacity *= 2;
+			world->m_contacts = (b2Contact**)b2Alloc(world->m_contactCapacity * sizeof(b2Contact*));
+			memcpy(world->m_contacts, oldContacts, world->m_contactCount * sizeof(b2Contact*));
+			b2Free(oldContacts);
 		}
-		m_world->m_contactList = contact;
-		++m_world->m_contactCount;
+
+		contact->m_worldIndex = world->m_contactCount;
+		world->m_contacts[world->m_contactCount] = contact;
+		++world->m_contactCount;
 	}
 
 	return contact;
@@ -105,6 +129,7 @@ void b2ContactManager::PairRemoved(void* proxyUserData1, void* proxyUserData2, v
 		else
 		{
 			c->m_flags |= b2Contact::e_destroyFlag;
+			++m_destroyCount;
 		}
 	}
 }
@@ -113,21 +138,12 @@ void b2ContactManager::DestroyContact(b2Contact* c)
 {
 	b2Assert(m_world->m_contactCount > 0);
 
-	// Remove from the world.
-	if (c->m_prev)
-	{
-		c->m_prev->m_next = c->m_next;
-	}
-
-	if (c->m_next)
-	{
-		c->m_next->m_prev = c->m_prev;
-	}
-
-	if (c == m_world->m_contactList)
-	{
-		m_world->m_contactList = c->m_next;
-	}
+	// Remove from the world, the last contact takes its place.
+	b2World* world = m_world;
+	b2Assert(0 <= c->m_worldIndex && c->m_worldIndex < world->m_contactCount);
+	b2Contact* last = world->m_contacts[world->m_contactCount - 1];
+	world->m_contacts[c->m_worldIndex] = last;
+	last->m_worldIndex = c->m_worldIndex;
 
 	// If there are contact points, then disconnect from the island graph.
 	if (c->GetManifoldCount() > 0)
@@ -139,6 +155,8 @@ void b2ContactManager::DestroyContact(b2Contact* c)
 		body1->WakeUp();
 		body2->WakeUp();
 
+		m_world->m_islandManager.RemoveContact(c);
+
 		// Remove from body 1
 		if (c->m_node1.prev)
 		{
@@ -180,24 +198,34 @@ void b2ContactManager::DestroyContact(b2Contact* c)
 
 	// Call the factory.
 	b2Contact::Destroy(c, &m_world->m_blockAllocator);
-	--m_world->m_contactCount;
+	--world->m_contactCount;
 }
 
 // Destroy any contacts marked for deferred destruction.
 void b2ContactManager::CleanContactList()
 {
-	b2Contact* c = m_world->m_contactList;
-	while (c != NULL)
+	if (m_destroyCount == 0)
 	{
-		b2Contact* c0 = c;
-		c = c->m_next;
+		return;
+	}
 
-		if (c0->m_flags & b2Contact::e_destroyFlag)
+	// A destroyed contact is replaced by the last one, which is checked next.
+	int32 i = 0;
+	while (i < m_world->m_contactCount)
+	{
+		b2Contact* c = m_world->m_contacts[i];
+		if (c->m_flags & b2Contact::e_destroyFlag)
+		{
+			DestroyContact(c);
+			c = NULL;
+		}
+		else
 		{
-			DestroyContact(c0);
-			c0 = NULL;
+			++i;
 		}
 	}
+
+	m_destroyCount = 0;
 }
 
 // This is the top level collision call for the time step. Here
@@ -205,17 +233,56 @@ void b2ContactManager::CleanContactList()
 // contact list.
 void b2ContactManager::Collide()
 {
-	for (b2Contact* c = m_world->m_contactList; c; c = c->m_next)
+	b2StackAllocator* allocator = &m_world->m_stackAllocator;
+	int32 maxCount = b2Max(m_world->m_contactCount, 1);
+	b2Contact** contacts = (b2Contact**)allocator->Allocate(maxCount * sizeof(b2Contact*));
+	int32* oldCounts = (int32*)allocator->Allocate(maxCount * sizeof(int32));
+
+	// Gather the awake contacts. Evaluating one only touches its own manifold.
+	// Static bodies do not move, they count as sleeping here.
+	int32 count = 0;
+	b2Contact** worldContacts = m_world->m_contacts;
+	int32 worldCount = m_world->m_contactCount;
+	for (int32 i = 0; i < worldCount; ++i)
 	{
-		if (c->m_shape1->m_body->IsSleeping() &&
-			c->m_shape2->m_body->IsSleeping())
+		b2Contact* c = worldContacts[i];
+		b2Body* body1 = c->m_shape1->m_body;
+		b2Body* body2 = c->m_shape2->m_body;
+		if ((body1->IsSleeping() || body1->IsStatic()) &&
+			(body2->IsSleeping() || body2->IsStatic()))
 		{
 			continue;
 		}
 
-		int32 oldCount = c->GetManifoldCount();
-		c->Evaluate();
+		b2Assert(count < maxCount);
+		contacts[count] = c;
+		oldCounts[count] = c->GetManifoldCount();
+		++count;
+	}
+
+	b2NarrowPhase narrowPhase;
+	narrowPhase.contacts = contacts;
+	narrowPhase.count = count;
 
+	int32 chunkCount = (count + b2_contactChunkSize - 1) / b2_contactChunkSize;
+	b2TaskDispatcher* dispatcher = m_world->m_taskDispatcher;
+	if (dispatcher && dispatcher->GetThreadCount() > 1 && chunkCount > 1)
+	{
+		dispatcher->Run(&narrowPhase, chunkCount);
+	}
+	else
+	{
+		for (int32 i = 0; i < chunkCount; ++i)
+		{
+			narrowPhase.Execute(i, 0);
+		}
+	}
+
+	// Link and unlink the body contact lists in list order.
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Contact* c = contacts[i];
+		int32 oldCount = oldCounts[i];
 		int32 newCount = c->GetManifoldCount();
 
 		if (oldCount == 0 && newCount > 0)
@@ -249,6 +316,8 @@ void b2ContactManager::Collide()
 				c->m_node2.next->prev = &c->m_node2;
 			}
 			body2->m_contactList = &c->m_node2;
+
+			m_world->m_islandManager.AddContact(c);
 		}
 		else if (oldCount > 0 && newCount == 0)
 		{
@@ -256,6 +325,8 @@ void b2ContactManager::Collide()
 			b2Body* body1 = c->m_shape1->m_body;
 			b2Body* body2 = c->m_shape2->m_body;
 
+			m_world->m_islandManager.RemoveContact(c);
+
 			// Remove from body 1
 			if (c->m_node1.prev)
 			{
@@ -295,4 +366,7 @@ void b2ContactManager::Collide()
 			c->m_node2.next = NULL;
 		}
 	}
+
+	allocator->Free(oldCounts);
+	allocator->Free(contacts);
 }
\ No newline at end of file
@@ -28,7 +28,7 @@ class b2Contact;
 class b2ContactManager : public b2PairCallback
 {
 public:
-	b2ContactManager() : m_world(NULL), m_destroyImmediate(false) {}
+	b2ContactManager() : m_world(NULL), m_destroyImmediate(false), m_destroyCount(0) {}
 
 	// Implements PairCallback
 	void* PairAdded(void* proxyUserData1, void* proxyUserData2);
@@ -49,6 +49,9 @@ public:
 	b2NullContact m_nullContact;
 
 	bool m_destroyImmediate;
+
+	// Contacts flagged for destruction at the next step.
+	int32 m_destroyCount;
 };
 
 #endif
@@ -23,6 +23,8 @@
 #include "Contacts/b2ContactSolver.h"
 #include "Joints/b2Joint.h"
 #include "../Common/b2StackAllocator.h"
+#include "b2WorldCallbacks.h"
+#include <new>
 
 /*
 Position Correction Notes
@@ -103,8 +105,6 @@ probably default to the slower Full NGS and let the user select the faster
 Baumgarte method in performance critical scenarios.
 */
 
-int32 b2Island::m_positionIterationCount = 0;
-
 b2Island::b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity, b2StackAllocator* allocator)
 {
 	m_bodyCapacity = bodyCapacity;
@@ -113,16 +113,44 @@ b2Island::b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacit
 	m_bodyCount = 0;
 	m_contactCount = 0;
 	m_jointCount = 0;
+	m_velocityIterationCount = 0;
+	m_positionIterationCount = 0;
 
 	m_bodies = (b2Body**)allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
 	m_joints = (b2Joint**)allocator->Allocate(jointCapacity * sizeof(b2Joint*));
 
 	m_allocator = allocator;
+	m_ownsArrays = true;
+}
+
+b2Island::b2Island(b2Body** bodies, int32 bodyCount, b2Contact** contacts, int32 contactCount,
+				   b2Joint** joints, int32 jointCount, b2StackAllocator* allocator)
+{
+	m_bodyCapacity = bodyCount;
+	m_contactCapacity = contactCount;
+	m_jointCapacity = jointCount;
+	m_bodyCount = bodyCount;
+	m_contactCount = contactCount;
+	m_jointCount = jointCount;
+	m_velocityIterationCount = 0;
+	m_positionIterationCount = 0;
+
+	m_bodies = bodies;
+	m_contacts = contacts;
+	m_joints = joints;
+
+	m_allocator = allocator;
+	m_ownsArrays = false;
 }
 
 b2Island::~b2Island()
 {
+	if (m_ownsArrays == false)
+	{
+		return;
+	}
+
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_joints);
 	m_allocator->Free(m_contacts);
@@ -136,7 +164,349 @@ void b2Island::Clear()
 	m_jointCount = 0;
 }
 
-void b2Island::Solve(const b2TimeStep* step, const b2Vec2& gravity)
+// Constraints of a large island, split in batches by greedy graph coloring.
+// No two constraints of a color share a dynamic body, so each color is solved
+// on all dispatcher threads at once. The order depends only on the island,
+// never on the number of threads.
+class b2ConstraintColoring : public b2Task
+{
+public:
+	b2ConstraintColoring(b2Island* island, b2ContactSolver* contactSolver,
+						 const b2TimeStep* step, b2TaskDispatcher* dispatcher);
+	~b2ConstraintColoring();
+
+	float32 SolveVelocityConstraints();	// returns the largest velocity correction
+	bool SolvePositionConstraints();
+
+	void Execute(int32 index, int32 threadIndex);
+
+private:
+	struct Batch
+	{
+		int32 contactStart, contactCount;
+		int32 jointStart, jointCount;
+		int32 wideStart;	// colored contacts, four per wide constraint
+	};
+
+	static int32 Color(uint32* bodyColors, b2Body* body1, b2Body* body2);
+	void Solve(const Batch* batch, bool parallel);
+
+	b2Island* m_island;
+	b2ContactSolver* m_contactSolver;
+	const b2TimeStep* m_step;
+	b2TaskDispatcher* m_dispatcher;
+
+	int32* m_contactOrder;
+	int32* m_jointOrder;
+	Batch m_batches[b2_maxConstraintColors + 1];	// the last one holds uncolored constraints
+	b2WideContactConstraint* m_wideConstraints;
+	int32 m_wideCount;
+
+	int32 m_threadCount;
+	float32* m_maxCorrections;	// per thread
+	float32* m_minSeparations;	// per thread
+	bool* m_jointsOkay;			// per thread
+
+	const Batch* m_batch;
+	bool m_positionPhase;
+};
+
+b2ConstraintColoring::b2ConstraintColoring(b2Island* island, b2ContactSolver* contactSolver,
+										   const b2TimeStep* step, b2TaskDispatcher* dispatcher)
+{
+	m_island = island;
+	m_contactSolver = contactSolver;
+	m_step = step;
+	m_dispatcher = dispatcher;
+	m_threadCount = dispatcher ? dispatcher->GetThreadCount() : 1;
+	m_batch = NULL;
+	m_positionPhase = false;
+
+	int32 contactCount = contactSolver->m_constraintCount;
+	int32 jointCount = island->m_jointCount;
+	int32 bodyCount = island->m_bodyCount;
+	b2StackAllocator* allocator = island->m_allocator;
+
+	m_contactOrder = (int32*)allocator->Allocate(b2Max(contactCount, 1) * sizeof(int32));
+	m_jointOrder = (int32*)allocator->Allocate(b2Max(jointCount, 1) * sizeof(int32));
+	m_maxCorrections = (float32*)allocator->Allocate(m_threadCount * sizeof(float32));
+	m_minSeparations = (float32*)allocator->Allocate(m_threadCount * sizeof(float32));
+	m_jointsOkay = (bool*)allocator->Allocate(m_threadCount * sizeof(bool));
+
+	uint32* bodyColors = (uint32*)allocator->Allocate(b2Max(bodyCount, 1) * sizeof(uint32));
+	int32* colors = (int32*)allocator->Allocate(b2Max(contactCount + jointCount, 1) * sizeof(int32));
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		island->m_bodies[i]->m_islandIndex = i;
+		bodyColors[i] = 0;
+	}
+
+	for (int32 i = 0; i <= b2_maxConstraintColors; ++i)
+	{
+		m_batches[i].contactCount = 0;
+		m_batches[i].jointCount = 0;
+	}
+
+	for (int32 i = 0; i < contactCount; ++i)
+	{
+		b2ContactConstraint* c = contactSolver->m_constraints + i;
+		colors[i] = Color(bodyColors, c->body1, c->body2);
+		++m_batches[colors[i]].contactCount;
+	}
+
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		// A gear joint reads the bodies of two other joints, keep it serial.
+		b2Joint* joint = island->m_joints[i];
+		int32 color = b2_maxConstraintColors;
+		if (joint->m_type != e_gearJoint)
+		{
+			color = Color(bodyColors, joint->m_body1, joint->m_body2);
+		}
+		colors[contactCount + i] = color;
+		++m_batches[color].jointCount;
+	}
+
+	// Sort the constraints by color, keeping the island order within a color.
+	int32 contactStart = 0;
+	int32 jointStart = 0;
+	for (int32 i = 0; i <= b2_maxConstraintColors; ++i)
+	{
+		m_batches[i].contactStart = contactStart;
+		m_batches[i].jointStart = jointStart;
+		contactStart += m_batches[i].contactCount;
+		jointStart += m_batches[i].jointCount;
+		m_batches[i].contactCount = 0;
+		m_batches[i].jointCount = 0;
+	}
+
+	for (int32 i = 0; i < contactCount; ++i)
+	{
+		Batch* batch = m_batches + colors[i];
+		m_contactOrder[batch->contactStart + batch->contactCount++] = i;
+	}
+
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		Batch* batch = m_batches + colors[contactCount + i];
+		m_jointOrder[batch->jointStart + batch->jointCount++] = i;
+	}
+
+	allocator->Free(colors);
+	allocator->Free(bodyColors);
+
+	// Contacts of one color share no dynamic body, so they fill SIMD lanes.
+	m_wideConstraints = NULL;
+	m_wideCount = 0;
+#ifdef B2_SIMD_CONTACTS
+	for (int32 i = 0; i < b2_maxConstraintColors; ++i)
+	{
+		m_batches[i].wideStart = m_wideCount;
+		m_wideCount += (m_batches[i].contactCount + 3) / 4;
+	}
+
+	m_wideConstraints = (b2WideContactConstraint*)allocator->Allocate(b2Max(m_wideCount, 1) * sizeof(b2WideContactConstraint));
+	for (int32 i = 0; i < b2_maxConstraintColors; ++i)
+	{
+		const Batch* batch = m_batches + i;
+		for (int32 j = 0; j < batch->contactCount; j += 4)
+		{
+			b2WideContactConstraint* wide = m_wideConstraints + batch->wideStart + j / 4;
+			contactSolver->GatherWide(wide, m_contactOrder + batch->contactStart + j, b2Min(batch->contactCount - j, 4));
+		}
+	}
+#endif
+}
+
+b2ConstraintColoring::~b2ConstraintColoring()
+{
+	b2StackAllocator* allocator = m_island->m_allocator;
+#ifdef B2_SIMD_CONTACTS
+	for (int32 i = 0; i < m_wideCount; ++i)
+	{
+		m_contactSolver->ScatterWide(m_wideConstraints + i);
+	}
+	allocator->Free(m_wideConstraints);
+#endif
+	allocator->Free(m_jointsOkay);
+	allocator->Free(m_minSeparations);
+	allocator->Free(m_maxCorrections);
+	allocator->Free(m_jointOrder);
+	allocator->Free(m_contactOrder);
+}
+
+// Returns the lowest color not used by the dynamic bodies, and marks it used.
+int32 b2ConstraintColoring::Color(uint32* bodyColors, b2Body* body1, b2Body* body2)
+{
+	uint32 used = 0;
+	if (body1->m_invMass != 0.0f)
+	{
+		used |= bodyColors[body1->m_islandIndex];
+	}
+	if (body2->m_invMass != 0.0f)
+	{
+		used |= bodyColors[body2->m_islandIndex];
+	}
+
+	for (int32 color = 0; color < b2_maxConstraintColors; ++color)
+	{
+		uint32 bit = 1u << color;
+		if (used & bit)
+		{
+			continue;
+		}
+
+		if (body1->m_invMass != 0.0f)
+		{
+			bodyColors[body1->m_islandIndex] |= bit;
+		}
+		if (body2->m_invMass != 0.0f)
+		{
+			bodyColors[body2->m_islandIndex] |= bit;
+		}
+		return color;
+	}
+
+	return b2_maxConstraintColors;
+}
+
+float32 b2ConstraintColoring::SolveVelocityConstraints()
+{
+	m_positionPhase = false;
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		m_maxCorrections[i] = 0.0f;
+	}
+
+	for (int32 i = 0; i <= b2_maxConstraintColors; ++i)
+	{
+		Solve(m_batches + i, i < b2_maxConstraintColors);
+	}
+
+	float32 maxCorrection = 0.0f;
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		maxCorrection = b2Max(maxCorrection, m_maxCorrections[i]);
+	}
+
+	return maxCorrection;
+}
+
+bool b2ConstraintColoring::SolvePositionConstraints()
+{
+	m_positionPhase = true;
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		m_minSeparations[i] = 0.0f;
+		m_jointsOkay[i] = true;
+	}
+
+	for (int32 i = 0; i <= b2_maxConstraintColors; ++i)
+	{
+		Solve(m_batches + i, i < b2_maxConstraintColors);
+	}
+
+	bool contactsOkay = true;
+	bool jointsOkay = true;
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		contactsOkay = contactsOkay && m_minSeparations[i] >= -b2_linearSlop;
+		jointsOkay = jointsOkay && m_jointsOkay[i];
+	}
+
+	return contactsOkay && jointsOkay;
+}
+
+void b2ConstraintColoring::Solve(const Batch* batch, bool parallel)
+{
+	int32 contactChunks = (batch->contactCount + b2_colorChunkSize - 1) / b2_colorChunkSize;
+	int32 jointChunks = (batch->jointCount + b2_colorChunkSize - 1) / b2_colorChunkSize;
+	int32 chunkCount = contactChunks + jointChunks;
+
+	m_batch = batch;
+	if (parallel && m_dispatcher && chunkCount > 1)
+	{
+		m_dispatcher->Run(this, chunkCount);
+	}
+	else
+	{
+		for (int32 i = 0; i < chunkCount; ++i)
+		{
+			Execute(i, 0);
+		}
+	}
+}
+
+void b2ConstraintColoring::Execute(int32 index, int32 threadIndex)
+{
+	const Batch* batch = m_batch;
+	int32 contactChunks = (batch->contactCount + b2_colorChunkSize - 1) / b2_colorChunkSize;
+
+	if (index < contactChunks)
+	{
+		int32 start = index * b2_colorChunkSize;
+		int32 count = b2Min(batch->contactCount - start, b2_colorChunkSize);
+		const int32* indices = m_contactOrder + batch->contactStart + start;
+
+#ifdef B2_SIMD_CONTACTS
+		if (batch != m_batches + b2_maxConstraintColors)
+		{
+			b2WideContactConstraint* wide = m_wideConstraints + batch->wideStart + start / 4;
+			int32 wideCount = (count + 3) / 4;
+			if (m_positionPhase)
+			{
+				float32 minSeparation = m_contactSolver->SolvePositionConstraints(b2_contactBaumgarte, wide, wideCount);
+				m_minSeparations[threadIndex] = b2Min(m_minSeparations[threadIndex], minSeparation);
+			}
+			else
+			{
+				float32 maxCorrection = m_contactSolver->SolveVelocityConstraints(wide, wideCount);
+				m_maxCorrections[threadIndex] = b2Max(m_maxCorrections[threadIndex], maxCorrection);
+			}
+			return;
+		}
+#endif
+
+		if (m_positionPhase)
+		{
+			float32 minSeparation = m_contactSolver->SolvePositionConstraints(b2_contactBaumgarte, indices, count);
+			m_minSeparations[threadIndex] = b2Min(m_minSeparations[threadIndex], minSeparation);
+		}
+		else
+		{
+			float32 maxCorrection = m_contactSolver->SolveVelocityConstraints(indices, count);
+			m_maxCorrections[threadIndex] = b2Max(m_maxCorrections[threadIndex], maxCorrection);
+		}
+		return;
+	}
+
+	int32 start = (index - contactChunks) * b2_colorChunkSize;
+	int32 count = b2Min(batch->jointCount - start, b2_colorChunkSize);
+	const int32* indices = m_jointOrder + batch->jointStart + start;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Joint* joint = m_island->m_joints[indices[i]];
+		if (m_positionPhase)
+		{
+			bool jointOkay = joint->SolvePositionConstraints();
+			m_jointsOkay[threadIndex] = m_jointsOkay[threadIndex] && jointOkay;
+		}
+		else
+		{
+			float32 maxCorrection = joint->SolveVelocityConstraints(m_step);
+			m_maxCorrections[threadIndex] = b2Max(m_maxCorrections[threadIndex], maxCorrection);
+		}
+	}
+}
+
+bool b2Island::IsColored(const b2TimeStep* step, int32 contactCount, int32 jointCount)
+{
+	return step->constraintColoring && contactCount + jointCount >= b2_minColoredConstraints;
+}
+
+void b2Island::Solve(const b2TimeStep* step, const b2Vec2& gravity, b2TaskDispatcher* dispatcher)
 {
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
@@ -156,24 +526,50 @@ void b2Island::Solve(const b2TimeStep* step, const b2Vec2& gravity)
 		b->m_rotation0 = b->m_rotation;
 	}
 
-	b2ContactSolver contactSolver(m_contacts, m_contactCount, m_allocator);
+	b2ContactSolver contactSolver(step, m_contacts, m_contactCount, m_allocator);
 
 	// Pre-solve
 	contactSolver.PreSolve();
 
 	for (int32 i = 0; i < m_jointCount; ++i)
 	{
-		m_joints[i]->PrepareVelocitySolver();
+		m_joints[i]->PrepareVelocitySolver(step);
 	}
 
-	// Solve velocity constraints.
-	for (int32 i = 0; i < step->iterations; ++i)
+	b2ConstraintColoring* coloring = NULL;
+	if (IsColored(step, m_contactCount, m_jointCount))
 	{
-		contactSolver.SolveVelocityConstraints();
+		void* mem = m_allocator->Allocate(sizeof(b2ConstraintColoring));
+		coloring = new (mem) b2ConstraintColoring(this, &contactSolver, step, dispatcher);
+	}
+
+	// Solve velocity constraints. An island stops, like a resting pile or a
+	// construction standing still, once the contact and joint impulses barely
+	// change the velocities.
+	m_velocityIterationCount = 0;
+	while (m_velocityIterationCount < step->iterations)
+	{
+		++m_velocityIterationCount;
+
+		float32 maxCorrection;
+		if (coloring)
+		{
+			maxCorrection = coloring->SolveVelocityConstraints();
+		}
+		else
+		{
+			maxCorrection = contactSolver.SolveVelocityConstraints();
+
+			for (int32 j = 0; j < m_jointCount; ++j)
+			{
+				float32 jointCorrection = m_joints[j]->SolveVelocityConstraints(step);
+				maxCorrection = b2Max(maxCorrection, jointCorrection);
+			}
+		}
 
-		for (int32 j = 0; j < m_jointCount; ++j)
+		if (m_velocityIterationCount >= b2_minVelocityIterations && maxCorrection < b2_velocityTolerance)
 		{
-			m_joints[j]->SolveVelocityConstraints(step);
+			break;
 		}
 	}
 
@@ -197,10 +593,19 @@ void b2Island::Solve(const b2TimeStep* step, const b2Vec2& gravity)
 	}
 
 	// Solve position constraints.
-	if (b2World::s_enablePositionCorrection)
+	if (step->positionCorrection)
 	{
 		for (m_positionIterationCount = 0; m_positionIterationCount < step->iterations; ++m_positionIterationCount)
 		{
+			if (coloring)
+			{
+				if (coloring->SolvePositionConstraints())
+				{
+					break;
+				}
+				continue;
+			}
+
 			bool contactsOkay = contactSolver.SolvePositionConstraints(b2_contactBaumgarte);
 
 			bool jointsOkay = true;
@@ -217,10 +622,16 @@ void b2Island::Solve(const b2TimeStep* step, const b2Vec2& gravity)
 		}
 	}
 
+	if (coloring)
+	{
+		coloring->~b2ConstraintColoring();
+		m_allocator->Free(coloring);
+	}
+
 	// Post-solve.
 	contactSolver.PostSolve();
 
-	// Synchronize shapes and reset forces.
+	// Reset forces. Shapes are synchronized separately, the broad-phase is shared.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
@@ -230,13 +641,25 @@ void b2Island::Solve(const b2TimeStep* step, const b2Vec2& gravity)
 
 		b->m_R.Set(b->m_rotation);
 
-		b->SynchronizeShapes();
 		b->m_force.Set(0.0f, 0.0f);
 		b->m_torque = 0.0f;
 	}
 }
 
-void b2Island::UpdateSleep(float32 dt)
+void b2Island::SynchronizeShapes()
+{
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+
+		if (b->m_invMass == 0.0f)
+			continue;
+
+		b->SynchronizeShapes();
+	}
+}
+
+bool b2Island::UpdateSleep(float32 dt)
 {
 	float32 minSleepTime = FLT_MAX;
 
@@ -278,5 +701,8 @@ void b2Island::UpdateSleep(float32 dt)
 			b2Body* b = m_bodies[i];
 			b->m_flags |= b2Body::e_sleepFlag;
 		}
+		return true;
 	}
+
+	return false;
 }
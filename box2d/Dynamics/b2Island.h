@@ -25,19 +25,36 @@ class b2StackAllocator;
 class b2Contact;
 class b2Body;
 class b2Joint;
+class b2TaskDispatcher;
 struct b2TimeStep;
 
 class b2Island
 {
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity, b2StackAllocator* allocator);
+
+	// An island in arrays owned by someone else, e.g. one of several islands
+	// collected in a larger one. The solver allocates from the given allocator.
+	b2Island(b2Body** bodies, int32 bodyCount, b2Contact** contacts, int32 contactCount,
+			b2Joint** joints, int32 jointCount, b2StackAllocator* allocator);
 	~b2Island();
 
 	void Clear();
 
-	void Solve(const b2TimeStep* step, const b2Vec2& gravity);
+	// Touches only the bodies, contacts and joints of this island, so
+	// islands can be solved on different threads. Static bodies are shared
+	// between islands, the contact and joint solvers never write to them.
+	// A colored island solves its constraint batches on the dispatcher, if given.
+	void Solve(const b2TimeStep* step, const b2Vec2& gravity, b2TaskDispatcher* dispatcher = NULL);
+
+	// If an island of this size solves its constraints in colored batches.
+	static bool IsColored(const b2TimeStep* step, int32 contactCount, int32 jointCount);
 
-	void UpdateSleep(float32 dt);
+	// Moves the broad-phase proxies of the island. Not thread safe.
+	void SynchronizeShapes();
+
+	// Returns true if the bodies were put to sleep.
+	bool UpdateSleep(float32 dt);
 
 	void Add(b2Body* body)
 	{
@@ -71,8 +88,11 @@ public:
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
 
-	static int32 m_positionIterationCount;
+	int32 m_velocityIterationCount;
+	int32 m_positionIterationCount;
 	float32 m_positionError;
+
+	bool m_ownsArrays;
 };
 
 #endif
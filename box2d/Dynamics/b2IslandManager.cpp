@@ -0,0 +1,546 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2IslandManager.h"
+#include "b2World.h"
+#include "b2Body.h"
+#include "Contacts/b2Contact.h"
+#include "Joints/b2Joint.h"
+
+b2IslandManager::b2IslandManager()
+{
+	m_world = NULL;
+	m_awakeList = NULL;
+	m_sleepingList = NULL;
+	m_awakeCount = 0;
+	m_sleepingCount = 0;
+}
+
+void b2IslandManager::AddBody(b2Body* body)
+{
+	b2Assert(body->m_island == NULL);
+
+	if (body->IsStatic())
+	{
+		return;
+	}
+
+	b2PersistentIsland* island = CreateIsland(body->IsSleeping() == false);
+	AppendBody(island, body);
+}
+
+void b2IslandManager::RemoveBody(b2Body* body)
+{
+	b2PersistentIsland* island = body->m_island;
+	if (island == NULL)
+	{
+		return;
+	}
+
+	if (body->m_islandPrev)
+	{
+		body->m_islandPrev->m_islandNext = body->m_islandNext;
+	}
+	else
+	{
+		island->bodyList = body->m_islandNext;
+	}
+
+	if (body->m_islandNext)
+	{
+		body->m_islandNext->m_islandPrev = body->m_islandPrev;
+	}
+	else
+	{
+		island->bodyTail = body->m_islandPrev;
+	}
+
+	body->m_islandPrev = NULL;
+	body->m_islandNext = NULL;
+
+	b2Assert(island->bodyCount > 0);
+	--island->bodyCount;
+
+	if (island->bodyCount == 0 && island->contactCount == 0 && island->jointCount == 0)
+	{
+		DestroyIsland(island);
+		body->m_island = NULL;
+	}
+}
+
+void b2IslandManager::AddContact(b2Contact* contact)
+{
+	b2PersistentIsland* island1 = contact->m_shape1->m_body->m_island;
+	b2PersistentIsland* island2 = contact->m_shape2->m_body->m_island;
+	b2PersistentIsland* island = Merge(island1, island2);
+	if (island == NULL)
+	{
+		return;
+	}
+
+	AppendContact(island, contact);
+}
+
+void b2IslandManager::RemoveContact(b2Contact* contact)
+{
+	b2Body* body1 = contact->m_shape1->m_body;
+	b2Body* body2 = contact->m_shape2->m_body;
+	b2PersistentIsland* island = GetIsland(body1, body2);
+	if (island == NULL)
+	{
+		return;
+	}
+
+	if (contact->m_islandPrev)
+	{
+		contact->m_islandPrev->m_islandNext = contact->m_islandNext;
+	}
+	else
+	{
+		island->contactList = contact->m_islandNext;
+	}
+
+	if (contact->m_islandNext)
+	{
+		contact->m_islandNext->m_islandPrev = contact->m_islandPrev;
+	}
+	else
+	{
+		island->contactTail = contact->m_islandPrev;
+	}
+
+	contact->m_islandPrev = NULL;
+	contact->m_islandNext = NULL;
+
+	b2Assert(island->contactCount > 0);
+	--island->contactCount;
+	++island->constraintRemoveCount;
+
+	// The last contact of a body being destroyed.
+	if (island->bodyCount == 0 && island->contactCount == 0 && island->jointCount == 0)
+	{
+		DestroyIsland(island);
+		body1->m_island = NULL;
+		body2->m_island = NULL;
+	}
+}
+
+void b2IslandManager::AddJoint(b2Joint* joint)
+{
+	b2PersistentIsland* island = Merge(joint->m_body1->m_island, joint->m_body2->m_island);
+	if (island == NULL)
+	{
+		return;
+	}
+
+	AppendJoint(island, joint);
+}
+
+void b2IslandManager::RemoveJoint(b2Joint* joint)
+{
+	b2PersistentIsland* island = GetIsland(joint->m_body1, joint->m_body2);
+	if (island == NULL)
+	{
+		return;
+	}
+
+	if (joint->m_islandPrev)
+	{
+		joint->m_islandPrev->m_islandNext = joint->m_islandNext;
+	}
+	else
+	{
+		island->jointList = joint->m_islandNext;
+	}
+
+	if (joint->m_islandNext)
+	{
+		joint->m_islandNext->m_islandPrev = joint->m_islandPrev;
+	}
+	else
+	{
+		island->jointTail = joint->m_islandPrev;
+	}
+
+	joint->m_islandPrev = NULL;
+	joint->m_islandNext = NULL;
+
+	b2Assert(island->jointCount > 0);
+	--island->jointCount;
+	++island->constraintRemoveCount;
+}
+
+void b2IslandManager::WakeIsland(b2PersistentIsland* island)
+{
+	if (island->awake)
+	{
+		return;
+	}
+
+	Unlink(island);
+	island->awake = true;
+	Link(island);
+}
+
+void b2IslandManager::SleepIsland(b2PersistentIsland* island)
+{
+	b2Assert(island->awake);
+
+	// Splitting is put off until here, an awake island is solved fine as a whole.
+	if (island->constraintRemoveCount > 0)
+	{
+		Split(island, false);
+		return;
+	}
+
+	Unlink(island);
+	island->awake = false;
+	Link(island);
+}
+
+void b2IslandManager::SplitIsland(b2PersistentIsland* island)
+{
+	b2Assert(island->constraintRemoveCount > 0);
+	Split(island, island->awake);
+}
+
+b2PersistentIsland* b2IslandManager::CreateIsland(bool awake)
+{
+	b2PersistentIsland* island = (b2PersistentIsland*)m_world->m_blockAllocator.Allocate(sizeof(b2PersistentIsland));
+	island->bodyList = NULL;
+	island->bodyTail = NULL;
+	island->contactList = NULL;
+	island->contactTail = NULL;
+	island->jointList = NULL;
+	island->jointTail = NULL;
+	island->bodyCount = 0;
+	island->contactCount = 0;
+	island->jointCount = 0;
+	island->constraintRemoveCount = 0;
+	island->velocityIterationCount = 0;
+	island->positionIterationCount = 0;
+	island->awake = awake;
+
+	Link(island);
+	return island;
+}
+
+void b2IslandManager::DestroyIsland(b2PersistentIsland* island)
+{
+	Unlink(island);
+	m_world->m_blockAllocator.Free(island, sizeof(b2PersistentIsland));
+}
+
+// Adds the island to the front of the list of its state.
+void b2IslandManager::Link(b2PersistentIsland* island)
+{
+	b2PersistentIsland** list = island->awake ? &m_awakeList : &m_sleepingList;
+
+	island->prev = NULL;
+	island->next = *list;
+	if (*list)
+	{
+		(*list)->prev = island;
+	}
+	*list = island;
+
+	if (island->awake)
+	{
+		++m_awakeCount;
+	}
+	else
+	{
+		++m_sleepingCount;
+	}
+}
+
+void b2IslandManager::Unlink(b2PersistentIsland* island)
+{
+	if (island->prev)
+	{
+		island->prev->next = island->next;
+	}
+
+	if (island->next)
+	{
+		island->next->prev = island->prev;
+	}
+
+	if (island->awake)
+	{
+		if (island == m_awakeList)
+		{
+			m_awakeList = island->next;
+		}
+
+		b2Assert(m_awakeCount > 0);
+		--m_awakeCount;
+	}
+	else
+	{
+		if (island == m_sleepingList)
+		{
+			m_sleepingList = island->next;
+		}
+
+		b2Assert(m_sleepingCount > 0);
+		--m_sleepingCount;
+	}
+
+	island->prev = NULL;
+	island->next = NULL;
+}
+
+// Returns the island a constraint between bodies of these islands belongs to.
+// Either may be NULL for a static body. The bodies of the smaller island are
+// moved to the larger one.
+b2PersistentIsland* b2IslandManager::Merge(b2PersistentIsland* island1, b2PersistentIsland* island2)
+{
+	if (island1 == NULL || island1 == island2)
+	{
+		return island2;
+	}
+
+	if (island2 == NULL)
+	{
+		return island1;
+	}
+
+	if (island1->bodyCount < island2->bodyCount)
+	{
+		b2Swap(island1, island2);
+	}
+
+	for (b2Body* b = island2->bodyList; b; b = b->m_islandNext)
+	{
+		b->m_island = island1;
+	}
+
+	if (island2->bodyList)
+	{
+		if (island1->bodyTail)
+		{
+			island1->bodyTail->m_islandNext = island2->bodyList;
+			island2->bodyList->m_islandPrev = island1->bodyTail;
+		}
+		else
+		{
+			island1->bodyList = island2->bodyList;
+		}
+		island1->bodyTail = island2->bodyTail;
+	}
+
+	if (island2->contactList)
+	{
+		if (island1->contactTail)
+		{
+			island1->contactTail->m_islandNext = island2->contactList;
+			island2->contactList->m_islandPrev = island1->contactTail;
+		}
+		else
+		{
+			island1->contactList = island2->contactList;
+		}
+		island1->contactTail = island2->contactTail;
+	}
+
+	if (island2->jointList)
+	{
+		if (island1->jointTail)
+		{
+			island1->jointTail->m_islandNext = island2->jointList;
+			island2->jointList->m_islandPrev = island1->jointTail;
+		}
+		else
+		{
+			island1->jointList = island2->jointList;
+		}
+		island1->jointTail = island2->jointTail;
+	}
+
+	island1->bodyCount += island2->bodyCount;
+	island1->contactCount += island2->contactCount;
+	island1->jointCount += island2->jointCount;
+	island1->constraintRemoveCount += island2->constraintRemoveCount;
+
+	if (island2->awake)
+	{
+		WakeIsland(island1);
+	}
+
+	DestroyIsland(island2);
+	return island1;
+}
+
+// Rebuilds the island as one island per connected group of bodies.
+void b2IslandManager::Split(b2PersistentIsland* island, bool awake)
+{
+	int32 bodyCount = island->bodyCount;
+	b2Assert(bodyCount > 0);
+
+	b2StackAllocator* allocator = &m_world->m_stackAllocator;
+	b2Body** bodies = (b2Body**)allocator->Allocate(bodyCount * sizeof(b2Body*));
+	b2Body** stack = (b2Body**)allocator->Allocate(bodyCount * sizeof(b2Body*));
+
+	// The lists are rebuilt, so copy the bodies out first.
+	int32 count = 0;
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		bodies[count++] = b;
+		b->m_flags &= ~b2Body::e_islandFlag;
+	}
+	b2Assert(count == bodyCount);
+
+	for (b2Contact* c = island->contactList; c; c = c->m_islandNext)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
+
+	for (b2Joint* j = island->jointList; j; j = j->m_islandNext)
+	{
+		j->m_islandFlag = false;
+	}
+
+	DestroyIsland(island);
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* seed = bodies[i];
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		b2PersistentIsland* piece = CreateIsland(awake);
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		// Perform a depth first search (DFS) on the constraint graph.
+		while (stackCount > 0)
+		{
+			b2Body* b = stack[--stackCount];
+			AppendBody(piece, b);
+
+			// Search all contacts connected to this body.
+			for (b2ContactNode* cn = b->m_contactList; cn; cn = cn->next)
+			{
+				if (cn->contact->m_flags & b2Contact::e_islandFlag)
+				{
+					continue;
+				}
+
+				AppendContact(piece, cn->contact);
+				cn->contact->m_flags |= b2Contact::e_islandFlag;
+
+				// To keep islands as small as possible, we don't
+				// propagate islands across static bodies.
+				b2Body* other = cn->other;
+				if (other->m_flags & (b2Body::e_islandFlag | b2Body::e_staticFlag))
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < bodyCount);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+
+			// Search all joints connect to this body.
+			for (b2JointNode* jn = b->m_jointList; jn; jn = jn->next)
+			{
+				if (jn->joint->m_islandFlag == true)
+				{
+					continue;
+				}
+
+				AppendJoint(piece, jn->joint);
+				jn->joint->m_islandFlag = true;
+
+				b2Body* other = jn->other;
+				if (other->m_flags & (b2Body::e_islandFlag | b2Body::e_staticFlag))
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < bodyCount);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+		}
+	}
+
+	allocator->Free(stack);
+	allocator->Free(bodies);
+}
+
+void b2IslandManager::AppendBody(b2PersistentIsland* island, b2Body* body)
+{
+	body->m_island = island;
+	body->m_islandPrev = island->bodyTail;
+	body->m_islandNext = NULL;
+	if (island->bodyTail)
+	{
+		island->bodyTail->m_islandNext = body;
+	}
+	else
+	{
+		island->bodyList = body;
+	}
+	island->bodyTail = body;
+	++island->bodyCount;
+}
+
+void b2IslandManager::AppendContact(b2PersistentIsland* island, b2Contact* contact)
+{
+	contact->m_islandPrev = island->contactTail;
+	contact->m_islandNext = NULL;
+	if (island->contactTail)
+	{
+		island->contactTail->m_islandNext = contact;
+	}
+	else
+	{
+		island->contactList = contact;
+	}
+	island->contactTail = contact;
+	++island->contactCount;
+}
+
+void b2IslandManager::AppendJoint(b2PersistentIsland* island, b2Joint* joint)
+{
+	joint->m_islandPrev = island->jointTail;
+	joint->m_islandNext = NULL;
+	if (island->jointTail)
+	{
+		island->jointTail->m_islandNext = joint;
+	}
+	else
+	{
+		island->jointList = joint;
+	}
+	island->jointTail = joint;
+	++island->jointCount;
+}
+
+// Constraints belong to the island of their dynamic bodies.
+b2PersistentIsland* b2IslandManager::GetIsland(b2Body* body1, b2Body* body2)
+{
+	b2Assert(body1->m_island == NULL || body2->m_island == NULL || body1->m_island == body2->m_island);
+	return body1->m_island ? body1->m_island : body2->m_island;
+}
@@ -0,0 +1,113 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ISLAND_MANAGER_H
+#define B2_ISLAND_MANAGER_H
+
+#include "../Common/b2Math.h"
+
+class b2World;
+class b2Body;
+class b2Contact;
+class b2Joint;
+
+// Bodies connected by touching contacts and joints, kept from step to step.
+// Static bodies belong to no island and do not connect islands. A contact or
+// joint merges the islands of its bodies when it appears. Removing one only
+// counts, the island is split when it falls asleep.
+struct b2PersistentIsland
+{
+	b2Body* bodyList;
+	b2Body* bodyTail;
+	b2Contact* contactList;
+	b2Contact* contactTail;
+	b2Joint* jointList;
+	b2Joint* jointTail;
+
+	int32 bodyCount;
+	int32 contactCount;
+	int32 jointCount;
+
+	// Contacts and joints removed since the island was built or split.
+	int32 constraintRemoveCount;
+
+	// Solver iterations of the last step the island was awake.
+	int32 velocityIterationCount;
+	int32 positionIterationCount;
+
+	bool awake;
+
+	// Awake or sleeping list of the manager.
+	b2PersistentIsland* prev;
+	b2PersistentIsland* next;
+};
+
+// Keeps the persistent islands of a world up to date. b2World::Step only
+// visits the awake islands.
+class b2IslandManager
+{
+public:
+	b2IslandManager();
+
+	// A dynamic body starts in an island of its own.
+	void AddBody(b2Body* body);
+
+	// The body keeps pointing to its island, so destroying its contacts
+	// afterwards still finds it. Empty islands are destroyed.
+	void RemoveBody(b2Body* body);
+
+	// Touching contacts and joints, with at least one dynamic body.
+	void AddContact(b2Contact* contact);
+	void RemoveContact(b2Contact* contact);
+	void AddJoint(b2Joint* joint);
+	void RemoveJoint(b2Joint* joint);
+
+	// Moves the island to the awake list. Its bodies are woken when it is solved.
+	void WakeIsland(b2PersistentIsland* island);
+
+	// Moves an island whose bodies all sleep or are frozen to the sleeping
+	// list. It is split first if constraints were removed from it.
+	void SleepIsland(b2PersistentIsland* island);
+
+	// Splits an awake island with removed constraints, so the parts that came
+	// to rest can sleep without the rest.
+	void SplitIsland(b2PersistentIsland* island);
+
+	b2World* m_world;
+
+	b2PersistentIsland* m_awakeList;
+	b2PersistentIsland* m_sleepingList;
+	int32 m_awakeCount;
+	int32 m_sleepingCount;
+
+private:
+	b2PersistentIsland* CreateIsland(bool awake);
+	void DestroyIsland(b2PersistentIsland* island);
+	void Link(b2PersistentIsland* island);
+	void Unlink(b2PersistentIsland* island);
+
+	b2PersistentIsland* Merge(b2PersistentIsland* island1, b2PersistentIsland* island2);
+	void Split(b2PersistentIsland* island, bool awake);
+
+	static void AppendBody(b2PersistentIsland* island, b2Body* body);
+	static void AppendContact(b2PersistentIsland* island, b2Contact* contact);
+	static void AppendJoint(b2PersistentIsland* island, b2Joint* joint);
+	static b2PersistentIsland* GetIsland(b2Body* body1, b2Body* body2);
+};
+
+#endif
@@ -25,32 +25,102 @@
 #include "../Collision/b2Collision.h"
 #include "../Collision/b2Shape.h"
 #include <new>
+#include <algorithm>
+#include <memory.h>
 
-int32 b2World::s_enablePositionCorrection = 1;
-int32 b2World::s_enableWarmStarting = 1;
+// Awake island collected by b2World::Step, as ranges of the island arrays.
+struct b2IslandRange
+{
+	b2PersistentIsland* island;
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+	int32 velocityIterationCount;
+	int32 positionIterationCount;
+};
+
+// Solves collected islands, possibly on several threads.
+class b2IslandSolver : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex)
+	{
+		b2IslandRange* range = ranges + order[index];
+		b2StackAllocator* allocator = threadIndex == 0 ?
+			&world->m_stackAllocator : world->m_threadAllocators + (threadIndex - 1);
+
+		b2Island island(islands->m_bodies + range->bodyStart, range->bodyCount,
+						islands->m_contacts + range->contactStart, range->contactCount,
+						islands->m_joints + range->jointStart, range->jointCount, allocator);
+		island.Solve(step, world->m_gravity, dispatcher);
+
+		range->velocityIterationCount = island.m_velocityIterationCount;
+		range->positionIterationCount = island.m_positionIterationCount;
+	}
 
-b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
+	// Largest islands first, so a thread is not left with a big one at the end.
+	bool operator()(int32 index1, int32 index2) const
+	{
+		const b2IslandRange& r1 = ranges[index1];
+		const b2IslandRange& r2 = ranges[index2];
+		int32 size1 = r1.bodyCount + r1.contactCount + r1.jointCount;
+		int32 size2 = r2.bodyCount + r2.contactCount + r2.jointCount;
+		return size1 > size2 || (size1 == size2 && index1 < index2);
+	}
+
+	// Islands big enough for colored constraints
+	bool IsColored(int32 index) const
+	{
+		const b2IslandRange* range = ranges + order[index];
+		return b2Island::IsColored(step, range->contactCount, range->jointCount);
+	}
+
+	b2World* world;
+	b2TaskDispatcher* dispatcher;	// for colored constraints
+	const b2TimeStep* step;
+	const b2Island* islands;
+	b2IslandRange* ranges;
+	int32* order;
+};
+
+
+b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, b2BroadPhaseType broadPhaseType)
 {
 	m_listener = NULL;
 	m_filter = &b2_defaultFilter;
 
-	m_bodyList = NULL;
-	m_contactList = NULL;
+	m_taskDispatcher = NULL;
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+
+	m_velocityIterationCount = 0;
+	m_positionIterationCount = 0;
+
 	m_jointList = NULL;
 
 	m_bodyCount = 0;
 	m_contactCount = 0;
 	m_jointCount = 0;
 
+	m_bodyCapacity = b2_initialWorldCapacity;
+	m_contactCapacity = b2_initialWorldCapacity;
+	m_bodies = (b2Body**)b2Alloc(m_bodyCapacity * sizeof(b2Body*));
+	m_contacts = (b2Contact**)b2Alloc(m_contactCapacity * sizeof(b2Contact*));
+
 	m_bodyDestroyList = NULL;
+	m_jointBatching = false;
 
 	m_allowSleep = doSleep;
 
+	m_enablePositionCorrection = 1;
+	m_enableWarmStarting = 1;
+	m_enableConstraintColoring = 1;
+
 	m_gravity = gravity;
 
 	m_contactManager.m_world = this;
-	void* mem = b2Alloc(sizeof(b2BroadPhase));
-	m_broadPhase = new (mem) b2BroadPhase(worldAABB, &m_contactManager);
+	m_islandManager.m_world = this;
+	m_broadPhase = b2BroadPhase::Create(broadPhaseType, worldAABB, &m_contactManager);
 
 	b2BodyDef bd;
 	m_groundBody = CreateBody(&bd);
@@ -59,8 +129,10 @@ b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
 b2World::~b2World()
 {
 	DestroyBody(m_groundBody);
-	m_broadPhase->~b2BroadPhase();
-	b2Free(m_broadPhase);
+	b2BroadPhase::Destroy(m_broadPhase);
+	SetTaskDispatcher(NULL);
+	b2Free(m_bodies);
+	b2Free(m_contacts);
 }
 
 void b2World::SetListener(b2WorldListener* listener)
@@ -73,23 +145,63 @@ void b2World::SetFilter(b2CollisionFilter* filter)
 	m_filter = filter;
 }
 
+void b2World::SetTaskDispatcher(b2TaskDispatcher* dispatcher)
+{
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_threadAllocators);
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+
+	m_taskDispatcher = dispatcher;
+
+	// Every thread needs its own stack allocator for the contact solver.
+	if (dispatcher && dispatcher->GetThreadCount() > 1)
+	{
+		m_threadAllocatorCount = dispatcher->GetThreadCount() - 1;
+		m_threadAllocators = (b2StackAllocator*)b2Alloc(m_threadAllocatorCount * sizeof(b2StackAllocator));
+		for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+		{
+			new (m_threadAllocators + i) b2StackAllocator;
+		}
+	}
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
 	b2Body* b = new (mem) b2Body(def, this);
-	b->m_prev = NULL;
-	
-	b->m_next = m_bodyList;
-	if (m_bodyList)
+
+	if (m_bodyCount == m_bodyCapacity)
 	{
-		m_bodyList->m_prev = b;
+		b2Body** oldBodies = m_bodies;
+		m_bodyCapacity *= 2;
+		m_bodies = (b2Body**)b2Alloc(m_bodyCapacity * sizeof(b2Body*));
+		memcpy(m_bodies, oldBodies, m_bodyCount * sizeof(b2Body*));
+		b2Free(oldBodies);
 	}
-	m_bodyList = b;
+
+	b->m_worldIndex = m_bodyCount;
+	m_bodies[m_bodyCount] = b;
 	++m_bodyCount;
 
+	m_islandManager.AddBody(b);
+
 	return b;
 }
 
+void b2World::BeginBodyBatch()
+{
+	m_broadPhase->BeginBatch();
+}
+
+void b2World::EndBodyBatch()
+{
+	m_broadPhase->EndBatch();
+}
+
 // Body destruction is deferred to make contact processing more robust.
 void b2World::DestroyBody(b2Body* b)
 {
@@ -98,28 +210,17 @@ void b2World::DestroyBody(b2Body* b)
 		return;
 	}
 
-	// Remove from normal body list.
-	if (b->m_prev)
-	{
-		b->m_prev->m_next = b->m_next;
-	}
-
-	if (b->m_next)
-	{
-		b->m_next->m_prev = b->m_prev;
-	}
-
-	if (b == m_bodyList)
-	{
-		m_bodyList = b->m_next;
-	}
+	// Remove from the body array, the last body takes its place.
+	b2Assert(0 <= b->m_worldIndex && b->m_worldIndex < m_bodyCount);
+	b2Body* last = m_bodies[m_bodyCount - 1];
+	m_bodies[b->m_worldIndex] = last;
+	last->m_worldIndex = b->m_worldIndex;
+	b->m_worldIndex = -1;
+	--m_bodyCount;
 
 	b->m_flags |= b2Body::e_destroyFlag;
-	b2Assert(m_bodyCount > 0);
-	--m_bodyCount;
 
 	// Add to the deferred destruction list.
-	b->m_prev = NULL;
 	b->m_next = m_bodyDestroyList;
 	m_bodyDestroyList = b;
 }
@@ -152,6 +253,9 @@ void b2World::CleanBodyList()
 			DestroyJoint(jn0->joint);
 		}
 
+		// The contacts destroyed with the shapes still find the island.
+		m_islandManager.RemoveBody(b0);
+
 		b0->~b2Body();
 		m_blockAllocator.Free(b0, sizeof(b2Body));
 	}
@@ -191,15 +295,12 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	if (j->m_body2->m_jointList) j->m_body2->m_jointList->prev = &j->m_node2;
 	j->m_body2->m_jointList = &j->m_node2;
 
+	m_islandManager.AddJoint(j);
+
 	// If the joint prevents collisions, then reset collision filtering.
 	if (def->collideConnected == false)
 	{
-		// Reset the proxies on the body with the minimum number of shapes.
-		b2Body* b = def->body1->m_shapeCount < def->body2->m_shapeCount ? def->body1 : def->body2;
-		for (b2Shape* s = b->m_shapeList; s; s = s->m_next)
-		{
-			s->ResetProxy(m_broadPhase);
-		}
+		ResetJointFiltering(def->body1, def->body2);
 	}
 
 	return j;
@@ -233,6 +334,8 @@ void b2World::DestroyJoint(b2Joint* j)
 	body1->WakeUp();
 	body2->WakeUp();
 
+	m_islandManager.RemoveJoint(j);
+
 	// Remove from body 1
 	if (j->m_node1.prev)
 	{
@@ -279,13 +382,99 @@ void b2World::DestroyJoint(b2Joint* j)
 	// If the joint prevents collisions, then reset collision filtering.
 	if (collideConnected == false)
 	{
-		// Reset the proxies on the body with the minimum number of shapes.
-		b2Body* b = body1->m_shapeCount < body2->m_shapeCount ? body1 : body2;
-		for (b2Shape* s = b->m_shapeList; s; s = s->m_next)
+		ResetJointFiltering(body1, body2);
+	}
+}
+
+void b2World::ResetJointFiltering(b2Body* body1, b2Body* body2)
+{
+	// Reset the proxies on the body with the minimum number of shapes.
+	b2Body* b = body1->m_shapeCount < body2->m_shapeCount ? body1 : body2;
+
+	if (m_jointBatching)
+	{
+		b->m_flags |= b2Body::e_resetProxyFlag;
+		return;
+	}
+
+	for (b2Shape* s = b->m_shapeList; s; s = s->m_next)
+	{
+		s->ResetProxy(m_broadPhase);
+	}
+}
+
+void b2World::BeginJointBatch()
+{
+	b2Assert(m_jointBatching == false);
+	m_jointBatching = true;
+}
+
+void b2World::EndJointBatch()
+{
+	b2Assert(m_jointBatching == true);
+	m_jointBatching = false;
+
+	// Recreated proxies are inserted together.
+	m_broadPhase->BeginBatch();
+
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+		if (b->m_flags & b2Body::e_resetProxyFlag)
+		{
+			b->m_flags &= ~b2Body::e_resetProxyFlag;
+			for (b2Shape* s = b->m_shapeList; s; s = s->m_next)
+			{
+				s->ResetProxy(m_broadPhase);
+			}
+		}
+	}
+
+	m_broadPhase->EndBatch();
+}
+
+void b2World::ResetContacts()
+{
+	b2Assert(m_jointBatching == false);
+
+	// The contacts of the removed pairs are destroyed now, not at the next step.
+	m_contactManager.m_destroyImmediate = true;
+
+	// Recreated proxies are inserted together.
+	m_broadPhase->BeginBatch();
+
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		for (b2Shape* s = m_bodies[i]->m_shapeList; s; s = s->m_next)
 		{
 			s->ResetProxy(m_broadPhase);
 		}
 	}
+
+	m_broadPhase->EndBatch();
+	m_broadPhase->Commit();
+
+	m_contactManager.m_destroyImmediate = false;
+}
+
+int32 b2World::GetStepPeakAllocation() const
+{
+	int32 peak = m_stackAllocator.GetMaxAllocation();
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		peak = b2Max(peak, m_threadAllocators[i].GetMaxAllocation());
+	}
+	return peak;
+}
+
+int32 b2World::GetStepMallocCount() const
+{
+	int32 count = m_stackAllocator.GetMallocCount();
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		count += m_threadAllocators[i].GetMallocCount();
+	}
+	return count;
 }
 
 void b2World::Step(float32 dt, int32 iterations)
@@ -293,6 +482,9 @@ void b2World::Step(float32 dt, int32 iterations)
 	b2TimeStep step;
 	step.dt = dt;
 	step.iterations	= iterations;
+	step.warmStarting = m_enableWarmStarting != 0;
+	step.positionCorrection = m_enablePositionCorrection != 0;
+	step.constraintColoring = m_enableConstraintColoring != 0;
 	if (dt > 0.0f)
 	{
 		step.inv_dt = 1.0f / dt;
@@ -302,8 +494,16 @@ void b2World::Step(float32 dt, int32 iterations)
 		step.inv_dt = 0.0f;
 	}
 	
+	m_velocityIterationCount = 0;
 	m_positionIterationCount = 0;
 
+	// Nothing is allocated between steps. Arenas that spilled last step grow.
+	m_stackAllocator.Reset();
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].Reset();
+	}
+
 	// Handle deferred contact destruction.
 	m_contactManager.CleanContactList();
 
@@ -313,121 +513,163 @@ void b2World::Step(float32 dt, int32 iterations)
 	// Update contacts.
 	m_contactManager.Collide();
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount, m_contactCount, m_jointCount, &m_stackAllocator);
-
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
-	{
-		b->m_flags &= ~b2Body::e_islandFlag;
-	}
-	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	// Only awake islands are visited. Static bodies are in no island, so the
+	// collected islands need no more room than the awake ones hold.
+	int32 bodyCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+	for (b2PersistentIsland* p = m_islandManager.m_awakeList; p; p = p->next)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		bodyCount += p->bodyCount;
+		contactCount += p->contactCount;
+		jointCount += p->jointCount;
 	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
-	{
-		j->m_islandFlag = false;
-	}
-	
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+
+	b2Island island(bodyCount, contactCount, jointCount, &m_stackAllocator);
+
+	// Collect the awake islands.
+	int32 islandCapacity = m_islandManager.m_awakeCount;
+	b2IslandRange* ranges = (b2IslandRange*)m_stackAllocator.Allocate(b2Max(islandCapacity, 1) * sizeof(b2IslandRange));
+	int32 islandCount = 0;
+	b2PersistentIsland* next;
+	for (b2PersistentIsland* p = m_islandManager.m_awakeList; p; p = next)
 	{
-		if (seed->m_flags & (b2Body::e_staticFlag | b2Body::e_islandFlag | b2Body::e_sleepFlag | b2Body::e_frozenFlag))
+		next = p->next;
+
+		// Solve the island if a body in it is awake and not frozen. An island
+		// whose bodies were all put to sleep directly, or froze, goes to sleep,
+		// so later steps do not visit it.
+		bool seed = false;
+		for (b2Body* b = p->bodyList; b; b = b->m_islandNext)
+		{
+			if ((b->m_flags & (b2Body::e_sleepFlag | b2Body::e_frozenFlag)) == 0)
+			{
+				seed = true;
+				break;
+			}
+		}
+
+		if (seed == false)
 		{
+			m_islandManager.SleepIsland(p);
 			continue;
 		}
 
-		// Reset island and stack.
-		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
+		b2Assert(islandCount < islandCapacity);
+		b2IslandRange* range = ranges + islandCount++;
+		range->island = p;
+		range->bodyStart = island.m_bodyCount;
+		range->contactStart = island.m_contactCount;
+		range->jointStart = island.m_jointCount;
 
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
+		// Make sure the bodies are awake.
+		for (b2Body* b = p->bodyList; b; b = b->m_islandNext)
 		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
+			b->m_flags &= ~b2Body::e_sleepFlag;
 			island.Add(b);
+		}
 
-			// Make sure the body is awake.
-			b->m_flags &= ~b2Body::e_sleepFlag;
+		for (b2Contact* c = p->contactList; c; c = c->m_islandNext)
+		{
+			island.Add(c);
+		}
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->m_flags & b2Body::e_staticFlag)
-			{
-				continue;
-			}
+		for (b2Joint* j = p->jointList; j; j = j->m_islandNext)
+		{
+			island.Add(j);
+		}
 
-			// Search all contacts connected to this body.
-			for (b2ContactNode* cn = b->m_contactList; cn; cn = cn->next)
-			{
-				if (cn->contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
+		range->bodyCount = island.m_bodyCount - range->bodyStart;
+		range->contactCount = island.m_contactCount - range->contactStart;
+		range->jointCount = island.m_jointCount - range->jointStart;
+		range->velocityIterationCount = 0;
+		range->positionIterationCount = 0;
+	}
 
-				island.Add(cn->contact);
-				cn->contact->m_flags |= b2Contact::e_islandFlag;
+	// Solve the islands. They share no dynamic bodies, contacts or joints, so
+	// the result does not depend on the order or the thread they are solved on.
+	int32* order = (int32*)m_stackAllocator.Allocate(b2Max(islandCount, 1) * sizeof(int32));
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		order[i] = i;
+	}
 
-				b2Body* other = cn->other;
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+	b2IslandSolver solver;
+	solver.world = this;
+	solver.dispatcher = NULL;
+	solver.step = &step;
+	solver.islands = &island;
+	solver.ranges = ranges;
+	solver.order = order;
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+	int32 solvedCount = 0;
+	if (m_taskDispatcher && m_threadAllocatorCount > 0)
+	{
+		std::sort(order, order + islandCount, solver);
 
-			// Search all joints connect to this body.
-			for (b2JointNode* jn = b->m_jointList; jn; jn = jn->next)
-			{
-				if (jn->joint->m_islandFlag == true)
-				{
-					continue;
-				}
+		// Islands with colored constraints come first. Each is solved by all threads.
+		solver.dispatcher = m_taskDispatcher;
+		while (solvedCount < islandCount && solver.IsColored(solvedCount))
+		{
+			solver.Execute(solvedCount++, 0);
+		}
+		solver.dispatcher = NULL;
+	}
 
-				island.Add(jn->joint);
-				jn->joint->m_islandFlag = true;
+	solver.order = order + solvedCount;
+	if (m_taskDispatcher && m_threadAllocatorCount > 0 && islandCount - solvedCount > 1)
+	{
+		m_taskDispatcher->Run(&solver, islandCount - solvedCount);
+	}
+	else
+	{
+		for (int32 i = 0; i < islandCount - solvedCount; ++i)
+		{
+			solver.Execute(i, 0);
+		}
+	}
 
-				b2Body* other = jn->other;
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+	// Finish the islands in the order they were built. One awake island is
+	// split per step at most, splitting costs as much as solving.
+	bool splitIsland = false;
+	for (int32 islandIndex = 0; islandIndex < islandCount; ++islandIndex)
+	{
+		const b2IslandRange* range = ranges + islandIndex;
+		b2Island solved(island.m_bodies + range->bodyStart, range->bodyCount,
+						island.m_contacts + range->contactStart, range->contactCount,
+						island.m_joints + range->jointStart, range->jointCount, &m_stackAllocator);
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
-		}
+		solved.SynchronizeShapes();
 
-		island.Solve(&step, m_gravity);
+		range->island->velocityIterationCount = range->velocityIterationCount;
+		range->island->positionIterationCount = range->positionIterationCount;
+		m_velocityIterationCount = b2Max(m_velocityIterationCount, range->velocityIterationCount);
+		m_positionIterationCount = b2Max(m_positionIterationCount, range->positionIterationCount);
 
-		m_positionIterationCount = b2Max(m_positionIterationCount, island.m_positionIterationCount);
-		
 		if (m_allowSleep)
 		{
-			island.UpdateSleep(dt);
-		}
-
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
-		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
-			if (b->m_flags & b2Body::e_staticFlag)
+			if (solved.UpdateSleep(dt))
+			{
+				m_islandManager.SleepIsland(range->island);
+			}
+			else if (splitIsland == false && range->island->constraintRemoveCount > 0)
 			{
-				b->m_flags &= ~b2Body::e_islandFlag;
+				for (int32 i = 0; i < solved.m_bodyCount; ++i)
+				{
+					if (solved.m_bodies[i]->m_sleepTime >= b2_timeToSleep)
+					{
+						m_islandManager.SplitIsland(range->island);
+						splitIsland = true;
+						break;
+					}
+				}
 			}
+		}
 
-			// Handle newly frozen bodies.
+		// Handle newly frozen bodies.
+		for (int32 i = 0; i < solved.m_bodyCount; ++i)
+		{
+			b2Body* b = solved.m_bodies[i];
 			if (b->IsFrozen() && m_listener)
 			{
 				b2BoundaryResponse response = m_listener->NotifyBoundaryViolated(b);
@@ -435,19 +677,21 @@ void b2World::Step(float32 dt, int32 iterations)
 				{
 					DestroyBody(b);
 					b = NULL;
-					island.m_bodies[i] = NULL;
+					solved.m_bodies[i] = NULL;
 				}
 			}
 		}
 	}
 
-	m_stackAllocator.Free(stack);
+	m_stackAllocator.Free(order);
+	m_stackAllocator.Free(ranges);
 
 	m_broadPhase->Commit();
 
 #if 0
-	for (b2Contact* c = m_contactList; c; c = c->GetNext())
+	for (int32 i = 0; i < m_contactCount; ++i)
 	{
+		b2Contact* c = m_contacts[i];
 		b2Shape* shape1 = c->GetShape1();
 		b2Shape* shape2 = c->GetShape2();
 		b2Body* body1 = shape1->GetBody();
@@ -23,6 +23,7 @@
 #include "../Common/b2BlockAllocator.h"
 #include "../Common/b2StackAllocator.h"
 #include "b2ContactManager.h"
+#include "b2IslandManager.h"
 #include "b2WorldCallbacks.h"
 
 struct b2AABB;
@@ -39,12 +40,17 @@ struct b2TimeStep
 	float32 dt;			// time step
 	float32 inv_dt;		// inverse time step (0 if dt == 0).
 	int32 iterations;
+	bool warmStarting;			// copied from b2World::m_enableWarmStarting
+	bool positionCorrection;	// copied from b2World::m_enablePositionCorrection
+	bool constraintColoring;	// copied from b2World::m_enableConstraintColoring
 };
 
 class b2World
 {
 public:
-	b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep);
+	// The broad-phase type selects the algorithm used to find shape pairs.
+	b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep,
+			b2BroadPhaseType broadPhaseType = e_sweepAndPruneBroadPhase);
 	~b2World();
 
 	// Register a world listener to receive important events that can
@@ -55,15 +61,38 @@ public:
 	// Otherwise the default filter is used (b2CollisionFilter).
 	void SetFilter(b2CollisionFilter* filter);
 
+	// Register a task dispatcher to solve independent islands in parallel.
+	// Results do not depend on the number of threads. Pass NULL to solve
+	// islands on the calling thread.
+	void SetTaskDispatcher(b2TaskDispatcher* dispatcher);
+
 	// Create and destroy rigid bodies. Destruction is deferred until the
 	// the next call to Step. This is done so that bodies may be destroyed
 	// while you iterate through the contact list.
 	b2Body* CreateBody(const b2BodyDef* def);
 	void DestroyBody(b2Body* body);
 
+	// Bodies created between these calls have their shapes inserted into the
+	// broad-phase in one pass, and their contacts are created by EndBodyBatch.
+	// Use this to build a scene. Do not step or query the world in between.
+	void BeginBodyBatch();
+	void EndBodyBatch();
+
 	b2Joint* CreateJoint(const b2JointDef* def);
 	void DestroyJoint(b2Joint* joint);
 
+	// Joints that do not collide connected bodies reset the broad-phase proxies
+	// of one body. Between these calls that is deferred, and EndJointBatch
+	// resets each affected body once. Until then connected bodies keep their
+	// contacts. Do not step the world in between.
+	void BeginJointBatch();
+	void EndJointBatch();
+
+	// Destroy all contacts and create them again from the broad-phase. Use this
+	// after moving bodies to a stored state, so the contact impulses from before
+	// the move do not warm start the next step.
+	void ResetContacts();
+
 	// The world provides a single ground body with no collision shapes. You
 	// can use this to simplify the creation of joints.
 	b2Body* GetGroundBody();
@@ -76,28 +105,48 @@ public:
 	int32 Query(const b2AABB& aabb, b2Shape** shapes, int32 maxCount);
 
 	// You can use these to iterate over all the bodies, joints, and contacts.
-	b2Body* GetBodyList();
+	// Bodies and contacts are kept in arrays, indexed from 0 to the count.
+	// Destroying a body moves the last body into its place, so iterate
+	// backwards when destroying bodies.
+	int32 GetBodyCount() const;
+	b2Body* GetBody(int32 index);
 	b2Joint* GetJointList();
-	b2Contact* GetContactList();
+	int32 GetContactCount() const;
+	b2Contact* GetContact(int32 index);
+
+	// Per step memory over all threads: the largest amount one thread held
+	// at once, and the allocations that went to the heap. The count stops
+	// rising once the step arenas have grown to the peak.
+	int32 GetStepPeakAllocation() const;
+	int32 GetStepMallocCount() const;
 
 	//--------------- Internals Below -------------------
 
 	void CleanBodyList();
 
+	// Applies collision filtering of a joint between the bodies.
+	void ResetJointFiltering(b2Body* body1, b2Body* body2);
+
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
 	b2BroadPhase* m_broadPhase;
 	b2ContactManager m_contactManager;
+	b2IslandManager m_islandManager;
 
-	b2Body* m_bodyList;
-	b2Contact* m_contactList;
+	// Dense arrays, so the passes over all contacts stream through memory.
+	// Removal moves the last element into the gap.
+	b2Body** m_bodies;
+	b2Contact** m_contacts;
 	b2Joint* m_jointList;
 
 	int32 m_bodyCount;
 	int32 m_contactCount;
 	int32 m_jointCount;
 
+	int32 m_bodyCapacity;
+	int32 m_contactCapacity;
+
 	// These bodies will be destroyed at the next time step.
 	b2Body* m_bodyDestroyList;
 
@@ -109,10 +158,23 @@ public:
 	b2WorldListener* m_listener;
 	b2CollisionFilter* m_filter;
 
+	b2TaskDispatcher* m_taskDispatcher;
+	b2StackAllocator* m_threadAllocators;	// for dispatcher threads other than the calling one
+	int32 m_threadAllocatorCount;
+
+	// Largest iteration counts of the islands solved in the last step.
+	int32 m_velocityIterationCount;
 	int32 m_positionIterationCount;
 
-	static int32 s_enablePositionCorrection;
-	static int32 s_enableWarmStarting;
+	bool m_jointBatching;
+
+	// Solver switches, per world so independent worlds can be stepped on different threads.
+	int32 m_enablePositionCorrection;
+	int32 m_enableWarmStarting;
+	// Large islands solve constraints in batches without shared dynamic bodies,
+	// on all dispatcher threads. On by default, off keeps the sequential
+	// Gauss-Seidel order.
+	int32 m_enableConstraintColoring;
 };
 
 inline b2Body* b2World::GetGroundBody()
@@ -120,9 +182,15 @@ inline b2Body* b2World::GetGroundBody()
 	return m_groundBody;
 }
 
-inline b2Body* b2World::GetBodyList()
+inline b2Body* b2World::GetBody(int32 index)
+{
+	b2Assert(0 <= index && index < m_bodyCount);
+	return m_bodies[index];
+}
+
+inline int32 b2World::GetBodyCount() const
 {
-	return m_bodyList;
+	return m_bodyCount;
 }
 
 inline b2Joint* b2World::GetJointList()
@@ -130,9 +198,15 @@ inline b2Joint* b2World::GetJointList()
 	return m_jointList;
 }
 
-inline b2Contact* b2World::GetContactList()
+inline b2Contact* b2World::GetContact(int32 index)
+{
+	b2Assert(0 <= index && index < m_contactCount);
+	return m_contacts[index];
+}
+
+inline int32 b2World::GetContactCount() const
 {
-	return m_contactList;
+	return m_contactCount;
 }
 
 #endif
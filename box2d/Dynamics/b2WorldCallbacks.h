@@ -68,4 +68,32 @@ public:
 };
 
 extern b2CollisionFilter b2_defaultFilter;
+
+// A unit of work run by a b2TaskDispatcher.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	// Called once for each index of the run. The thread index is in
+	// [0, b2TaskDispatcher::GetThreadCount()), where 0 is the thread that called Run.
+	// Calls with different indices may run at the same time.
+	virtual void Execute(int32 index, int32 threadIndex) = 0;
+};
+
+// Implement this class to let the world evaluate contacts and solve islands
+// on several threads.
+// Provide it to b2World via b2World::SetTaskDispatcher().
+class b2TaskDispatcher
+{
+public:
+	virtual ~b2TaskDispatcher() {}
+
+	// The number of threads executing tasks, including the one calling Run.
+	virtual int32 GetThreadCount() const = 0;
+
+	// Execute the task for each index in [0, count). Returns when all are done.
+	virtual void Run(b2Task* task, int32 count) = 0;
+};
+
 #endif
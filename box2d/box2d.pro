@@ -2,14 +2,18 @@ SOURCES += Collision/b2BroadPhase.cpp \
 Collision/b2CollideCircle.cpp \
 Collision/b2CollidePoly.cpp \
 Collision/b2Distance.cpp \
+Collision/b2DynamicTree.cpp \
 Collision/b2PairManager.cpp \
+Collision/b2SAPBroadPhase.cpp \
 Collision/b2Shape.cpp \
+Collision/b2TreeBroadPhase.cpp \
 Common/b2BlockAllocator.cpp \
 Common/b2Settings.cpp \
 Common/b2StackAllocator.cpp \
 Dynamics/b2Body.cpp \
 Dynamics/b2ContactManager.cpp \
 Dynamics/b2Island.cpp \
+Dynamics/b2IslandManager.cpp \
 Dynamics/b2WorldCallbacks.cpp \
 Dynamics/b2World.cpp \
 Dynamics/Contacts/b2CircleContact.cpp \
@@ -27,8 +31,12 @@ Dynamics/Joints/b2PulleyJoint.cpp \
 Dynamics/Joints/b2RevoluteJoint.cpp
 HEADERS += Collision/b2BroadPhase.h \
 Collision/b2Collision.h \
+Collision/b2DynamicTree.h \
 Collision/b2PairManager.h \
+Collision/b2SAPBroadPhase.h \
 Collision/b2Shape.h \
+Collision/b2TreeBroadPhase.h \
+Collision/b2VertexSearch.h \
 Common/b2BlockAllocator.h \
 Common/b2Math.h \
 Common/b2Settings.h \
@@ -36,6 +44,7 @@ Common/b2StackAllocator.h \
 Dynamics/b2Body.h \
 Dynamics/b2ContactManager.h \
 Dynamics/b2Island.h \
+Dynamics/b2IslandManager.h \
 Dynamics/b2WorldCallbacks.h \
 Dynamics/b2World.h \
 Dynamics/Contacts/b2CircleContact.h \
@@ -0,0 +1,364 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski                                 *
+ *   maciej.gajewski0@gmail.com                                            *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// Compares broad-phase implementations on the same scenes. Each scene is built
+// from the same random seed for every implementation, so timings and pair
+// counts are directly comparable. Tree broad-phase pairs fattened AABBs, so
+// it reports more pairs (and contacts) than sweep and prune. Saved games are
+// run the same way as by the headless runner.
+
+// std
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Qt
+#include <QApplication>
+
+// box2d
+#include "b2World.h"
+#include "b2Body.h"
+#include "b2Shape.h"
+#include "b2BroadPhase.h"
+
+// local
+#include "cqevaluator.h"
+
+// constants
+static const int	DEFAULT_PROXIES		= 2000;		// proxies in raw scene, bodies in world scene
+static const int	DEFAULT_STEPS		= 600;		// steps per scene
+static const int	DEFAULT_MOVING		= 25;		// [%] of raw proxies moved each step
+static const double	DEFAULT_TIME_SPAN	= 60.0;		// [s] simulated time of saved game
+static const unsigned int SEED			= 12345;	// same scene for every implementation
+
+static const float32 WORLD_SIZE			= 200.0f;	// raw scene: proxies spread over square of this size
+static const float32 PROXY_SIZE			= 1.0f;		// raw scene: max proxy extent
+static const float32 PROXY_STEP			= 0.2f;		// raw scene: max move per step
+static const float32 TIME_STEP			= 1.0f / 60.0f;
+static const int	ITERATIONS			= 10;
+
+// ============================== implementations =====================
+struct Implementation
+{
+	b2BroadPhaseType	type;
+	const char*			name;
+};
+
+static const Implementation IMPLEMENTATIONS[] =
+{
+	{ e_sweepAndPruneBroadPhase,	"sap" },
+	{ e_dynamicTreeBroadPhase,		"tree" },
+};
+static const int IMPLEMENTATION_COUNT = sizeof( IMPLEMENTATIONS ) / sizeof( IMPLEMENTATIONS[0] );
+
+// ============================== pair counter =====================
+/// Pair callback which only counts pairs
+class PairCounter : public b2PairCallback
+{
+public:
+	PairCounter() : pairs( 0 ), added( 0 ) {}
+	
+	virtual void* PairAdded( void* proxyUserData1, void* /*proxyUserData2*/ )
+	{
+		pairs++;
+		added++;
+		return proxyUserData1; // anything but NULL
+	}
+	
+	virtual void PairRemoved( void* /*proxyUserData1*/, void* /*proxyUserData2*/, void* pairUserData )
+	{
+		if ( pairUserData )
+		{
+			pairs--;
+		}
+	}
+	
+	int pairs;		///< Currently existing pairs
+	int added;		///< Pairs added since creation
+};
+
+// ============================== seconds =====================
+static double seconds( clock_t start )
+{
+	return double( clock() - start ) / CLOCKS_PER_SEC;
+}
+
+// ============================== random aabb =====================
+static b2AABB randomAABB( const b2Vec2& center )
+{
+	b2Vec2 extents( b2Random( 0.1f, PROXY_SIZE ), b2Random( 0.1f, PROXY_SIZE ) );
+	
+	b2AABB aabb;
+	aabb.minVertex = center - extents;
+	aabb.maxVertex = center + extents;
+	
+	return aabb;
+}
+
+// ============================== raw scene =====================
+/// Drives broad-phase directly: random proxies, some of them move each step
+static void runRawScene( const Implementation& implementation, int proxies, int steps, int moving )
+{
+	srand( SEED );
+	
+	b2AABB worldAABB;
+	worldAABB.minVertex.Set( -WORLD_SIZE, -WORLD_SIZE );
+	worldAABB.maxVertex.Set( WORLD_SIZE, WORLD_SIZE );
+	
+	PairCounter counter;
+	b2BroadPhase* pBroadPhase = b2BroadPhase::Create( implementation.type, worldAABB, &counter );
+	
+	b2Vec2* centers = new b2Vec2[ proxies ];
+	int32* ids = new int32[ proxies ];
+	
+	// create
+	clock_t start = clock();
+	pBroadPhase->BeginBatch();
+	for( int i = 0; i < proxies; i++ )
+	{
+		centers[i].Set( b2Random( -0.5f, 0.5f ) * WORLD_SIZE, b2Random( -0.5f, 0.5f ) * WORLD_SIZE );
+		ids[i] = pBroadPhase->CreateProxy( randomAABB( centers[i] ), centers + i, false );
+	}
+	pBroadPhase->EndBatch();
+	pBroadPhase->Commit();
+	double createTime = seconds( start );
+	
+	// move
+	start = clock();
+	for( int step = 0; step < steps; step++ )
+	{
+		for( int i = 0; i < proxies; i++ )
+		{
+			if ( rand() % 100 >= moving )
+			{
+				continue;
+			}
+			
+			centers[i] += b2Vec2( b2Random() * PROXY_STEP, b2Random() * PROXY_STEP );
+			pBroadPhase->MoveProxy( ids[i], randomAABB( centers[i] ) );
+		}
+		pBroadPhase->Commit();
+	}
+	double moveTime = seconds( start );
+	int pairs = counter.pairs;
+	
+	// destroy, like a level teardown
+	start = clock();
+	for( int i = 0; i < proxies; i++ )
+	{
+		pBroadPhase->DestroyProxy( ids[i] );
+	}
+	double destroyTime = seconds( start );
+	
+	printf( "raw:   %-4s proxies=%d steps=%d moving=%d%% create=%.4fs step=%.3fms destroy=%.4fs pairs=%d pairs_added=%d\n"
+		, implementation.name, proxies, steps, moving
+		, createTime, moveTime * 1000.0 / steps, destroyTime, pairs, counter.added );
+	
+	b2BroadPhase::Destroy( pBroadPhase );
+	delete[] centers;
+	delete[] ids;
+}
+
+// ============================== world scene =====================
+/// Full simulation: boxes and disks falling onto ground and piling up
+static void runWorldScene( const Implementation& implementation, int bodies, int steps )
+{
+	srand( SEED );
+	
+	b2AABB worldAABB;
+	worldAABB.minVertex.Set( -WORLD_SIZE, -WORLD_SIZE );
+	worldAABB.maxVertex.Set( WORLD_SIZE, WORLD_SIZE );
+	
+	b2World world( worldAABB, b2Vec2( 0.0f, -10.0f ), true, implementation.type );
+	
+	// ground
+	b2BoxDef groundDef;
+	groundDef.extents.Set( WORLD_SIZE * 0.4f, 1.0f );
+	b2BodyDef groundBodyDef;
+	groundBodyDef.AddShape( &groundDef );
+	groundBodyDef.position.Set( 0.0f, -1.0f );
+	world.CreateBody( &groundBodyDef );
+	
+	// bodies, in columns over ground
+	b2BoxDef boxDef;
+	boxDef.density = 1.0f;
+	boxDef.friction = 0.5f;
+	b2CircleDef diskDef;
+	diskDef.density = 1.0f;
+	diskDef.friction = 0.5f;
+	
+	const int columns = 100;
+	for( int i = 0; i < bodies; i++ )
+	{
+		b2BodyDef bodyDef;
+		if ( i % 2 )
+		{
+			boxDef.extents.Set( b2Random( 0.2f, 0.4f ), b2Random( 0.2f, 0.4f ) );
+			bodyDef.AddShape( &boxDef );
+		}
+		else
+		{
+			diskDef.radius = b2Random( 0.2f, 0.4f );
+			bodyDef.AddShape( &diskDef );
+		}
+		bodyDef.position.Set( ( i % columns - columns / 2 ) * 1.0f + b2Random() * 0.1f, 1.0f + ( i / columns ) * 1.0f );
+		bodyDef.rotation = b2Random() * b2_pi;
+		world.CreateBody( &bodyDef );
+	}
+	
+	clock_t start = clock();
+	for( int step = 0; step < steps; step++ )
+	{
+		world.Step( TIME_STEP, ITERATIONS );
+	}
+	double stepTime = seconds( start );
+	
+	printf( "world: %-4s bodies=%d steps=%d step=%.3fms contacts=%d\n"
+		, implementation.name, bodies, steps, stepTime * 1000.0 / steps, world.GetContactCount() );
+}
+
+// ============================== level scene =====================
+/// Saved game, run like the headless runner runs it
+static bool runLevelScene( const Implementation& implementation, const char* path, double timeSpan )
+{
+	CqEvaluator::Scenario scenario;
+	scenario.path		= path;
+	scenario.type		= CqEvaluator::SavedGame;
+	scenario.timeSpan	= timeSpan;
+	scenario.seed		= SEED;
+	scenario.broadPhase	= implementation.type;
+	scenario.solverThreads	= 1;
+	scenario.constraintColoring	= true;
+	
+	CqEvaluator::Result result = CqEvaluator::evaluate( scenario );
+	if ( ! result.ok )
+	{
+		fprintf( stderr, "%s: %s\n", path, qPrintable( result.error ) );
+		return false;
+	}
+	
+	printf( "level: %-4s file=%s simulated=%.2fs wall=%.3fs wall_per_sim_second=%.4f\n"
+		, implementation.name, path, result.simulated, result.wallTime
+		, result.simulated > 0.0 ? result.wallTime / result.simulated : 0.0 );
+	
+	return true;
+}
+
+// ============================== usage =====================
+static void usage()
+{
+	fprintf( stderr,
+		"Usage: broadphasebench [-n proxies] [-s steps] [-m percent] [-b sap | tree] [-f file [-t seconds]]\n"
+		"Runs the same scenes with each broad-phase implementation and prints time per step.\n"
+		"  -n proxies  proxies in raw scene, bodies in world scene (default: %d)\n"
+		"  -s steps    steps per scene (default: %d)\n"
+		"  -m percent  raw proxies moved each step (default: %d)\n"
+		"  -b type     run only one implementation\n"
+		"  -f file     run saved game instead of raw and world scenes\n"
+		"  -t seconds  simulated time of saved game (default: %g)\n"
+		, DEFAULT_PROXIES, DEFAULT_STEPS, DEFAULT_MOVING, DEFAULT_TIME_SPAN );
+}
+
+// ============================== main =====================
+int main( int argc, char* argv[] )
+{
+	// GUI disabled - saved games need only QtGui classes, not a display
+	QApplication app( argc, argv, false );
+	
+	int proxies		= DEFAULT_PROXIES;
+	int steps		= DEFAULT_STEPS;
+	int moving		= DEFAULT_MOVING;
+	const char* only	= NULL;
+	const char* level	= NULL;
+	double timeSpan	= DEFAULT_TIME_SPAN;
+	
+	for( int i = 1; i < argc; i++ )
+	{
+		if ( ! strcmp( argv[i], "-n" ) && i + 1 < argc )
+		{
+			proxies = atoi( argv[++i] );
+		}
+		else if ( ! strcmp( argv[i], "-s" ) && i + 1 < argc )
+		{
+			steps = atoi( argv[++i] );
+		}
+		else if ( ! strcmp( argv[i], "-m" ) && i + 1 < argc )
+		{
+			moving = atoi( argv[++i] );
+		}
+		else if ( ! strcmp( argv[i], "-b" ) && i + 1 < argc )
+		{
+			only = argv[++i];
+		}
+		else if ( ! strcmp( argv[i], "-f" ) && i + 1 < argc )
+		{
+			level = argv[++i];
+		}
+		else if ( ! strcmp( argv[i], "-t" ) && i + 1 < argc )
+		{
+			timeSpan = atof( argv[++i] );
+		}
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+	
+	if ( proxies <= 0 || steps <= 0 || moving < 0 || moving > 100 || timeSpan <= 0.0 )
+	{
+		usage();
+		return 1;
+	}
+	
+	int ran = 0;
+	for( int i = 0; i < IMPLEMENTATION_COUNT; i++ )
+	{
+		if ( only && strcmp( only, IMPLEMENTATIONS[i].name ) )
+		{
+			continue;
+		}
+		
+		if ( level )
+		{
+			if ( ! runLevelScene( IMPLEMENTATIONS[i], level, timeSpan ) )
+			{
+				return 2;
+			}
+		}
+		else
+		{
+			runRawScene( IMPLEMENTATIONS[i], proxies, steps, moving );
+			runWorldScene( IMPLEMENTATIONS[i], proxies, steps );
+		}
+		ran++;
+	}
+	
+	if ( ! ran )
+	{
+		usage();
+		return 1;
+	}
+	
+	return 0;
+}
+
+// EOF
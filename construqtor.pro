@@ -2,6 +2,9 @@ SUBDIRS += \
 box2d \
 gpc\
 construqtor\
+headless\
+broadphasebench\
+vertexsearchtest\
 qrayon
 TEMPLATE = subdirs 
 CONFIG += warn_on \
@@ -0,0 +1,81 @@
+# Simulation core, shared by the construqtor GUI and the headless runner
+
+SOURCES += $$PWD/cqworld.cpp \
+$$PWD/cqsimulation.cpp \
+$$PWD/cqphysicalbody.cpp \
+$$PWD/cqphysicalbox.cpp \
+$$PWD/cqmaterial.cpp \
+$$PWD/cqjoint.cpp \
+$$PWD/cqrevolutejoint.cpp \
+$$PWD/cqnail.cpp \
+$$PWD/cqitem.cpp \
+$$PWD/cqgirder.cpp \
+$$PWD/cqphysicaldisk.cpp \
+$$PWD/cqwheel.cpp \
+$$PWD/cqwheelwithengine.cpp \
+$$PWD/cqcompounditem.cpp \
+$$PWD/cqmotorcontroller.cpp \
+$$PWD/cqrevolutevelocitycontroler.cpp \
+$$PWD/cqbolt.cpp \
+$$PWD/cqpolygonalbody.cpp \
+$$PWD/cqpolygontriangulator.cpp \
+$$PWD/cqstone.cpp \
+$$PWD/cqgroundbody.cpp \
+$$PWD/cqfragilerevolutejoint.cpp \
+$$PWD/cqdocument.cpp \
+$$PWD/cqelement.cpp \
+$$PWD/cqitemfactory.cpp \
+$$PWD/cqgroupitem.cpp \
+$$PWD/cqclipboard.cpp \
+$$PWD/cqprismaticjoint.cpp \
+$$PWD/cqhydrauliccylinder.cpp \
+$$PWD/cqprismatictraslationcontroller.cpp \
+$$PWD/cqpallet.cpp \
+$$PWD/gamemanager.cpp \
+$$PWD/cqworldthread.cpp \
+$$PWD/cqtaskpool.cpp \
+$$PWD/cqrandom.cpp \
+$$PWD/cqrecording.cpp \
+$$PWD/cqevaluator.cpp
+
+HEADERS += $$PWD/cqworld.h \
+$$PWD/cqsimulation.h \
+$$PWD/cqphysicalbody.h \
+$$PWD/cqphysicalbox.h \
+$$PWD/cqmaterial.h \
+$$PWD/cqjoint.h \
+$$PWD/cqrevolutejoint.h \
+$$PWD/cqnail.h \
+$$PWD/cqitemtypes.h \
+$$PWD/cqitem.h \
+$$PWD/cqgirder.h \
+$$PWD/cqphysicaldisk.h \
+$$PWD/cqwheel.h \
+$$PWD/cqwheelwithengine.h \
+$$PWD/cqcompounditem.h \
+$$PWD/cqmotorcontroller.h \
+$$PWD/cqrevolutevelocitycontroler.h \
+$$PWD/cqbolt.h \
+$$PWD/cqpolygonalbody.h \
+$$PWD/cqpolygontriangulator.h \
+$$PWD/cqstone.h \
+$$PWD/cqgroundbody.h \
+$$PWD/cqfragilerevolutejoint.h \
+$$PWD/gexception.h \
+$$PWD/cqdocument.h \
+$$PWD/cqelement.h \
+$$PWD/cqitemfactory.h \
+$$PWD/cqgroupitem.h \
+$$PWD/cqclipboard.h \
+$$PWD/cqprismaticjoint.h \
+$$PWD/cqhydrauliccylinder.h \
+$$PWD/cqprismatictraslationcontroller.h \
+$$PWD/cqpallet.h \
+$$PWD/gamemanager.h \
+$$PWD/cqworldthread.h \
+$$PWD/cqtaskpool.h \
+$$PWD/cqrandom.h \
+$$PWD/cqrecording.h \
+$$PWD/cqevaluator.h
+
+INCLUDEPATH += $$PWD
@@ -32,6 +32,7 @@ ControllerWidget::ControllerWidget(QWidget *parent)
 {
 	setupUi( this );
 	_pController = NULL;
+	_pSimulation = NULL;
 }
 
 // =========================== set controler ========================
@@ -41,6 +42,7 @@ void ControllerWidget::setController( CqMotorController* pController, CqSimulati
 	Q_ASSERT( pSimulation );
 	
 	_pController = pController;
+	_pSimulation = pSimulation;
 	connect( pController, SIGNAL(destroyed()), SLOT(controllerDestroyed()) );
 
 	connect( pSimulation, SIGNAL(simulationStep()), SLOT(simulationStep()));
@@ -66,7 +68,7 @@ void ControllerWidget::on_sliderDesiredValue_valueChanged( int value )
 	
 	double v = _pController->getMinValue() + 
 		( _pController->getMaxValue() - _pController->getMinValue() ) * value / 100.0;
-	_pController->setDesiredValue( v );
+	_pSimulation->setDesiredValue( _pController, v );
 }
 
 // ============================ simulation step =======================
@@ -92,6 +94,7 @@ void ControllerWidget::simulationStep()
 void ControllerWidget::controllerDestroyed()
 {
 	_pController = NULL;
+	_pSimulation = NULL;
 	deleteLater();
 }
 
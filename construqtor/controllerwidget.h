@@ -41,6 +41,7 @@ private slots:
 
 private:
 	CqMotorController* _pController;	///< Associated motor controler
+	CqSimulation* _pSimulation;			///< Simulation applying user input
 };
 
 #endif // CONTROLLERWIDGET_H
@@ -28,6 +28,7 @@
 #include "cqbolt.h"
 #include "cqsimulation.h"
 #include "cqitemfactory.h"
+#include "cqrandom.h"
 
 CQ_ADD_TO_FACTORY( CqBolt );
 CQ_ADD_TO_FACTORY( CqBrokenBolt );
@@ -52,7 +53,7 @@ void CqBolt::init()
 	setEditorFlags( editorFlags() & ~Rotatable );
 	
 	// TODO random rotation
-	setRotationRadians( qrand() * 2* M_PI / RAND_MAX );
+	setRotationRadians( CqRandom::uniform() * 2* M_PI );
 }
 
 // ========================== destructor ============================
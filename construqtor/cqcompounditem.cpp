@@ -212,13 +212,25 @@ void CqCompoundItem::updatePosToPhysical()
 		QPointF	posDiff	= posAfterInParent	- posBeforeInParent;
 		double	rotDiff	= rotAfter	- rotBefore;
 		
-		// follow child
-		moveBy( posDiff.x(), posDiff.y() );
-		setRotationRadians( rotationRadians() + rotDiff );
-		
-		// put child back on start pos
-		_followedChild->setPos( posBefore );
-		_followedChild->setRotationRadians( rotBefore );
+		if ( ! posDiff.isNull() || rotDiff != 0.0 )
+		{
+			// follow child
+			moveBy( posDiff.x(), posDiff.y() );
+			setRotationRadians( rotationRadians() + rotDiff );
+			
+			// put child back on start pos
+			_followedChild->setPos( posBefore );
+			_followedChild->setRotationRadians( rotBefore );
+			
+			// children positions are relative to moved compound now
+			foreach( CqItem* pChild, _children )
+			{
+				if ( pChild != _followedChild )
+				{
+					pChild->invalidateSyncedPose();
+				}
+			}
+		}
 	}
 	
 	// update children
@@ -231,6 +243,15 @@ void CqCompoundItem::updatePosToPhysical()
 	}
 }
 
+// ================================ invalidate synced pose =======================
+void CqCompoundItem::invalidateSyncedPose()
+{
+	foreach( CqItem* pChild, _children )
+	{
+		pChild->invalidateSyncedPose();
+	}
+}
+
 // ================================ set simulation ===============================
 void CqCompoundItem::setSimulation( CqSimulation* pSimulation )
 {
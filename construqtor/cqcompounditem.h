@@ -68,6 +68,7 @@ public:
 	
 	// signals from simulation
 	virtual void updatePosToPhysical();		///< Updates position and rotation to physical
+	virtual void invalidateSyncedPose();	///< Invalidates children
 	
 	// storing / reading
 	virtual void store( CqElement& element ) const;		///< stores item state 
@@ -124,11 +124,21 @@ CqElement CqDocument::createElement()
 	return e;
 }
 
+// ============================== set existing items ============
+void CqDocument::setExistingItems( const QList< CqItem* >& items )
+{
+	_existingItems.clear();
+	foreach( CqItem* pItem, items )
+	{
+		_existingItems.insert( pItem->id(), pItem );
+	}
+}
+
 // ============================== pre - create items ============
 void CqDocument::preCreateItems()
 {
 	// clear dictionry first
-	_items.clear();	
+	_items = _existingItems;
 	
 	QDomNodeList itemElements = _document.documentElement().elementsByTagName( CqElement::TAG_ITEM );
 	 
@@ -147,6 +157,13 @@ void CqDocument::preCreateItems()
 				qWarning("incomplete CqItem element"); // TODO some more helping info here
 				continue;
 			}
+			// existing items are used as they are
+			QUuid id( strId );
+			if ( _existingItems.contains( id ) )
+			{
+				continue;
+			}
+			
 			// create element
 			CqItem* pItem = CqItemFactory::createItem( strClass );
 			if ( ! pItem )
@@ -160,7 +177,6 @@ void CqDocument::preCreateItems()
 			//pItem->setParent( this );
 			
 			// store created element in dictionary
-			QUuid id( strId );
 			_items.insert( id, pItem );
 		}
 	}
@@ -25,6 +25,7 @@
 #include <QString>
 #include <QDomDocument>
 #include <QMap>
+#include <QList>
 #include <QUuid>
 
 // local
@@ -58,6 +59,10 @@ public:
 	
 	// item dictionary
 	CqItem* itemFromDictionary( const QUuid& id ) const { return _items[ id ]; }
+	/// Items which already exist. Call before loading. Items with their ids are not created nor
+	/// read from document, pointers to them are resolved to existing items.
+	void setExistingItems( const QList< CqItem* >& items );
+	bool isExistingItem( const QUuid& id ) const { return _existingItems.contains( id ); }
 	
 private:
 
@@ -69,7 +74,8 @@ private:
 	
 	QDomDocument	_document;		///< Actual document
 	
-	QMap< QUuid, CqItem* >	_items;	///< created items dictionary
+	QMap< QUuid, CqItem* >	_items;			///< created items dictionary
+	QMap< QUuid, CqItem* >	_existingItems;	///< items existing before document was loaded
 };
 
 #endif // CQDOCUMENT_H
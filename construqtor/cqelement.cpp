@@ -402,6 +402,12 @@ CqItem*	CqElement::itemFromElement( const QDomElement& element ) const
 		return NULL;
 	}
 	
+	// existing item is not read again
+	if ( _pDocument->isExistingItem( id ) )
+	{
+		return _pDocument->itemFromDictionary( id );
+	}
+	
 	// try get pre-created item
 	CqItem* pItem = _pDocument->itemFromDictionary( id );
 	
@@ -0,0 +1,198 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// Qt
+#include <QThread>
+#include <QTime>
+
+// local
+#include "cqevaluator.h"
+#include "cqsimulation.h"
+#include "gamemanager.h"
+#include "cqrecording.h"
+#include "cqrandom.h"
+#include "gexception.h"
+
+/**
+	Worker thread evaluating scenarios taken from evaluator's queue, until queue is empty.
+*/
+class CqEvaluatorThread : public QThread
+{
+public:
+	explicit CqEvaluatorThread( CqEvaluator* pEvaluator ) : QThread( NULL ), _pEvaluator( pEvaluator ) {}
+
+protected:
+
+	virtual void run()
+	{
+		// results vector is preallocated, each worker writes only elements it took
+		CqEvaluator::Result* pResults = _pEvaluator->_results.data();
+		
+		int index;
+		while ( ( index = _pEvaluator->takeScenario() ) >= 0 )
+		{
+			pResults[ index ] = CqEvaluator::evaluate( _pEvaluator->_scenarios[ index ] );
+		}
+	}
+
+private:
+
+	CqEvaluator* _pEvaluator;
+};
+
+// ============================== constructor =======================
+CqEvaluator::CqEvaluator()
+{
+	_next = 0;
+}
+
+// ============================== destructor ========================
+CqEvaluator::~CqEvaluator()
+{
+	// nope
+}
+
+// ============================== add scenario ======================
+void CqEvaluator::addScenario( const Scenario& scenario )
+{
+	_scenarios.append( scenario );
+}
+
+// =============================== clear ============================
+void CqEvaluator::clear()
+{
+	_scenarios.clear();
+	_results.clear();
+}
+
+// ================================ run =============================
+void CqEvaluator::run( int threads )
+{
+	if ( threads <= 0 )
+	{
+		threads = QThread::idealThreadCount();
+	}
+	threads = qBound( 1, threads, qMax( 1, _scenarios.size() ) );
+	
+	_next = 0;
+	_results.clear();
+	_results.resize( _scenarios.size() );
+	
+	QList<CqEvaluatorThread*> workers;
+	for( int i = 0; i < threads; i++ )
+	{
+		CqEvaluatorThread* pWorker = new CqEvaluatorThread( this );
+		pWorker->start();
+		workers.append( pWorker );
+	}
+	
+	foreach( CqEvaluatorThread* pWorker, workers )
+	{
+		pWorker->wait();
+		delete pWorker;
+	}
+}
+
+// ============================ take scenario =======================
+int CqEvaluator::takeScenario()
+{
+	QMutexLocker locker( &_mutex );
+	
+	if ( _next < _scenarios.size() )
+	{
+		return _next++;
+	}
+	
+	return -1;
+}
+
+// ============================== evaluate ==========================
+/// Creates simulation and game manager in calling thread, loads scenario and runs it.
+/// Nothing is shared with other threads, except item factory, whose creators are
+/// registered during static initialization and only read afterwards.
+CqEvaluator::Result CqEvaluator::evaluate( const Scenario& scenario )
+{
+	Result result;
+	result.ok			= false;
+	result.delivered	= false;
+	result.timeToTarget	= -1.0;
+	result.brokenJoints	= 0;
+	result.simulated	= 0.0;
+	result.wallTime		= 0.0;
+	
+	CqRandom::setSeed( scenario.seed );
+	
+	CqSimulation simulation;
+	simulation.setBroadPhase( scenario.broadPhase );
+	simulation.setSolverThreads( scenario.solverThreads );
+	simulation.setConstraintColoring( scenario.constraintColoring );
+	GameManager manager;
+	
+	manager.setInteractive( false );
+	manager.setSimulation( &simulation );
+	
+	CqRecording recording;
+	double timeSpan = scenario.timeSpan;
+	
+	try
+	{
+		switch( scenario.type )
+		{
+			case PlainSimulation:
+				simulation.loadFromXml( scenario.path );
+				break;
+				
+			case RecordedSession:
+				recording.loadFromFile( scenario.path );
+				manager.startReplay( &recording );
+				timeSpan = recording.length() / simulation.invTimeStep();
+				break;
+				
+			default:
+				manager.loadGame( scenario.path );
+		}
+	}
+	catch( const GException& e )
+	{
+		result.error = e.getMessage();
+		return result;
+	}
+	
+	double startTime = simulation.simulationTime();
+	QTime clock;
+	clock.start();
+	
+	simulation.run( timeSpan );
+	simulation.stopReplay();
+	
+	result.ok			= true;
+	result.wallTime		= clock.elapsed() / 1000.0;
+	result.simulated	= simulation.simulationTime() - startTime;
+	result.brokenJoints	= simulation.brokenJoints();
+	result.delivered	= manager.packageDelivered();
+	if ( result.delivered )
+	{
+		result.timeToTarget = manager.deliveryTime() - startTime;
+	}
+	
+	return result;
+}
+
+// EOF
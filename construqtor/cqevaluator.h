@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef CQEVALUATOR_H
+#define CQEVALUATOR_H
+
+// Qt
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+
+// box2d
+#include "b2BroadPhase.h"
+
+/**
+	Runs many independent scenarios - saved games, plain simulations or recorded sessions - 
+	on a pool of threads and collects their outcome metrics. Each scenario is evaluated in 
+	its own CqSimulation and GameManager, created in the worker thread, so scenarios share 
+	no mutable state and use all available cores.
+	@author Maciek Gajewski <maciej.gajewski0@gmail.com>
+*/
+class CqEvaluator
+{
+public:
+	
+	/// Kind of file describing scenario
+	enum ScenarioType
+	{
+		SavedGame,			///< Saved game: level and construction
+		PlainSimulation,	///< Plain simulation file, without game rules
+		RecordedSession		///< Recorded session: saved game and controller inputs
+	};
+	
+	/// Scenario to evaluate
+	struct Scenario
+	{
+		QString			path;		///< Scenario file
+		ScenarioType	type;		///< File type
+		double			timeSpan;	///< Simulated time, ignored for recorded sessions [s]
+		quint32			seed;		///< Random generator seed
+		b2BroadPhaseType	broadPhase;	///< Box2D broad-phase algorithm
+		int				solverThreads;	///< Threads solving islands of this scenario
+		bool			constraintColoring;	///< Solve large islands in colored constraint batches. Replays use recorded setting
+	};
+	
+	/// Scenario outcome
+	struct Result
+	{
+		bool	ok;				///< If scenario was loaded and run
+		QString	error;			///< Error message, if not ok
+		bool	delivered;		///< If package was delivered to target
+		double	timeToTarget;	///< Time from start to delivery, negative if not delivered [s]
+		int		brokenJoints;	///< Joints broken during run
+		double	simulated;		///< Simulated time [s]
+		double	wallTime;		///< Real time used [s]
+	};
+	
+	// construction / destruction
+	CqEvaluator();
+	~CqEvaluator();
+	
+	// scenarios
+	void addScenario( const Scenario& scenario );
+	void clear();												///< Removes scenarios and results
+	const QList<Scenario>& scenarios() const { return _scenarios; }
+	
+	// operations
+	/// Evaluates all scenarios using up to \a threads threads, 0 means one per core. Blocks until done.
+	void run( int threads = 0 );
+	/// Results, in scenarios order. Valid after run().
+	const QVector<Result>& results() const { return _results; }
+	
+	/// Evaluates single scenario in calling thread
+	static Result evaluate( const Scenario& scenario );
+
+private:
+
+	friend class CqEvaluatorThread;
+	
+	int takeScenario();									///< Returns index of next scenario to evaluate, or -1
+
+	// data
+	
+	QList<Scenario>	_scenarios;		///< Scenarios to evaluate
+	QVector<Result>	_results;		///< Results, in scenarios order
+	int				_next;			///< Next scenario to evaluate
+	QMutex			_mutex;			///< Guards _next
+};
+
+#endif // CQEVALUATOR_H
+
+// EOF
@@ -18,10 +18,14 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+// Qt
+#include <QDataStream>
+
 // box2d
 #include "b2Joint.h"
 
 // local
+#include "cqworld.h"
 #include "cqsimulation.h"
 #include "cqfragilerevolutejoint.h"
 	
@@ -63,6 +67,18 @@ void CqFragileRevoluteJoint::init()
 
 }
 
+// ================================= set simulation ============
+void CqFragileRevoluteJoint::setSimulation( CqSimulation* pSimulation )
+{
+	CqRevoluteJoint::setSimulation( pSimulation );
+	
+	if ( pSimulation )
+	{
+		// evaluate stress after controllers has applied forces
+		pSimulation->subscribeCalculationStep( this, CqSimulation::PriorityStress );
+	}
+}
+
 // ================================= calculation step ==========
 void CqFragileRevoluteJoint::calculationStep()
 {
@@ -98,12 +114,49 @@ void CqFragileRevoluteJoint::calculationStep()
 	
 	else if ( _temperature >= 1.0 )
 	{
-		// update last time before possible deletion
+		// simulation will call breakUnderLoad() outside of calculation step
 		_temperature = 1.0;
-		update();
-		broken(); // NOTE propably deletes this (which is cool, by the way ;) )
-		return;
+		simulation()->jointBroken( this );
+	}
+	
+	publishTemperature();
+}
+
+// ================================= temperature ===============
+double CqFragileRevoluteJoint::temperature() const
+{
+	// temperature is calculated by worker thread, read published one
+	CqJointState state;
+	if ( jointState( &state ) )
+	{
+		return state.temperature;
 	}
+	
+	return _temperature;
+}
+
+// ================================= publish temperature =======
+void CqFragileRevoluteJoint::publishTemperature()
+{
+	if ( b2joint() && world() )
+	{
+		world()->setJointTemperature( stateSlot(), _temperature );
+	}
+}
+
+// ================================= joint created =============
+void CqFragileRevoluteJoint::jointCreated()
+{
+	CqRevoluteJoint::jointCreated();
+	publishTemperature();
+}
+
+// ================================= break under load ==========
+void CqFragileRevoluteJoint::breakUnderLoad()
+{
+	// update last time before possible deletion
+	update();
+	broken(); // NOTE propably deletes this (which is cool, by the way ;) )
 }
 
 
@@ -155,5 +208,23 @@ void CqFragileRevoluteJoint::load( const CqElement& element )
 	
 }
 
+// ============================== store dynamic state ======================
+void CqFragileRevoluteJoint::storeDynamicState( QDataStream& stream ) const
+{
+	CqRevoluteJoint::storeDynamicState( stream );
+	
+	stream << _temperature;
+}
+
+// ============================= restore dynamic state =====================
+void CqFragileRevoluteJoint::restoreDynamicState( QDataStream& stream )
+{
+	CqRevoluteJoint::restoreDynamicState( stream );
+	
+	stream >> _temperature;
+	publishTemperature();
+	update();
+}
+
 // EOF
 
@@ -42,11 +42,14 @@ public:
 	virtual ~CqFragileRevoluteJoint();
 	
 	// info from simulatiom
+	/// Extends base implementation by subscribing stress evaluation
+	virtual void setSimulation( CqSimulation* pSimulation );
 	virtual void calculationStep();						///< Called on simulation step
 	virtual void simulationStep();						///< Called on simulation step
+	void breakUnderLoad();								///< Breaks overheated joint. Called by simulation
 	
 	// properties
-	double temperature() const { return _temperature; }
+	double temperature() const;		///< Temperature published by world, for GUI thread
 	
 	void setToleratedTorque( double t ) { _toleratedTorque = t; }
 	double toleratedTorque() const { return _toleratedTorque; }
@@ -70,20 +73,24 @@ public:
 	// storing / reading
 	virtual void store( CqElement& element ) const;		///< stores item state 
 	virtual void load( const CqElement& element );		///< restores item state 
+	virtual void storeDynamicState( QDataStream& stream ) const;	///< stores temperature
+	virtual void restoreDynamicState( QDataStream& stream );		///< restores temperature
 
 
 protected:
 
 	virtual void broken() = 0;		//!< called when joint is breaked
+	virtual void jointCreated();	///< Publishes initial temperature
 	
 private:
 
 	// methods
 	
 	void init();
+	void publishTemperature();		///< Passes temperature to world, to be published with joint state
 	
 	// state
-	double _temperature;			///< Current temperature (0-1)
+	double _temperature;			///< Current temperature (0-1), calculated on worker thread
 	
 	
 	// params
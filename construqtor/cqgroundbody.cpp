@@ -25,6 +25,7 @@
 #include "cqsimulation.h"
 #include "cqgroundbody.h"
 #include "cqitemfactory.h"
+#include "cqrandom.h"
 
 CQ_ADD_TO_FACTORY( CqGroundBody );
 
@@ -107,14 +108,14 @@ CqGroundBody* CqGroundBody::randomGround( const QRectF& rect, double maxSlope )
 	
 	for ( int i = 0; i < SECTIONS; i++ )
 	{
-		targets[ i ] = MIN_HEIGHT + ( MAX_HEIGHT - MIN_HEIGHT ) * double(qrand()) / RAND_MAX;
+		targets[ i ] = MIN_HEIGHT + ( MAX_HEIGHT - MIN_HEIGHT ) * CqRandom::uniform();
 	}
 	
 	// now - randomize slices
 	QPolygonF points;
 	
 	// intial height
-	double height = MIN_HEIGHT + ( MAX_HEIGHT - MIN_HEIGHT ) * double(qrand()) / RAND_MAX;
+	double height = MIN_HEIGHT + ( MAX_HEIGHT - MIN_HEIGHT ) * CqRandom::uniform();
 	
 	// first points - left safe area
 	points.append( QPointF( 0, height ) );
@@ -124,7 +125,7 @@ CqGroundBody* CqGroundBody::randomGround( const QRectF& rect, double maxSlope )
 	double x = SAFEAREA_WIDTH;
 	while ( x < ( worldWidth - SAFEAREA_WIDTH - MAX_SLICE_WIDTH ) )
 	{
-		double sliceWidth = MIN_SLICE_WIDTH + ( MAX_SLICE_WIDTH - MIN_SLICE_WIDTH ) * double(qrand()) / RAND_MAX;
+		double sliceWidth = MIN_SLICE_WIDTH + ( MAX_SLICE_WIDTH - MIN_SLICE_WIDTH ) * CqRandom::uniform();
 		
 		// find out which section is it
 		double sectionReal = ( x - SAFEAREA_WIDTH ) / ( ( worldWidth - 2*SAFEAREA_WIDTH ) / SECTIONS );
@@ -147,7 +148,7 @@ CqGroundBody* CqGroundBody::randomGround( const QRectF& rect, double maxSlope )
 		if ( calculatedSlope < -MAX_SLOPE ) calculatedSlope = -MAX_SLOPE;
 		
 		// add randomization
-		double slope = calculatedSlope - SLOPE_VARIATION + 2*SLOPE_VARIATION*( double(qrand()) / RAND_MAX );
+		double slope = calculatedSlope - SLOPE_VARIATION + 2*SLOPE_VARIATION*( CqRandom::uniform() );
 		
 		// calculate new height
 		height = height + slope * sliceWidth;
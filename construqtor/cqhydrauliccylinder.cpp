@@ -97,8 +97,15 @@ void CqHydraulicCylinder::setSimulation( CqSimulation* pSimulation )
 	Q_ASSERT( pSimulation );
 	CqCompoundItem::setSimulation( pSimulation );
 	
+	_controller.setOwner( this );
 	pSimulation->addController( &_controller );
-	connect( pSimulation, SIGNAL(calculationStep()), &_controller, SLOT(calculationStep()) );
+	pSimulation->subscribeCalculationStep( this, CqSimulation::PriorityControl );
+}
+
+// ===========================================================================
+void CqHydraulicCylinder::calculationStep()
+{
+	_controller.calculationStep();
 }
 
 // ===========================================================================
@@ -72,6 +72,7 @@ public:
 	
 	/// Extends base implementation by adding controller to simulation
 	virtual void setSimulation( CqSimulation* pSimulation );
+	virtual void calculationStep();		///< Runs controller
 	
 	/// Returns sub-body after point, for conection purposes
 	virtual CqPhysicalBody* bodyHere( const QPointF& worldPoint );
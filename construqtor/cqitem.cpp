@@ -48,6 +48,11 @@ CqItem::CqItem( CqItem* parent )
 // ========================== destructor ======================
 CqItem::~CqItem()
 {
+	if ( _pSimulation )
+	{
+		_pSimulation->unregisterItem( this );
+	}
+	
 	if ( _pPhysicalParent )
 	{
 		CqItem* pParent = _pPhysicalParent;
@@ -328,6 +333,11 @@ void CqItem::setPhysicalParent( CqItem* pParent )
 		_pPhysicalParent = pParent;
 		setParentItem( pParent );	// parent item
 		
+		if ( _pSimulation )
+		{
+			_pSimulation->itemParentChanged( this );
+		}
+		
 		CqCompoundItem* pCompoundParent = qobject_cast< CqCompoundItem* >( pParent );
 		if ( pCompoundParent )
 		{
@@ -336,6 +346,25 @@ void CqItem::setPhysicalParent( CqItem* pParent )
 	}
 }
 
+// =============================================================
+void CqItem::setSimulation( CqSimulation* pSimulation )
+{
+	if ( pSimulation != _pSimulation )
+	{
+		if ( _pSimulation )
+		{
+			_pSimulation->unregisterItem( this );
+		}
+		
+		_pSimulation = pSimulation;
+		
+		if ( _pSimulation )
+		{
+			_pSimulation->registerItem( this );
+		}
+	}
+}
+
 // =============================================================
 void CqItem::generateNewId()
 {
@@ -27,6 +27,7 @@
 
 // local
 #include "cqelement.h"
+class QDataStream;
 class CqSimulation;
 class CqWorld;
 class CqPhysicalBody;
@@ -71,17 +72,19 @@ public:
 	
 	// signals form simulation
 	virtual void simulationStep();						///< Called on simulation step
-	virtual void calculationStep(){};					///< Called on low-level box2d simulatio step
+	/// Called on low-level box2d simulatio step. Only for items subscribed with CqSimulation::subscribeCalculationStep()
+	virtual void calculationStep(){};
 	virtual void simulationStarted();					///< Caled when simulatio is started
 	virtual void simulationStopped();					///< Caled when simulatio is started
 	
 	// properties
-	virtual void setSimulation( CqSimulation* pSimulation ) { _pSimulation = pSimulation; }
+	virtual void setSimulation( CqSimulation* pSimulation );	///< Sets simulation, registers item in it
 	CqSimulation* simulation() { return _pSimulation; }
 	const CqSimulation* simulation() const { return _pSimulation; }
 	
 	virtual void setWorld ( CqWorld* pWorld );			///< Sets world
 	CqWorld* world() { return _pWorld; }				///< Returns world
+	const CqWorld* world() const { return _pWorld; }
 	
 	virtual void setRotationRadians( double radians );	///< sets rotation in radians
 	virtual double rotationRadians() const { return _rotation; } ///< Retuens rotation
@@ -149,12 +152,19 @@ public:
 	
 	virtual void updatePhysicalPos(){};				///< Updates physical pos to item pos/rotation
 	virtual void updatePosToPhysical(){};			///< Updates item pos to physical pos (after simulation step)
+	virtual void invalidateSyncedPose(){};			///< Forces next updatePosToPhysical() to update item
 	
 	
 	// storing / reading
 	virtual void store( CqElement& element ) const;		///< stores item state 
 	virtual void load( const CqElement& element );		///< restores item state 
 	
+	// dynamic state snapshot
+	/// Stores state which changes during simulation. Used for fast resetting of simulation
+	virtual void storeDynamicState( QDataStream& /*stream*/ ) const {}
+	/// Restores state stored by storeDynamicState()
+	virtual void restoreDynamicState( QDataStream& /*stream*/ ) {}
+	
 protected:
 	
 	// input handlers
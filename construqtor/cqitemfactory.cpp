@@ -29,9 +29,10 @@ void CqItemFactory::addCreator( const QString& className, Creator* pCreator )
 }
 
 // =====================================================
+/// Only reads creators map, so it may be called from many threads at once.
 CqItem* CqItemFactory::createItem( const QString& className )
 {
-	Creator* pCreator = instance()->_creators[ className ];
+	Creator* pCreator = instance()->_creators.value( className );
 	if ( pCreator )
 	{
 		return pCreator->createObject();
@@ -55,6 +55,7 @@ void CqJoint::init()
 	_pBody1 = NULL;
 	_pBody2 = NULL;
 	_pJoint = NULL;
+	_stateSlot = -1;
 }
 
 // =========================== assure joint created  ===================
@@ -66,7 +67,13 @@ void CqJoint::assureJointCreated()
 	
 	if ( ! _pJoint )
 	{
+		QMutexLocker locker( world()->mutex() );
 		_pJoint = createJoint(world());
+		if ( _pJoint )
+		{
+			_stateSlot = world()->addJoint( _pJoint );
+			jointCreated();
+		}
 	}
 }
 
@@ -87,9 +94,18 @@ void CqJoint::destroyJoint( CqWorld* pWorld )
 	Q_ASSERT( pWorld );
 	Q_ASSERT( _pJoint );
 	
+	QMutexLocker locker( pWorld->mutex() );
+	pWorld->forgetJoint( _stateSlot );
 	pWorld->DestroyJoint( _pJoint );
 	
 	_pJoint = NULL;
+	_stateSlot = -1;
+}
+
+// =========================== joint state  ===================
+bool CqJoint::jointState( CqJointState* pState ) const
+{
+	return _pJoint && world() && world()->jointState( _stateSlot, pState );
 }
 
 // =========================== type  ===================
@@ -146,7 +162,14 @@ void CqJoint::recreateJoint()
 		Q_ASSERT( pWorld );
 		
 		destroyJoint( pWorld );
+		
+		QMutexLocker locker( pWorld->mutex() );
 		_pJoint = createJoint( pWorld );
+		if ( _pJoint )
+		{
+			_stateSlot = pWorld->addJoint( _pJoint );
+			jointCreated();
+		}
 	}
 }
 
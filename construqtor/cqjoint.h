@@ -30,6 +30,7 @@ class b2Joint;
 #include "cqitem.h"
 class CqPhysicalBody;
 class CqWorld;
+struct CqJointState;
 
 /**
 	Graphics item representign general Box 2D's joint
@@ -54,6 +55,9 @@ public:
 	
 	b2Joint* b2joint() { return _pJoint; }
 	const b2Joint* b2joint() const { return _pJoint; }
+	int stateSlot() const { return _stateSlot; }	///< Slot in state published by world
+	/// Reads joint state published by world. Safe to call while simulation is stepped on worker thread
+	bool jointState( CqJointState* pState ) const;
 	
 	// info from simulation
 	void assureJointCreated();				///< Makes sure that body was created
@@ -76,6 +80,7 @@ protected:
 	// remplementables
 	
 	virtual b2Joint* createJoint( CqWorld* pWorld ) = 0;
+	virtual void jointCreated() {}	///< Called after joint was created and added to world's published state
 	void destroyJoint( CqWorld* pWorld );
 	
 	void recreateJoint();			///< Called when joint params is changedm so B2D joint has to be re-created
@@ -91,6 +96,7 @@ private:
 	// data
 	
 	b2Joint*	_pJoint;			///< Physical joint object
+	int			_stateSlot;			///< Joint's slot in state published by world
 	CqPhysicalBody		*_pBody1, *_pBody2;	///< Bodies connected by joint
 };
 
@@ -21,6 +21,7 @@
 
 CqMotorController::CqMotorController(QObject* parent): QObject(parent)
 {
+	_pOwner = NULL;
 }
 
 
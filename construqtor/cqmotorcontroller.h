@@ -23,6 +23,9 @@
 // Qt
 #include <QObject>
 
+// local
+class CqItem;
+
 /**
 	Common interface for al motor controlls. Contains generic methods used by 
 	GUI to query and set motor controller state.
@@ -47,6 +50,10 @@ public:
 	double getMinForce() const { return _forceMin; }
 	virtual double getCurrentForce() const = 0;
 	
+	// owner
+	void setOwner( CqItem* pOwner ) { _pOwner = pOwner; }
+	CqItem* owner() const { return _pOwner; }		///< Item containing controller, identifies it in recordings
+	
 	
 protected:
 
@@ -54,6 +61,10 @@ protected:
 	
 	double _forceMax, _forceMin;			///< force limits
 	double _valueMax, _valueMin;			///< Value limits
+	
+private:
+
+	CqItem*	_pOwner;						///< Owning item
 
 };
 
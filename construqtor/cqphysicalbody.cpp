@@ -20,6 +20,7 @@
 
 // Qt
 #include <QPainter>
+#include <QDataStream>
 
 // box2d
 #include "b2Body.h"
@@ -56,7 +57,9 @@ CqPhysicalBody::~CqPhysicalBody()
 void CqPhysicalBody::init()
 {
 	_pBody = NULL;
+	_poseSlot = -1;
 	_initialAngluarVelocity = 0.0;
+	_poseSynced = false;
 	// make rotatable
 	setEditorFlags( editorFlags() | Rotatable );
 }
@@ -105,7 +108,9 @@ void CqPhysicalBody::createBody( CqWorld* pWorld )
 	bodyDef.angularDamping	= 0.001;
 	
 	// create body
+	QMutexLocker locker( pWorld->mutex() );
 	_pBody = pWorld->CreateBody(&bodyDef);
+	_poseSlot = pWorld->addBody( _pBody );
 	
 	// get center pos
 	b2Vec2 cog = _pBody->GetCenterPosition();
@@ -130,14 +135,21 @@ void CqPhysicalBody::createBody( CqWorld* pWorld )
 // =========================== update to physical ===================================
 void CqPhysicalBody::updatePosToPhysical()
 {
-	if ( _pBody )
+	// use pose published by world - body may be simulated by worker thread right now
+	CqBodyPose pose;
+	if ( _pBody && world() && world()->bodyPose( _poseSlot, &pose ) )
 	{
-		b2Vec2		b2pos		= _pBody->GetCenterPosition();
-		double		b2rotation	= _pBody->GetRotation();
+		// sleeping and static bodies don't move - don't touch the scene
+		if ( _poseSynced && pose.position == _syncedPose.position && pose.rotation == _syncedPose.rotation )
+		{
+			return;
+		}
 		
-		setWorldPos( QPointF( b2pos.x, b2pos.y ) - centerRotated() ); // correct pos by COG
-		setWorldRotation( b2rotation );
+		setWorldPos( QPointF( pose.position.x, pose.position.y ) - centerRotated() ); // correct pos by COG
+		setWorldRotation( pose.rotation );
 		
+		_syncedPose = pose;
+		_poseSynced = true;
 	}
 }
 
@@ -162,8 +174,12 @@ void CqPhysicalBody::destroyBody( CqWorld* pWorld )
 	Q_ASSERT( pWorld );
 	Q_ASSERT( _pBody );
 	
+	QMutexLocker locker( pWorld->mutex() );
+	pWorld->forgetBody( _poseSlot );
 	pWorld->DestroyBody( _pBody );
 	_pBody = NULL;
+	_poseSlot = -1;
+	_poseSynced = false;
 }
 
 // =========================== type  ===================
@@ -191,6 +207,7 @@ void CqPhysicalBody::breakAllJoints()
 void CqPhysicalBody::updatePhysicalPos()
 {
 	CqItem::updatePhysicalPos();
+	_poseSynced = false;
 	if ( _pBody )
 	{
 		QPointF pp	= worldPos() + centerRotated(); // correct physical pos by COG shift
@@ -290,6 +307,7 @@ void CqPhysicalBody::debugDrawCollision( QPainter* pPainter )
 void CqPhysicalBody::simulationStarted()
 {
 	CqItem::simulationStarted();
+	_poseSynced = false;
 	
 	if ( _pBody )
 	{
@@ -358,6 +376,58 @@ void CqPhysicalBody::load( const CqElement& element )
 	}
 }
 
+// ============================== store dynamic state ======================
+void CqPhysicalBody::storeDynamicState( QDataStream& stream ) const
+{
+	CqItem::storeDynamicState( stream );
+	
+	stream << bool( _pBody != NULL );
+	if ( _pBody )
+	{
+		b2Vec2	position	= _pBody->GetCenterPosition();
+		b2Vec2	velocity	= _pBody->GetLinearVelocity();
+		
+		stream << position.x << position.y << _pBody->GetRotation();
+		stream << velocity.x << velocity.y << _pBody->GetAngularVelocity();
+		stream << _pBody->IsSleeping() << _pBody->m_sleepTime;
+	}
+}
+
+// ============================= restore dynamic state =====================
+void CqPhysicalBody::restoreDynamicState( QDataStream& stream )
+{
+	CqItem::restoreDynamicState( stream );
+	
+	bool hasBody;
+	stream >> hasBody;
+	if ( hasBody )
+	{
+		b2Vec2	position, velocity;
+		float32	rotation, angularVelocity, sleepTime;
+		bool	sleeping;
+		
+		stream >> position.x >> position.y >> rotation;
+		stream >> velocity.x >> velocity.y >> angularVelocity;
+		stream >> sleeping >> sleepTime;
+		
+		if ( _pBody )
+		{
+			_pBody->SetCenterPosition( position, rotation );
+			_pBody->SetLinearVelocity( velocity );
+			_pBody->SetAngularVelocity( angularVelocity );
+			
+			_pBody->WakeUp();
+			if ( sleeping )
+			{
+				_pBody->PutToSleep();
+			}
+			_pBody->m_sleepTime = sleepTime;
+		}
+	}
+	
+	_poseSynced = false;
+}
+
 // ==============================================================
 void CqPhysicalBody::wakeUp()
 {
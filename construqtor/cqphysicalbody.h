@@ -82,6 +82,7 @@ public:
 	// signals from simulation
 	
 	virtual void updatePosToPhysical();		///< Updates position and rotation to physical
+	virtual void invalidateSyncedPose() { _poseSynced = false; }
 	virtual void assureBodyCreated();		///< Makes sure that body was created
 	virtual void updatePhysicalPos();		///< Updates body pos to item positon/rotation
 	virtual void simulationStarted();		///< Caled when simulatio is started
@@ -94,6 +95,8 @@ public:
 	// storing / reading
 	virtual void store( CqElement& element ) const;		///< stores item state 
 	virtual void load( const CqElement& element );		///< restores item state 
+	virtual void storeDynamicState( QDataStream& stream ) const;	///< stores pose and velocities
+	virtual void restoreDynamicState( QDataStream& stream );		///< restores pose and velocities
 	
 	
 protected:
@@ -126,6 +129,7 @@ private:
 	// data
 
 	b2Body*	_pBody;						///< Body itself
+	int		_poseSlot;					///< Body's slot in poses published by world
 	CqMaterial	_material;				///< Material used
 	
 	QBrush		_brush;					///< Brush used to paint item
@@ -134,6 +138,9 @@ private:
 	double		_initialAngluarVelocity;	///< Initial angular velocity for created body
 	QPointF		_initialLinearVelocity;		///< Initial linear velocity
 	
+	CqBodyPose	_syncedPose;				///< Pose item was last updated to
+	bool		_poseSynced;				///< If _syncedPose is valid
+	
 };
 
 #endif // CQPHYSICALBODY_H
@@ -18,6 +18,9 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+// Qt
+#include <QDataStream>
+
 // Box2D
 #include "b2PrismaticJoint.h"
 
@@ -118,11 +121,11 @@ b2Joint* CqPrismaticJoint::createJoint(CqWorld* pWorld)
 // ==========================================================================
 void CqPrismaticJoint::updatePosToPhysical()
 {
-	if ( b2joint() )
+	// use anchor published by world - joint may be simulated by worker thread right now
+	CqJointState state;
+	if ( jointState( &state ) )
 	{
-		b2PrismaticJoint* pJoint = (b2PrismaticJoint*)b2joint();
-		b2Vec2 pos = pJoint->GetAnchor1();
-		setWorldPos( QPointF(pos.x, pos.y) - _anchorPoint );
+		setWorldPos( QPointF(state.anchor.x, state.anchor.y) - _anchorPoint );
 	}
 }
 
@@ -212,6 +215,45 @@ void CqPrismaticJoint::load( const CqElement& element )
 	_initialTranslation = element.readDouble( TAG_JOINT_TRANSLATION );
 }
 
+// ============================== store dynamic state ======================
+void CqPrismaticJoint::storeDynamicState( QDataStream& stream ) const
+{
+	CqJoint::storeDynamicState( stream );
+	
+	const b2PrismaticJoint* pJoint = (const b2PrismaticJoint*)b2joint();
+	stream << bool( pJoint != NULL );
+	if ( pJoint )
+	{
+		// accumulated impulses are used for warm-starting
+		stream << pJoint->m_linearImpulse << pJoint->m_angularImpulse;
+		stream << pJoint->m_motorImpulse << pJoint->m_limitImpulse << pJoint->m_limitPositionImpulse;
+	}
+}
+
+// ============================= restore dynamic state =====================
+void CqPrismaticJoint::restoreDynamicState( QDataStream& stream )
+{
+	CqJoint::restoreDynamicState( stream );
+	
+	bool hasJoint;
+	stream >> hasJoint;
+	if ( hasJoint )
+	{
+		float32 impulses[5];
+		stream >> impulses[0] >> impulses[1] >> impulses[2] >> impulses[3] >> impulses[4];
+		
+		b2PrismaticJoint* pJoint = (b2PrismaticJoint*)b2joint();
+		if ( pJoint )
+		{
+			pJoint->m_linearImpulse = impulses[0];
+			pJoint->m_angularImpulse = impulses[1];
+			pJoint->m_motorImpulse = impulses[2];
+			pJoint->m_limitImpulse = impulses[3];
+			pJoint->m_limitPositionImpulse = impulses[4];
+		}
+	}
+}
+
 // =====================================================================
 void CqPrismaticJoint::setMaxForce( double f )
 {
@@ -260,6 +302,19 @@ double CqPrismaticJoint::translation() const
 	return _initialTranslation;
 }
 
+// =====================================================================
+/// Unlike translation(), it can be called while worker thread steps the world
+double CqPrismaticJoint::publishedTranslation() const
+{
+	CqJointState state;
+	if ( jointState( &state ) )
+	{
+		return state.translation + _initialTranslation;
+	}
+	
+	return _initialTranslation;
+}
+
 // EOF
 
 
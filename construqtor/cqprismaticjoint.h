@@ -75,9 +75,12 @@ public:
 	// storing / reading
 	virtual void store( CqElement& element ) const;		///< stores item state 
 	virtual void load( const CqElement& element );		///< restores item state 
+	virtual void storeDynamicState( QDataStream& stream ) const;	///< stores accumulated impulses
+	virtual void restoreDynamicState( QDataStream& stream );		///< restores accumulated impulses
 
 	// state
-	double translation() const;	///< Current ternaslation
+	double translation() const;				///< Current ternaslation
+	double publishedTranslation() const;	///< Translation published by world, for GUI thread
 
 private:
 	
@@ -54,10 +54,11 @@ void CqPrismaticTraslationController::init()
 // ====================================================================
 double CqPrismaticTraslationController::getCurrentForce() const
 {
-	if ( _pJoint && _pJoint->b2joint() )
+	// read state published by world - joint may be simulated by worker thread right now
+	CqJointState state;
+	if ( _pJoint && _pJoint->jointState( &state ) )
 	{
-		b2PrismaticJoint* pJoint = (b2PrismaticJoint*)_pJoint->b2joint();
-		double force =  pJoint->GetMotorForce( _pJoint->simulation()->invTimeStep() );
+		double force = state.motorImpulse * _pJoint->simulation()->invTimeStep();
 		return force;
 	}
 
@@ -69,7 +70,7 @@ double CqPrismaticTraslationController::getCurrentValue() const
 {
 	if ( _pJoint )
 	{
-		return _pJoint->translation();
+		return _pJoint->publishedTranslation();
 	}
 
 	return 0.0;
@@ -0,0 +1,65 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// Qt
+#include <QThreadStorage>
+
+// local
+#include "cqrandom.h"
+
+// constants
+static const quint32 DEFAULT_SEED = 1;
+
+static QThreadStorage<quint32*> threadState;	///< Per-thread generator state
+
+// ============================== state =============================
+quint32& CqRandom::state()
+{
+	if ( ! threadState.hasLocalData() )
+	{
+		threadState.setLocalData( new quint32( DEFAULT_SEED ) );
+	}
+	
+	return *threadState.localData();
+}
+
+// ============================= set seed ===========================
+void CqRandom::setSeed( quint32 seed )
+{
+	state() = seed;
+}
+
+// =============================== next =============================
+quint32 CqRandom::next()
+{
+	// linear congruential generator, constants from Numerical Recipes
+	quint32& s = state();
+	s = s * 1664525u + 1013904223u;
+	
+	return s;
+}
+
+// ============================== uniform ===========================
+double CqRandom::uniform()
+{
+	return next() / 4294967295.0;
+}
+
+// EOF
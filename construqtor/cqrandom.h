@@ -0,0 +1,49 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef CQRANDOM_H
+#define CQRANDOM_H
+
+// Qt
+#include <QtGlobal>
+
+/**
+	Seedable random number generator used by all construqtor code instead of qrand().
+	Generated sequence does not depend on platform's rand() implementation, so sessions 
+	can be replayed with the same random events when generator is seeded with recorded seed.
+	Each thread has its own generator state, so simulations run in parallel do not 
+	disturb each other's sequences.
+	@author Maciek Gajewski <maciej.gajewski0@gmail.com>
+*/
+class CqRandom
+{
+public:
+	
+	static void setSeed( quint32 seed );	///< Seeds generator
+	static quint32 next();					///< Returns next random number from whole 32-bit range
+	static double uniform();				///< Returns next random number from range [0.0, 1.0]
+
+private:
+
+	static quint32& state();				///< Returns calling thread's generator state
+};
+
+#endif // CQRANDOM_H
+
+// EOF
@@ -0,0 +1,124 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// Qt
+#include <QFile>
+#include <QDataStream>
+
+// local
+#include "cqrecording.h"
+#include "gexception.h"
+
+// constants
+static const quint32 RECORDING_MAGIC	= 0x43515232;	// "CQR2" - file format marker
+static const quint32 RECORDING_MAGIC_1	= 0x43515231;	// "CQR1" - recorded with sequential constraint order only
+
+// ========================== constructor ===========================
+CqRecording::CqRecording()
+{
+	clear();
+}
+
+// ========================== destructor ============================
+CqRecording::~CqRecording()
+{
+	// nope
+}
+
+// ============================== clear =============================
+void CqRecording::clear()
+{
+	_initialState.clear();
+	_seed	= 0;
+	_length	= 0;
+	_constraintColoring	= true;
+	_inputs.clear();
+}
+
+// =========================== save to file =========================
+void CqRecording::saveToFile( const QString& path ) const
+{
+	QFile file( path );
+	if ( ! file.open( QIODevice::WriteOnly ) )
+	{
+		throw GSysError( QString("Error opening file %1: %2").arg( path ).arg( file.errorString() ) );
+	}
+	
+	QDataStream stream( &file );
+	stream << RECORDING_MAGIC << _initialState << _seed << qint32( _length ) << _constraintColoring;
+	
+	stream << qint32( _inputs.size() );
+	foreach( const Input& input, _inputs )
+	{
+		stream << qint32( input.step ) << input.controllerOwner << input.value;
+	}
+	
+	if ( stream.status() != QDataStream::Ok )
+	{
+		throw GSysError( QString("Error writing to file %1: %2").arg( path ).arg( file.errorString() ) );
+	}
+}
+
+// ========================== load from file ========================
+void CqRecording::loadFromFile( const QString& path )
+{
+	clear();
+	
+	QFile file( path );
+	if ( ! file.open( QIODevice::ReadOnly ) )
+	{
+		throw GSysError( QString("Error opening file %1: %2").arg( path ).arg( file.errorString() ) );
+	}
+	
+	QDataStream stream( &file );
+	quint32 magic;
+	stream >> magic;
+	if ( magic == RECORDING_MAGIC_1 )
+	{
+		// solver has changed since, old recordings would not replay the same
+		throw GDatasetError( QString("File %1 was recorded by older version of construqtor and can't be replayed").arg( path ) );
+	}
+	if ( magic != RECORDING_MAGIC )
+	{
+		throw GDatasetError( QString("File %1 is not a construqtor recording").arg( path ) );
+	}
+	
+	qint32 length, inputs;
+	stream >> _initialState >> _seed >> length >> _constraintColoring >> inputs;
+	_length = length;
+	
+	for( int i = 0; i < inputs && stream.status() == QDataStream::Ok; i++ )
+	{
+		Input input;
+		qint32 step;
+		stream >> step >> input.controllerOwner >> input.value;
+		input.step = step;
+		
+		_inputs.append( input );
+	}
+	
+	if ( stream.status() != QDataStream::Ok )
+	{
+		clear();
+		throw GSysError( QString("Error reading from file %1").arg( path ) );
+	}
+}
+
+// EOF
@@ -0,0 +1,86 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef CQRECORDING_H
+#define CQRECORDING_H
+
+// Qt
+#include <QString>
+#include <QList>
+#include <QUuid>
+
+/**
+	Recorded simulation session: initial game state, random generator seed and all inputs
+	given to motor controllers, with index of simulation step at which they were applied.
+	Simulation stepping is deterministic, so replaying inputs on the initial state reproduces 
+	the session.
+	@author Maciek Gajewski <maciej.gajewski0@gmail.com>
+*/
+class CqRecording
+{
+public:
+	
+	/// Single recorded input
+	struct Input
+	{
+		int		step;			///< Step index, counted from start of recording
+		QUuid	controllerOwner;///< Id of item owning controller
+		double	value;			///< Desired value set on controller
+	};
+	
+	// construction / destruction
+	CqRecording();
+	~CqRecording();
+	
+	void clear();											///< Removes all data
+	
+	// properties
+	void setInitialState( const QString& state ) { _initialState = state; }
+	QString initialState() const { return _initialState; }	///< Saved game recording starts with
+	
+	void setSeed( quint32 seed ) { _seed = seed; }
+	quint32 seed() const { return _seed; }					///< Random generator seed
+	
+	void setLength( int steps ) { _length = steps; }
+	int length() const { return _length; }					///< Recorded steps
+	
+	void setConstraintColoring( bool coloring ) { _constraintColoring = coloring; }
+	bool constraintColoring() const { return _constraintColoring; }	///< Solver setting recording was made with
+	
+	void addInput( const Input& input ) { _inputs.append( input ); }
+	const QList<Input>& inputs() const { return _inputs; }	///< Inputs, ordered by step
+	
+	// i/o
+	void saveToFile( const QString& path ) const;
+	void loadFromFile( const QString& path );
+
+private:
+
+	// data
+	
+	QString			_initialState;		///< Initial game state, as saved game XML
+	quint32			_seed;				///< Random seed
+	int				_length;			///< Recording length [steps]
+	bool			_constraintColoring;///< Large islands were solved in colored batches
+	QList<Input>	_inputs;			///< Recorded inputs
+};
+
+#endif // CQRECORDING_H
+
+// EOF
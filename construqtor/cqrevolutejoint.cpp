@@ -18,6 +18,9 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+// Qt
+#include <QDataStream>
+
 // Box 2d
 #include "b2RevoluteJoint.h"
 
@@ -103,11 +106,11 @@ b2Joint* CqRevoluteJoint::createJoint(CqWorld* pWorld)
 // ======================== update pos to physical ================
 void CqRevoluteJoint::updatePosToPhysical()
 {
-	if ( b2joint() )
+	// use anchor published by world - joint may be simulated by worker thread right now
+	CqJointState state;
+	if ( jointState( &state ) )
 	{
-		b2RevoluteJoint* pJoint = (b2RevoluteJoint*)b2joint();
-		b2Vec2 pos = pJoint->GetAnchor1();
-		setWorldPos( QPointF(pos.x, pos.y) - _anchorPoint );
+		setWorldPos( QPointF(state.anchor.x, state.anchor.y) - _anchorPoint );
 	}
 }
 
@@ -206,5 +209,44 @@ void CqRevoluteJoint::load( const CqElement& element )
 	_initialAngle = element.readDouble( TAG_JOINT_ANGLE );
 }
 
+// ============================== store dynamic state ======================
+void CqRevoluteJoint::storeDynamicState( QDataStream& stream ) const
+{
+	CqJoint::storeDynamicState( stream );
+	
+	const b2RevoluteJoint* pJoint = (const b2RevoluteJoint*)b2joint();
+	stream << bool( pJoint != NULL );
+	if ( pJoint )
+	{
+		// accumulated impulses are used for warm-starting
+		stream << pJoint->m_ptpImpulse.x << pJoint->m_ptpImpulse.y;
+		stream << pJoint->m_motorImpulse << pJoint->m_limitImpulse << pJoint->m_limitPositionImpulse;
+	}
+}
+
+// ============================= restore dynamic state =====================
+void CqRevoluteJoint::restoreDynamicState( QDataStream& stream )
+{
+	CqJoint::restoreDynamicState( stream );
+	
+	bool hasJoint;
+	stream >> hasJoint;
+	if ( hasJoint )
+	{
+		float32 impulses[5];
+		stream >> impulses[0] >> impulses[1] >> impulses[2] >> impulses[3] >> impulses[4];
+		
+		b2RevoluteJoint* pJoint = (b2RevoluteJoint*)b2joint();
+		if ( pJoint )
+		{
+			pJoint->m_ptpImpulse.x = impulses[0];
+			pJoint->m_ptpImpulse.y = impulses[1];
+			pJoint->m_motorImpulse = impulses[2];
+			pJoint->m_limitImpulse = impulses[3];
+			pJoint->m_limitPositionImpulse = impulses[4];
+		}
+	}
+}
+
 // EOF
 
@@ -64,6 +64,8 @@ public:
 	// storing / reading
 	virtual void store( CqElement& element ) const;		///< stores item state 
 	virtual void load( const CqElement& element );		///< restores item state 
+	virtual void storeDynamicState( QDataStream& stream ) const;	///< stores accumulated impulses
+	virtual void restoreDynamicState( QDataStream& stream );		///< restores accumulated impulses
 
 protected:
 
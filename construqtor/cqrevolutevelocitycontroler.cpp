@@ -56,10 +56,11 @@ void CqRevoluteVelocityControler::init()
 // ================================ get current force ===========
 double CqRevoluteVelocityControler::getCurrentForce() const
 {
-	if ( _pJoint && _pJoint->b2joint() )
+	// read state published by world - joint may be simulated by worker thread right now
+	CqJointState state;
+	if ( _pJoint && _pJoint->jointState( &state ) )
 	{
-		b2RevoluteJoint* pRj = (b2RevoluteJoint*)_pJoint->b2joint();
-		double torque =  pRj->GetMotorTorque( _pJoint->simulation()->invTimeStep() );
+		double torque = state.motorImpulse * _pJoint->simulation()->invTimeStep();
 		return torque;
 	}
 
@@ -69,10 +70,10 @@ double CqRevoluteVelocityControler::getCurrentForce() const
 // ================================= get current value ===========
 double CqRevoluteVelocityControler::getCurrentValue() const
 {
-	if ( _pJoint && _pJoint->b2joint() )
+	CqJointState state;
+	if ( _pJoint && _pJoint->jointState( &state ) )
 	{
-		b2RevoluteJoint* pRj = (b2RevoluteJoint*)_pJoint->b2joint();
-		return pRj->GetJointSpeed();
+		return state.speed;
 	}
 
 	return 0.0;
@@ -91,6 +92,8 @@ void CqRevoluteVelocityControler::setDesiredValue(double value)
 	
 	if ( _pJoint && _pJoint->b2joint() )
 	{
+		QMutexLocker locker( _pJoint->world()->mutex() );
+		
 		if ( value >= _valueMin && value <= _valueMax )
 		{
 			b2RevoluteJoint* pRj = (b2RevoluteJoint*)_pJoint->b2joint();
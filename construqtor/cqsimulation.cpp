@@ -18,21 +18,37 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+// Qt
+#include <QThread>
+#include <QDataStream>
+#include <QMap>
+
 // box2d
 #include "b2World.h"
 
 // local
 #include "cqsimulation.h"
+#include "cqworldthread.h"
+#include "cqtaskpool.h"
 #include "cqnail.h"
 #include "cqphysicalbox.h" 
 #include "cqmotorcontroller.h"
 #include "cqgroundbody.h"
 #include "cqdocument.h"
+#include "cqfragilerevolutejoint.h"
+#include "cqrecording.h"
 
 
 // constants
-static const int SIMULATION_INTERVAL	= 100;	// [ms]
+static const int FRAME_INTERVAL			= 16;	// [ms] scene update interval, close to display refresh rate
 static const double B2D_SPS				= 60.0;	// Box2D simulation steps per second
+static const int B2D_ITERATIONS			= 10;	// Box2D solver iteration budget, islands stop when converged
+static const int MAX_STEPS_PER_FRAME	= 10;	// Max steps to catch up with real time in one frame
+static const int RUN_STEPS_PER_UPDATE	= 6;	// Box2D steps between scene updates and settle checks in run()
+
+const double CqSimulation::SETTLED_ENERGY = 1.0;
+
+static const quint32 SNAPSHOT_MAGIC	= 0x43515332;	// "CQS2" - snapshot format marker
 
 // XML tags
 static const char* ROOT_ELEMENT		= "simulaton";
@@ -41,6 +57,7 @@ static const char* TAG_GND_ELEMENT	= "ground";				///< Ground elements
 static const char* TAG_GRAVITY		= "gravity";
 static const char* TAG_EDITABLE_AREA	= "editablearea";
 static const char* TAG_TARGET_AREA		= "targetarea";
+static const char* TAG_SNAPSHOT			= "snapshot";		///< Items stored in snapshot
 
 
 // ===================== constructor =================
@@ -55,6 +72,13 @@ CqSimulation::CqSimulation(QObject* parent): QObject(parent)
 CqSimulation::~CqSimulation()
 {
 	clear(); // destroty items in civilized way
+	delete _pWorker;
+	
+	if ( _pPhysicalWorld )
+	{
+		_pPhysicalWorld->SetTaskDispatcher( NULL );
+	}
+	delete _pTaskPool;
 }
 
 // ======================== start ==================
@@ -62,19 +86,21 @@ void CqSimulation::start()
 {
 	assurePhysicalObjectsCreated();
 	
-	// tell everyone simulation will start
-	QList< QGraphicsItem* > items = _scene.items();
+	// publish poses changed by editor
+	_pPhysicalWorld->publishPoses();
+	_pPhysicalWorld->swapPoses();
 	
-	foreach( QGraphicsItem* pItem, items )
+	// tell everyone simulation will start
+	foreach( CqItem* pItem, _items )
 	{
-		CqItem* pBody = dynamic_cast<CqItem*>( pItem );
-		
-		if ( pBody )
-		{
-			pBody->simulationStarted();
-		}
+		pItem->simulationStarted();
 	}
-	_simulationTimer.start( SIMULATION_INTERVAL );
+	
+	// reset real-time scheduler
+	_accumulator = 0.0;
+	_backgroundInterpolation = 1.0;
+	_frameClock.start();
+	_simulationTimer.start( FRAME_INTERVAL );
 	
 	emit simulationStarted();
 }
@@ -82,19 +108,21 @@ void CqSimulation::start()
 // ======================== stop ==================
 void CqSimulation::stop()
 {
+	bool wasRunning = isRunning();
 	_simulationTimer.stop();
-		
-	// tell everyone simulation has stopped
-	QList< QGraphicsItem* > items = _scene.items();
 	
-	foreach( QGraphicsItem* pItem, items )
+	// collect last batch calculated in background, show final - not interpolated - state
+	if ( wasRunning )
 	{
-		CqItem* pBody = dynamic_cast<CqItem*>( pItem );
+		finishBackgroundSteps();
+		_pPhysicalWorld->setInterpolation( 1.0 );
+		updateItems();
+	}
 		
-		if ( pBody )
-		{
-			pBody->simulationStopped();
-		}
+	// tell everyone simulation has stopped
+	foreach( CqItem* pItem, _items )
+	{
+		pItem->simulationStopped();
 	}
 
 	emit simulationPaused();
@@ -112,43 +140,326 @@ double CqSimulation::invTimeStep() const
 	return B2D_SPS;
 }
 
+// ========================== joint broken ================
+void CqSimulation::jointBroken( CqFragileRevoluteJoint* pJoint )
+{
+	Q_ASSERT( pJoint );
+	
+	// joint reports each step until it is broken
+	if ( ! _overheatedJoints.contains( pJoint ) )
+	{
+		_overheatedJoints.append( pJoint );
+		_brokenJoints++;
+	}
+}
+
+// ========================== register item ===============
+/// Called by item when it's assigned to this simulation. Item type is checked once here, so
+/// per-step code doesn't have to scan the scene.
+void CqSimulation::registerItem( CqItem* pItem )
+{
+	Q_ASSERT( pItem );
+	Q_ASSERT( ! _pWorker || ! _pWorker->isBusy() );
+	
+	if ( _items.contains( pItem ) )
+	{
+		return;
+	}
+	
+	_items.append( pItem );
+	
+	if ( ! pItem->physicalParent() )
+	{
+		_topLevelItems.append( pItem );
+	}
+	if ( dynamic_cast<CqPhysicalBody*>( pItem ) )
+	{
+		_bodies.append( pItem );
+	}
+	if ( dynamic_cast<CqJoint*>( pItem ) )
+	{
+		_joints.append( pItem );
+	}
+}
+
+// ========================= unregister item ==============
+/// Called by item when it's destroyed or moved to other simulation.
+void CqSimulation::unregisterItem( CqItem* pItem )
+{
+	Q_ASSERT( pItem );
+	Q_ASSERT( ! _pWorker || ! _pWorker->isBusy() );
+	
+	// NOTE: may be called from CqItem destructor, so only pointer value may be used here
+	_items.removeAll( pItem );
+	_topLevelItems.removeAll( pItem );
+	_bodies.removeAll( pItem );
+	_joints.removeAll( pItem );
+	unsubscribeCalculationStep( pItem );
+}
+
+// ======================= item parent changed ============
+void CqSimulation::itemParentChanged( CqItem* pItem )
+{
+	Q_ASSERT( pItem );
+	
+	if ( pItem->physicalParent() )
+	{
+		_topLevelItems.removeAll( pItem );
+	}
+	else if ( _items.contains( pItem ) && ! _topLevelItems.contains( pItem ) )
+	{
+		_topLevelItems.append( pItem );
+	}
+}
+
+// ================== subscribe calculation step ==========
+void CqSimulation::subscribeCalculationStep( CqItem* pItem, int priority )
+{
+	Q_ASSERT( pItem );
+	Q_ASSERT( ! _pWorker || ! _pWorker->isBusy() );
+	
+	unsubscribeCalculationStep( pItem );
+	
+	// insert after subscribers of the same priority
+	int index = 0;
+	while ( index < _subscriptions.size() && _subscriptions[ index ].priority <= priority )
+	{
+		index++;
+	}
+	
+	CalculationSubscription subscription;
+	subscription.pItem		= pItem;
+	subscription.priority	= priority;
+	_subscriptions.insert( index, subscription );
+	_calculationItems.insert( index, pItem );
+}
+
+// ================= unsubscribe calculation step =========
+void CqSimulation::unsubscribeCalculationStep( CqItem* pItem )
+{
+	Q_ASSERT( ! _pWorker || ! _pWorker->isBusy() );
+	
+	int index = _calculationItems.indexOf( pItem );
+	if ( index >= 0 )
+	{
+		_subscriptions.remove( index );
+		_calculationItems.remove( index );
+	}
+}
+
+// ========================= set threaded ================
+void CqSimulation::setThreaded( bool threaded )
+{
+	if ( threaded && ! _pWorker )
+	{
+		_pWorker = new CqWorldThread( this );
+		_pWorker->start();
+	}
+	else if ( ! threaded && _pWorker )
+	{
+		finishBackgroundSteps();
+		delete _pWorker;
+		_pWorker = NULL;
+	}
+}
+
+// ========================= set solver threads ================
+void CqSimulation::setSolverThreads( int threads )
+{
+	Q_ASSERT( threads > 0 );
+	if ( threads == solverThreads() )
+	{
+		return;
+	}
+	
+	// make sure worker is not stepping
+	finishBackgroundSteps();
+	
+	if ( _pPhysicalWorld )
+	{
+		_pPhysicalWorld->SetTaskDispatcher( NULL );
+	}
+	delete _pTaskPool;
+	_pTaskPool = NULL;
+	
+	if ( threads > 1 )
+	{
+		_pTaskPool = new CqTaskPool( threads );
+		if ( _pPhysicalWorld )
+		{
+			_pPhysicalWorld->SetTaskDispatcher( _pTaskPool );
+		}
+	}
+}
+
+// ========================= solver threads ================
+int CqSimulation::solverThreads() const
+{
+	return _pTaskPool ? _pTaskPool->GetThreadCount() : 1;
+}
+
+// ========================= set constraint coloring ================
+void CqSimulation::setConstraintColoring( bool coloring )
+{
+	// make sure worker is not stepping
+	finishBackgroundSteps();
+	
+	_constraintColoring = coloring;
+	if ( _pPhysicalWorld )
+	{
+		_pPhysicalWorld->m_enableConstraintColoring = coloring;
+	}
+}
+
 // =========================== timer timeout =============
+/// Real-time scheduler. Accumulates real time elapsed since last frame and consumes it 
+/// in fixed box2d steps. Remainder is used to interpolate between two last physical states.
 void CqSimulation::simulationTimerTimeout()
+{
+	_accumulator += _frameClock.restart() / 1000.0;
+	
+	int steps = int( _accumulator * B2D_SPS );
+	if ( steps > MAX_STEPS_PER_FRAME )
+	{
+		// we can't keep up with real time - drop the time instead of catching up forever
+		steps = MAX_STEPS_PER_FRAME;
+		_accumulator = steps / B2D_SPS;
+	}
+	_accumulator -= steps / B2D_SPS;
+	
+	double interpolation = qBound( 0.0, _accumulator * B2D_SPS, 1.0 );
+	
+	if ( _pWorker )
+	{
+		stepBackground( steps, interpolation );
+	}
+	else
+	{
+		stepForeground( steps, interpolation );
+	}
+}
+
+// ========================== step foreground =============
+void CqSimulation::stepForeground( int steps, double interpolation )
 {
 	Q_ASSERT( _pPhysicalWorld );
 	
-	// physical world simulation step
-	int iterations = B2D_SPS * SIMULATION_INTERVAL / 1000.0;
-	for( int i = 0; i < iterations; i++)
+	calculate( steps );
+	_pPhysicalWorld->swapPoses();
+	_pPhysicalWorld->setInterpolation( interpolation );
+	
+	updateItems();
+}
+
+// ========================== step background =============
+/// Collects previous batch and starts next one on worker thread. Items are updated to 
+/// poses from previous batch while worker calculates the next one, so they are displayed
+/// one frame later than in foreground mode.
+void CqSimulation::stepBackground( int steps, double interpolation )
+{
+	Q_ASSERT( _pPhysicalWorld );
+	Q_ASSERT( _pWorker );
+	
+	// steps left out of previous batch are carried into this one, so simulated time keeps up
+	steps += finishBackgroundSteps();
+	_pPhysicalWorld->setInterpolation( _backgroundInterpolation ); // interpolation of displayed batch
+	
+	_pWorker->startSteps( steps );
+	_backgroundInterpolation = interpolation;
+	
+	updateItems();
+}
+
+// ==================== finish background steps ===========
+/// Returns number of requested steps that worker did not perform, because a joint overheated.
+/// Only real-time stepping carries them on, other callers stop or reset simulation anyway.
+int CqSimulation::finishBackgroundSteps()
+{
+	int leftSteps = 0;
+	if ( _pWorker )
 	{
-		_pPhysicalWorld->Step( 1.0/B2D_SPS, 10 ); // NOTE 10: this is experimental param value
+		leftSteps = _pWorker->waitForSteps();
 		
-		// update all items
-		QList< QGraphicsItem* > items = _scene.items();
-		foreach( QGraphicsItem* pItem, items )
-		{
-			CqItem* pCqItem = dynamic_cast<CqItem*>( pItem );
-			
-			if ( pCqItem && pCqItem->physicalParent() == NULL ) // only top-level items
-			{
-					pCqItem->calculationStep();
-			}
-		}
-		emit calculationStep();
+		// world is idle now, so items may be created / destroyed
+		_pPhysicalWorld->swapPoses();
+		breakOverheatedJoints();
 	}
 	
-	// update all items
-	QList< QGraphicsItem* > items = _scene.items(); // NOTE uses sepearte list than loop above, as the loop aboce may delete/add some items
-	foreach( QGraphicsItem* pItem, items )
+	return leftSteps;
+}
+
+// ============================ calculate =================
+/// Performs box2d steps and calls calculation step on items. In threaded mode called from worker
+/// thread, so no items may be created or destroyed here - see breakOverheatedJoints().
+/// Worker ends batch early after a step in which a joint overheated, so the joint breaks before
+/// next step. Returns number of steps performed, caller is responsible for the rest.
+int CqSimulation::calculate( int steps )
+{
+	Q_ASSERT( _pPhysicalWorld );
+	
+	QMutexLocker locker( _pPhysicalWorld->mutex() );
+	
+	int i = 0;
+	while( i < steps )
 	{
-		CqItem* pCqItem = dynamic_cast<CqItem*>( pItem );
+		// remember state before last step for interpolation
+		if ( i == steps - 1 )
+		{
+			_pPhysicalWorld->publishPreviousPoses();
+		}
+		
+		applyInputs();
 		
-		if ( pCqItem && pCqItem->physicalParent() == NULL ) // only top-level items
+		_pPhysicalWorld->Step( 1.0/B2D_SPS, B2D_ITERATIONS );
+		_simulationTime += 1.0/B2D_SPS;
+		_stepCount++;
+		i++;
+		
+		foreach( CqItem* pItem, _calculationItems )
+		{
+			pItem->calculationStep();
+		}
+		emit calculationStep();
+		
+		// on our own thread joints can be broken right away
+		if ( QThread::currentThread() == thread() )
+		{
+			breakOverheatedJoints();
+		}
+		// worker ends batch, so joint is broken before next step, as in foreground mode
+		else if ( ! _overheatedJoints.isEmpty() )
 		{
-			pCqItem->simulationStep();
+			break;
 		}
 	}
 	
+	if ( i > 0 )
+	{
+		_pPhysicalWorld->publishPoses();
+	}
+	
+	return i;
+}
+
+// ====================== break overheated joints =========
+void CqSimulation::breakOverheatedJoints()
+{
+	// NOTE breaking deletes joint and adds new items
+	while ( ! _overheatedJoints.isEmpty() )
+	{
+		CqFragileRevoluteJoint* pJoint = _overheatedJoints.takeFirst();
+		pJoint->breakUnderLoad();
+	}
+}
+
+// ============================ update items ==============
+void CqSimulation::updateItems()
+{
+	foreach( CqItem* pItem, _topLevelItems )
+	{
+		pItem->simulationStep();
+	}
+	
 	emit simulationStep();
 }
 
@@ -159,7 +470,17 @@ void CqSimulation::init()
 	_gravity	= QPointF( 0.0, -10.0 );
 	_pEditableAreaItem	= NULL;
 	_pTargetAreaItem	= NULL;
-
+	_simulationTime		= 0.0;
+	_stepCount			= 0;
+	_brokenJoints		= 0;
+	_pWorker			= NULL;
+	_pTaskPool			= NULL;
+	_constraintColoring	= true;
+	_pRecording			= NULL;
+	_pReplay			= NULL;
+	_accumulator		= 0.0;
+	_backgroundInterpolation	= 1.0;
+	_broadPhase			= e_sweepAndPruneBroadPhase;
 	
 	createWorld();
 	initScene();
@@ -178,7 +499,12 @@ void CqSimulation::createWorld()
 	b2Vec2 gravity( _gravity.x(), _gravity.y() );
 	
 	// create world
-	_pPhysicalWorld = new CqWorld( worldAABB, gravity, true /* do sleep*/, this );
+	_pPhysicalWorld = new CqWorld( worldAABB, gravity, true /* do sleep*/, _broadPhase, this );
+	if ( _pTaskPool )
+	{
+		_pPhysicalWorld->SetTaskDispatcher( _pTaskPool );
+	}
+	_pPhysicalWorld->m_enableConstraintColoring = _constraintColoring;
 	
 	_scene.setSceneRect( _worldRect );
 	
@@ -249,31 +575,36 @@ void CqSimulation::assurePhysicalObjectsCreated()
 {
 	Q_ASSERT( _pPhysicalWorld );
 	
-	// TODO suboptimal - maintain separate list of bodyless-objects
-	QList< QGraphicsItem* > items = _scene.items();
+	// batch creation, so collision proxies are inserted in one pass, contacts
+	// are found once and joint collision filtering is applied once per body
+	{
+		QMutexLocker locker( _pPhysicalWorld->mutex() );
+		_pPhysicalWorld->BeginBodyBatch();
+		_pPhysicalWorld->BeginJointBatch();
+	}
 	
 	// first - create bodies
-	foreach( QGraphicsItem* pItem, items )
+	foreach( CqItem* pItem, _bodies )
 	{
-		CqPhysicalBody* pBody = dynamic_cast<CqPhysicalBody*>( pItem );
+		CqPhysicalBody* pBody = static_cast<CqPhysicalBody*>( pItem );
 		
-		if ( pBody )
-		{
-			pBody->setWorld( _pPhysicalWorld );
-			pBody->assureBodyCreated();
-		}
+		pBody->setWorld( _pPhysicalWorld );
+		pBody->assureBodyCreated();
 	}
 	
 	// second - create joints
-	foreach( QGraphicsItem* pItem, items )
+	foreach( CqItem* pItem, _joints )
 	{
-		CqJoint* pJoint = dynamic_cast<CqJoint*>( pItem );
+		CqJoint* pJoint = static_cast<CqJoint*>( pItem );
 		
-		if ( pJoint )
-		{
-			pJoint->setWorld( _pPhysicalWorld );
-			pJoint->assureJointCreated();
-		}
+		pJoint->setWorld( _pPhysicalWorld );
+		pJoint->assureJointCreated();
+	}
+	
+	{
+		QMutexLocker locker( _pPhysicalWorld->mutex() );
+		_pPhysicalWorld->EndJointBatch();
+		_pPhysicalWorld->EndBodyBatch();
 	}
 }
 
@@ -357,7 +688,147 @@ bool CqSimulation::canAddHere( const CqItem* /*pItem*/, const QPointF& pos ) con
 // ============================== cotroller destroyed ==================
 void CqSimulation::controllerDestroyed( QObject* p )
 {
-	_controllers.removeAll( qobject_cast<CqMotorController*>(p) );
+	// NOTE: object is being destroyed, only pointer value can be used
+	CqMotorController* pController = static_cast<CqMotorController*>( p );
+	_controllers.removeAll( pController );
+	
+	QMutexLocker locker( &_inputMutex );
+	for( int i = _pendingInputs.size() - 1; i >= 0; i-- )
+	{
+		if ( _pendingInputs[i].pController == pController )
+		{
+			_pendingInputs.removeAt( i );
+		}
+	}
+}
+
+// ============================ set desired value =======================
+void CqSimulation::setDesiredValue( CqMotorController* pController, double value )
+{
+	Q_ASSERT( pController );
+	
+	{
+		QMutexLocker locker( &_inputMutex );
+		
+		ControllerInput input;
+		input.pController	= pController;
+		input.value			= value;
+		_pendingInputs.append( input );
+	}
+	
+	// no steps are calculated - apply now
+	if ( ! isRunning() )
+	{
+		applyInputs();
+	}
+}
+
+// ============================== apply inputs ==========================
+/// Called before each step. In threaded mode called from worker thread.
+void CqSimulation::applyInputs()
+{
+	QList<ControllerInput> inputs;
+	{
+		QMutexLocker locker( &_inputMutex );
+		inputs = _pendingInputs;
+		_pendingInputs.clear();
+	}
+	
+	if ( _pReplay )
+	{
+		// user input is ignored during replay
+		const QList<CqRecording::Input>& recorded = _pReplay->inputs();
+		while ( _replayPosition < recorded.size() && recorded[ _replayPosition ].step <= _stepCount - _replayStart )
+		{
+			const CqRecording::Input& input = recorded[ _replayPosition++ ];
+			
+			CqMotorController* pController = controllerByOwner( input.controllerOwner );
+			if ( pController )
+			{
+				pController->setDesiredValue( input.value );
+			}
+			else
+			{
+				qWarning("Replayed input for unknown controller %s", qPrintable( input.controllerOwner.toString() ) );
+			}
+		}
+		
+		return;
+	}
+	
+	foreach( const ControllerInput& input, inputs )
+	{
+		input.pController->setDesiredValue( input.value );
+		
+		if ( _pRecording && input.pController->owner() )
+		{
+			CqRecording::Input recorded;
+			recorded.step				= _stepCount - _recordingStart;
+			recorded.controllerOwner	= input.pController->owner()->id();
+			recorded.value				= input.value;
+			_pRecording->addInput( recorded );
+		}
+	}
+}
+
+// ========================== controller by owner =======================
+CqMotorController* CqSimulation::controllerByOwner( const QUuid& ownerId ) const
+{
+	foreach( CqMotorController* pController, _controllers )
+	{
+		if ( pController->owner() && pController->owner()->id() == ownerId )
+		{
+			return pController;
+		}
+	}
+	
+	return NULL;
+}
+
+// ============================ start recording =========================
+void CqSimulation::startRecording( CqRecording* pRecording )
+{
+	Q_ASSERT( pRecording );
+	
+	finishBackgroundSteps();
+	
+	_pRecording		= pRecording;
+	_recordingStart	= _stepCount;
+}
+
+// ============================= stop recording =========================
+void CqSimulation::stopRecording()
+{
+	if ( _pRecording )
+	{
+		finishBackgroundSteps();
+		
+		_pRecording->setLength( _stepCount - _recordingStart );
+		_pRecording = NULL;
+	}
+}
+
+// ============================= start replay ===========================
+void CqSimulation::startReplay( const CqRecording* pRecording )
+{
+	Q_ASSERT( pRecording );
+	
+	finishBackgroundSteps();
+	
+	_pReplay		= pRecording;
+	_replayStart	= _stepCount;
+	_replayPosition	= 0;
+	
+	// inputs given before first step
+	applyInputs();
+}
+
+// ============================== stop replay ===========================
+void CqSimulation::stopReplay()
+{
+	finishBackgroundSteps();
+	
+	_pReplay = NULL;
 }
 
 // =============================== add controller ========================
@@ -412,6 +883,213 @@ void CqSimulation::saveToXml( const QString& fileName ) const
 	doc.saveToFile( fileName );
 }
 
+// ============================= top level item ====================
+/// Returns item's physical ancestor which has no physical parent
+static const CqItem* topLevelItem( const CqItem* pItem )
+{
+	while ( pItem->physicalParent() )
+	{
+		pItem = pItem->physicalParent();
+	}
+	
+	return pItem;
+}
+
+// ============================= take snapshot =====================
+QByteArray CqSimulation::takeSnapshot() const
+{
+	Q_ASSERT( _pPhysicalWorld );
+	
+	QByteArray snapshot;
+	QDataStream stream( &snapshot, QIODevice::WriteOnly );
+	
+	// worker may be modyfying box2d objects
+	QMutexLocker locker( _pPhysicalWorld->mutex() );
+	
+	// structure of the simulation - top-level items, to recreate items destroyed later
+	CqDocument doc;
+	CqElement element = doc.createElement();
+	foreach( CqItem* pItem, _topLevelItems )
+	{
+		element.appendItem( pItem );
+	}
+	doc.appenElement( TAG_SNAPSHOT, element );
+	
+	stream << SNAPSHOT_MAGIC << doc.saveToString();
+	
+	// items, in order of dynamic state
+	stream << quint32( _items.size() );
+	foreach( CqItem* pItem, _items )
+	{
+		stream << pItem->id() << topLevelItem( pItem )->id();
+	}
+	
+	stream << _simulationTime << qint32( _stepCount ) << qint32( _brokenJoints );
+	
+	// controllers first, setting desired value may wake bodies up
+	stream << quint32( _controllers.size() );
+	foreach( CqMotorController* pController, _controllers )
+	{
+		stream << ( pController->owner() ? pController->owner()->id() : QUuid() );
+		stream << pController->getDesiredValue();
+	}
+	
+	foreach( CqItem* pItem, _items )
+	{
+		pItem->storeDynamicState( stream );
+	}
+	
+	return snapshot;
+}
+
+// ============================ restore snapshot ====================
+bool CqSimulation::restoreSnapshot( const QByteArray& snapshot )
+{
+	Q_ASSERT( _pPhysicalWorld );
+	Q_ASSERT( ! isRunning() );
+	
+	// breaking joints changes items
+	finishBackgroundSteps();
+	
+	QDataStream stream( snapshot );
+	
+	quint32 magic;
+	stream >> magic;
+	if ( magic != SNAPSHOT_MAGIC )
+	{
+		return false;
+	}
+	
+	QString structure;
+	quint32 itemCount;
+	stream >> structure >> itemCount;
+	
+	QList< QUuid > ids;
+	QList< QUuid > topLevelIds;
+	QMap< QUuid, CqItem* > items;
+	foreach( CqItem* pItem, _items )
+	{
+		items.insert( pItem->id(), pItem );
+	}
+	
+	// destroyed top-level items are recreated, items destroyed inside existing ones can not be
+	bool recreate = false;
+	for( quint32 i = 0; i < itemCount; i++ )
+	{
+		QUuid id, topLevelId;
+		stream >> id >> topLevelId;
+		ids.append( id );
+		if ( ! topLevelIds.contains( topLevelId ) )
+		{
+			topLevelIds.append( topLevelId );
+		}
+		
+		if ( ! items.contains( id ) )
+		{
+			if ( items.contains( topLevelId ) )
+			{
+				return false;
+			}
+			recreate = true;
+		}
+	}
+	
+	QMutexLocker locker( _pPhysicalWorld->mutex() );
+	
+	// remove items created after snapshot was taken (e.g. remains of broken joints)
+	QList< CqItem* > topLevelItems = _topLevelItems;
+	foreach( CqItem* pItem, topLevelItems )
+	{
+		if ( ! topLevelIds.contains( pItem->id() ) )
+		{
+			delete pItem;
+		}
+	}
+	
+	// recreate destroyed items (e.g. broken joints) from stored structure, as game load does
+	if ( recreate )
+	{
+		CqDocument doc;
+		doc.setExistingItems( _items );
+		doc.loadFromString( structure );
+		
+		CqElement element = doc.readElement( TAG_SNAPSHOT );
+		forever
+		{
+			CqItem* pItem = element.readItem();
+			if ( ! pItem )
+			{
+				break;
+			}
+			
+			if ( ! _items.contains( pItem ) )
+			{
+				addItem( pItem );
+			}
+		}
+		
+		items.clear();
+		foreach( CqItem* pItem, _items )
+		{
+			items.insert( pItem->id(), pItem );
+		}
+	}
+	
+	qint32 stepCount, brokenJoints;
+	stream >> _simulationTime >> stepCount >> brokenJoints;
+	_stepCount		= stepCount;
+	_brokenJoints	= brokenJoints;
+	
+	quint32 controllerCount;
+	stream >> controllerCount;
+	for( quint32 i = 0; i < controllerCount; i++ )
+	{
+		QUuid ownerId;
+		double value;
+		stream >> ownerId >> value;
+		
+		CqMotorController* pController = controllerByOwner( ownerId );
+		if ( pController )
+		{
+			pController->setDesiredValue( value );
+		}
+	}
+	
+	// recreated items have no physical objects yet. They are created after existing bodies are
+	// moved to their snapshot poses, so joints are created at right places, and state is restored again
+	qint64 statePos = stream.device()->pos();
+	for( int pass = 0; pass < ( recreate ? 2 : 1 ); pass++ )
+	{
+		if ( pass > 0 )
+		{
+			assurePhysicalObjectsCreated();
+			stream.device()->seek( statePos );
+		}
+		
+		foreach( const QUuid& id, ids )
+		{
+			CqItem* pItem = items.value( id );
+			if ( ! pItem )
+			{
+				qWarning("Item %s from snapshot could not be recreated", qPrintable( id.toString() ) );
+				return false;
+			}
+			pItem->restoreDynamicState( stream );
+		}
+	}
+	
+	// contacts remember impulses from before restore, they would warm start the next step
+	_pPhysicalWorld->ResetContacts();
+	
+	// display restored state
+	_pPhysicalWorld->publishPoses();
+	_pPhysicalWorld->swapPoses();
+	_pPhysicalWorld->setInterpolation( 1.0 );
+	updateItems();
+	
+	return stream.status() == QDataStream::Ok;
+}
+
 // ================================ store ==============================
 void CqSimulation::store( CqElement& element ) const
 {
@@ -427,16 +1105,13 @@ void CqSimulation::store( CqElement& element ) const
 		element.appendItemPointer( TAG_GND_ELEMENT, pGround );
 	}
 	
+	// worker may be modyfying box2d objects
+	QMutexLocker locker( _pPhysicalWorld->mutex() );
+	
 	// all CqItem-derrived, top-level items
-	QList< QGraphicsItem* > items = _scene.items();
-	foreach( QGraphicsItem* pItem, items )
+	foreach( CqItem* pItem, _topLevelItems )
 	{
-		CqItem* pCqIem = dynamic_cast<CqItem*>( pItem );
-		
-		if ( pCqIem && ! pCqIem->physicalParent() )
-		{
-			element.appendItem( pCqIem );
-		}
+		element.appendItem( pItem );
 	}
 	
 }
@@ -487,6 +1162,20 @@ void CqSimulation::clear()
 {
 	// TODO why not use _scene.clear() ?
 	
+	// make sure worker does not touch anything
+	if ( _pWorker )
+	{
+		_pWorker->waitForSteps();
+	}
+	_subscriptions.clear();
+	_calculationItems.clear();
+	_overheatedJoints.clear();
+	
+	// items will unregister from empty registry
+	_items.clear();
+	_topLevelItems.clear();
+	_bodies.clear();
+	_joints.clear();
 	
 	_scene.clear();
 	
@@ -519,52 +1208,79 @@ void CqSimulation::clear()
 	// clear area items (was deleted above)
 	_pEditableAreaItem = NULL;
 	_pTargetAreaItem = NULL;
+	
+	// recorded / replayed inputs are for old world
+	if ( _pRecording )
+	{
+		_pRecording->setLength( _stepCount - _recordingStart );
+	}
+	_pRecording	= NULL;
+	_pReplay	= NULL;
+	_pendingInputs.clear();
+	
+	// reset counters
+	_simulationTime	= 0.0;
+	_stepCount		= 0;
+	_brokenJoints	= 0;
 }
 // =================================== run =========================
 /// Runs - synchronously and at full processor speed - specified simulation time.
-void CqSimulation::run( double timeSpan )
+int CqSimulation::run( double timeSpan )
+{
+	return runSteps( qRound( timeSpan * B2D_SPS ), -1.0 );
+}
+
+// ========================== run until settled ==========================
+int CqSimulation::runUntilSettled( double maxTimeSpan, double energyThreshold )
 {
-	int steps = timeSpan * invTimeStep();
+	Q_ASSERT( energyThreshold >= 0.0 );
 	
+	return runSteps( qRound( maxTimeSpan * B2D_SPS ), energyThreshold );
+}
+
+// ============================== run steps ==============================
+int CqSimulation::runSteps( int steps, double energyThreshold )
+{
 	// prepare
 	if ( ! _pPhysicalWorld )
 	{
 		createWorld();
 	}
 	
+	// run always in this thread
+	finishBackgroundSteps();
+	
 	assurePhysicalObjectsCreated();
+	_pPhysicalWorld->publishPoses();
+	_pPhysicalWorld->swapPoses();
 	
 	// tell everyone simulation will start
-	QList< QGraphicsItem* > items = _scene.items();
-	
-	foreach( QGraphicsItem* pItem, items )
+	foreach( CqItem* pItem, _items )
 	{
-		CqItem* pBody = dynamic_cast<CqItem*>( pItem );
-		
-		if ( pBody )
-		{
-			pBody->simulationStarted();
-		}
+		pItem->simulationStarted();
 	}
 	
 	// simualate
-	for( int i =0; i < steps; i++ )
+	int done = 0;
+	while( done < steps )
 	{
-		simulationTimerTimeout();
+		int batch = qMin( RUN_STEPS_PER_UPDATE, steps - done );
+		stepForeground( batch, 1.0 );
+		done += batch;
+		
+		if ( energyThreshold >= 0.0 && _pPhysicalWorld->kineticEnergy() <= energyThreshold )
+		{
+			break; // settled
+		}
 	}
 	
 	// tell everyone simulation has stopped
-	items = _scene.items();
-	foreach( QGraphicsItem* pItem, items )
+	foreach( CqItem* pItem, _items )
 	{
-		CqItem* pBody = dynamic_cast<CqItem*>( pItem );
-		
-		if ( pBody )
-		{
-			pBody->simulationStopped();
-		}
+		pItem->simulationStopped();
 	}
 	
+	return done;
 }
 
 // EOF
@@ -27,13 +27,20 @@
 #include <QObject>
 #include <QGraphicsScene>
 #include <QTimer>
+#include <QTime>
+#include <QVector>
+#include <QUuid>
 
 // box2d
 class b2World;
 
 // local
 class CqItem;
+class CqFragileRevoluteJoint;
 class CqMotorController;
+class CqWorldThread;
+class CqTaskPool;
+class CqRecording;
 #include "cqworld.h"
 
 /**
@@ -44,6 +51,16 @@ class CqSimulation : public QObject
 Q_OBJECT
 public:
 
+	/// Calculation step priorities. Subscribers with lower value are called first.
+	enum CalculationPriority
+	{
+		PriorityControl	= 0,		///< controllers - apply forces for next step
+		PriorityDefault	= 50,
+		PriorityStress	= 100		///< stress evaluation - reads results of step
+	};
+	
+	static const double SETTLED_ENERGY;	///< Default kinetic energy of settled world [J]
+
 	// constructoon / destruction
 	CqSimulation(QObject* parent = NULL);
 	~CqSimulation();
@@ -52,7 +69,24 @@ public:
 	void start();			///< starts simulation
 	void stop();			///< Stops simulation
 	bool isRunning() const;	///< Is simulation running?
-	void run( double timeSpan );	///< Runs synchronously simulation for specified time span [seconds]
+	/// Runs synchronously simulation for specified time span [seconds]. Returns number of box2d steps
+	int run( double timeSpan );
+	/// Runs synchronously until all bodies are asleep or their kinetic energy drops below threshold [J],
+	/// but no longer than maxTimeSpan [seconds]. Returns number of box2d steps performed.
+	int runUntilSettled( double maxTimeSpan, double energyThreshold = SETTLED_ENERGY );
+	
+	/// Enables threaded mode - box2d steps are calculated on worker thread, while GUI thread updates scene
+	void setThreaded( bool threaded );
+	bool isThreaded() const { return _pWorker != NULL; }
+	
+	/// Sets number of threads solving independent box2d islands in parallel, 1 solves on stepping
+	/// thread only. Results do not depend on number of threads.
+	void setSolverThreads( int threads );
+	int solverThreads() const;
+	/// Solves constraints of large islands (see b2_minColoredConstraints) in parallel batches.
+	/// On by default. Changes results, so recordings store it and replay applies it.
+	void setConstraintColoring( bool coloring );
+	bool constraintColoring() const { return _constraintColoring; }
 	
 	QGraphicsScene* scene() { return &_scene; };
 	const QGraphicsScene* scene() const { return &_scene; };
@@ -61,8 +95,7 @@ public:
 	void addGroundItem( CqItem* pItem );///< Adds ground item to simulation
 	QList<CqItem*> groundItems() const { return _groundItems; }
 	
-	// TODO
-	//QList<CqItem*> topLevelItems() const;	///< Return top-level cqitems
+	QList<CqItem*> topLevelItems() const { return _topLevelItems; }	///< Return top-level cqitems
 	
 	
 	// editor control
@@ -76,6 +109,20 @@ public:
 	
 	void addController( CqMotorController* pController );	///< adds controler ot controller list
 	
+	// user input
+	/// Sets controller's desired value on next step boundary. Use for all user input, so it
+	/// is applied at well defined step and can be recorded.
+	void setDesiredValue( CqMotorController* pController, double value );
+	
+	// recording / replay
+	void startRecording( CqRecording* pRecording );		///< Records user input into recording
+	void stopRecording();								///< Stores recording length, stops recording
+	bool isRecording() const { return _pRecording != NULL; }
+	/// Applies recorded inputs instead of user input. Simulation should be in recording's initial state.
+	void startReplay( const CqRecording* pRecording );
+	void stopReplay();
+	bool isReplaying() const { return _pReplay != NULL; }
+	
 	// properties
 	QRectF worldRect() const { return _worldRect; }
 	void setWorldRect( const QRectF& rect ) { _worldRect = rect; }
@@ -87,6 +134,25 @@ public:
 	void setEditableArea( const QRectF& rect ) { _editableArea = rect; updateAreaItems(); }
 	
 	double invTimeStep() const;						///< Returns time step [1/s]
+	double simulationTime() const { return _simulationTime; }	///< Simulated time since world creation [s]
+	int stepCount() const { return _stepCount; }				///< Box2D steps since world creation
+	int brokenJoints() const { return _brokenJoints; }		///< Number of joints broken since world creation
+	
+	/// Sets box2d broad-phase algorithm. Used by world created by next clear() or load().
+	void setBroadPhase( b2BroadPhaseType type ) { _broadPhase = type; }
+	b2BroadPhaseType broadPhase() const { return _broadPhase; }
+	
+	// info from items
+	/// Joint was broken by load. Joint will be broken outside of calculation step
+	void jointBroken( CqFragileRevoluteJoint* pJoint );
+	
+	void registerItem( CqItem* pItem );			///< Item was assigned to simulation
+	void unregisterItem( CqItem* pItem );		///< Item was destroyed or assigned to other simulation
+	void itemParentChanged( CqItem* pItem );	///< Item's physical parent has changed
+	
+	/// Item's calculationStep() will be called after each box2d step. Re-subscribing changes priority.
+	void subscribeCalculationStep( CqItem* pItem, int priority = PriorityDefault );
+	void unsubscribeCalculationStep( CqItem* pItem );	///< Item will no longer get calculationStep()
 	
 	// XML storing / reading
 	void loadFromXml( const QString& fileName );		///< loads from XML
@@ -97,6 +163,14 @@ public:
 	
 	void clear();										///< Clears simulation
 	
+	// dynamic state snapshot
+	/// Stores dynamic state of bodies, joints and controllers into compact binary snapshot
+	QByteArray takeSnapshot() const;
+	/// Restores snapshot in place. Items created since snapshot was taken are deleted, destroyed
+	/// top-level items (e.g. broken joints) are re-created from snapshot. Fails if item inside
+	/// existing item was destroyed. Simulation must be stopped.
+	bool restoreSnapshot( const QByteArray& snapshot );
+	
 	// areas
 	
 	bool isInEditableArea( const QPointF& point ) const { return _editableArea.contains( point ); }
@@ -108,7 +182,9 @@ signals:
 	void simulationPaused();
 	
 	void simulationStep();	///< Called each simulation update
-	void calculationStep();	///< Called each low-level calculation step. Use to apply forces, perform calculations etc
+	/// Called each low-level calculation step. Use to apply forces, perform calculations etc.
+	/// In threaded mode emitted from worker thread - use direct connection.
+	void calculationStep();
 	
 	void motorControllerCreated( CqMotorController* );
 
@@ -119,6 +195,8 @@ private slots:
 
 private:
 
+	friend class CqWorldThread;
+
 	// methods
 	
 	void init();
@@ -128,10 +206,46 @@ private:
 	void assurePhysicalObjectsCreated();
 	void adjustEditableAreasToGround();	///< adjust editable and result boxes to ground
 	void updateAreaItems();				///< up[dates are items to display current area shapes
+	
+	// stepping
+	/// Calculates steps and updates items
+	void stepForeground( int steps, double interpolation );
+	/// Collects last batch, starts next one on worker thread, updates items
+	void stepBackground( int steps, double interpolation );
+	/// Waits for worker and collects results. Returns steps of the batch that worker left out
+	int finishBackgroundSteps();
+	/// Performs box2d steps and calculation steps. May be called from worker. Returns steps performed
+	int calculate( int steps );
+	void breakOverheatedJoints();		///< Breaks joints reported by jointBroken()
+	void updateItems();					///< Updates items to published poses
+	void applyInputs();					///< Applies pending user inputs or replayed inputs
+	/// Finds controller by id of owning item
+	CqMotorController* controllerByOwner( const QUuid& ownerId ) const;
+	/// Synchronous run. Stops early when energy drops below threshold, if threshold is not negative
+	int runSteps( int steps, double energyThreshold );
+	
+	/// User input waiting for next step
+	struct ControllerInput
+	{
+		CqMotorController*	pController;
+		double				value;
+	};
+	
+	/// Calculation step subscription
+	struct CalculationSubscription
+	{
+		CqItem*	pItem;
+		int		priority;
+	};
+	
 	// data
 
 	CqWorld*		_pPhysicalWorld;		///< Physical world
-	QTimer			_simulationTimer;		///< Simulation timer
+	b2BroadPhaseType	_broadPhase;		///< Broad-phase used by new worlds
+	QTimer			_simulationTimer;		///< Simulation timer, fires each frame
+	QTime			_frameClock;			///< Measures real time between frames
+	double			_accumulator;			///< Real time not simulated yet [s]
+	double			_backgroundInterpolation;	///< Interpolation of batch calculated in background
 	QGraphicsScene	_scene;					///< Simulation scene
 	QList<CqMotorController*>	_controllers;	///< Set of motor controllers
 	QRectF			_worldRect;				///< world rectangle
@@ -143,6 +257,34 @@ private:
 	
 	QGraphicsRectItem*	_pEditableAreaItem;	///< Editable area item
 	QGraphicsRectItem*	_pTargetAreaItem;	///< Editable area item
+	
+	double			_simulationTime;		///< Simulated time [s]
+	int				_stepCount;				///< Box2D steps performed
+	int				_brokenJoints;			///< Broken joints counter
+	
+	CqWorldThread*	_pWorker;				///< Worker thread, NULL if not in threaded mode
+	CqTaskPool*		_pTaskPool;				///< Island solver threads, NULL if islands are solved serially
+	bool			_constraintColoring;	///< Constraints of large islands are solved in colored batches
+	
+	// item registry
+	QList<CqItem*>	_items;					///< All items assigned to simulation
+	QList<CqItem*>	_topLevelItems;			///< Items without physical parent
+	QList<CqItem*>	_bodies;				///< CqPhysicalBody items
+	QList<CqItem*>	_joints;				///< CqJoint items
+	
+	// calculation step subscribers
+	QVector<CalculationSubscription>	_subscriptions;		///< Subscriptions, sorted by priority
+	QVector<CqItem*>	_calculationItems;	///< Subscribed items in call order
+	QList<CqFragileRevoluteJoint*>	_overheatedJoints;	///< Joints broken during calculation step
+	
+	// input
+	QMutex					_inputMutex;		///< Guards pending inputs
+	QList<ControllerInput>	_pendingInputs;		///< Inputs to be applied on next step
+	CqRecording*			_pRecording;		///< Active recording, or NULL
+	int						_recordingStart;	///< Step at which recording started
+	const CqRecording*		_pReplay;			///< Replayed recording, or NULL
+	int						_replayStart;		///< Step at which replay started
+	int						_replayPosition;	///< Next replayed input
 };
 
 #endif // CQSIMULATION_H
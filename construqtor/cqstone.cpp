@@ -23,6 +23,7 @@
 // local
 #include "cqstone.h"
 #include "cqitemfactory.h"
+#include "cqrandom.h"
 
 CQ_ADD_TO_FACTORY( CqStone );
 
@@ -72,15 +73,15 @@ CqStone* CqStone::createRandomStone( double diameter )
 	double currentAngle = 0.0;
 	QPolygonF result;
 	// init ital distance
-	double distance = MIN_DISTANCE  + ( MAX_DISTANCE - MIN_DISTANCE ) * double(qrand()) / RAND_MAX;
+	double distance = MIN_DISTANCE  + ( MAX_DISTANCE - MIN_DISTANCE ) * CqRandom::uniform();
 	
 	while( currentAngle < M_PI * 2 )
 	{
 		result.append( QPointF( distance* cos( currentAngle ), distance * sin( currentAngle ) ) );
-		currentAngle += MIN_ANGLE_STEP + ( MAX_ANGLE_STEP - MIN_ANGLE_STEP )* double(qrand()) / RAND_MAX;
+		currentAngle += MIN_ANGLE_STEP + ( MAX_ANGLE_STEP - MIN_ANGLE_STEP )* CqRandom::uniform();
 		
 		// select next distance
-		distance += - MAX_DISTANCE_DELTA + 2 * MAX_DISTANCE_DELTA * double(qrand()) / RAND_MAX;
+		distance += - MAX_DISTANCE_DELTA + 2 * MAX_DISTANCE_DELTA * CqRandom::uniform();
 		
 		if ( distance > MAX_DISTANCE ) distance = MAX_DISTANCE;
 		if ( distance < MIN_DISTANCE ) distance = MIN_DISTANCE;
@@ -0,0 +1,167 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// Qt
+#include <QThread>
+
+// local
+#include "cqtaskpool.h"
+
+// ============================== pool thread =======================
+/// Worker thread, runs pool's work loop
+class CqTaskPoolThread : public QThread
+{
+public:
+	CqTaskPoolThread( CqTaskPool* pPool, int threadIndex )
+		: QThread( NULL ), _pPool( pPool ), _threadIndex( threadIndex ) {}
+
+protected:
+	virtual void run() { _pPool->work( _threadIndex ); }
+
+private:
+	CqTaskPool*	_pPool;
+	int			_threadIndex;
+};
+
+// ============================== constructor =======================
+CqTaskPool::CqTaskPool( int threads )
+{
+	Q_ASSERT( threads > 0 );
+	
+	_pTask		= NULL;
+	_count		= 0;
+	_busy		= 0;
+	_generation	= 0;
+	_finish		= false;
+	
+	// thread 0 is the one calling Run()
+	for( int i = 1; i < threads; i++ )
+	{
+		CqTaskPoolThread* pThread = new CqTaskPoolThread( this, i );
+		_threads.append( pThread );
+		pThread->start();
+	}
+}
+
+// ============================== destructor ========================
+CqTaskPool::~CqTaskPool()
+{
+	_mutex.lock();
+	_finish = true;
+	_taskStarted.wakeAll();
+	_mutex.unlock();
+	
+	foreach( CqTaskPoolThread* pThread, _threads )
+	{
+		pThread->wait();
+		delete pThread;
+	}
+}
+
+// ============================== get thread count ==================
+int32 CqTaskPool::GetThreadCount() const
+{
+	return _threads.size() + 1;
+}
+
+// ============================== run ===============================
+void CqTaskPool::Run( b2Task* pTask, int32 count )
+{
+	Q_ASSERT( pTask );
+	
+	if ( _threads.isEmpty() || count < 2 )
+	{
+		for( int i = 0; i < count; i++ )
+		{
+			pTask->Execute( i, 0 );
+		}
+		return;
+	}
+	
+	QMutexLocker locker( &_mutex );
+	
+	Q_ASSERT( _busy == 0 );
+	_pTask	= pTask;
+	_count	= count;
+	_next	= 0;
+	_busy	= _threads.size();
+	_generation++;
+	_taskStarted.wakeAll();
+	
+	// take part in work with mutex unlocked
+	locker.unlock();
+	execute( 0 );
+	locker.relock();
+	
+	while ( _busy > 0 )
+	{
+		_taskDone.wait( &_mutex );
+	}
+	_pTask = NULL;
+}
+
+// ============================== work ==============================
+void CqTaskPool::work( int threadIndex )
+{
+	QMutexLocker locker( &_mutex );
+	
+	int generation = 0;
+	forever
+	{
+		while ( _generation == generation && ! _finish )
+		{
+			_taskStarted.wait( &_mutex );
+		}
+		
+		if ( _finish )
+		{
+			break;
+		}
+		
+		generation = _generation;
+		locker.unlock();
+		
+		execute( threadIndex );
+		
+		locker.relock();
+		_busy--;
+		if ( _busy == 0 )
+		{
+			_taskDone.wakeAll();
+		}
+	}
+}
+
+// ============================== execute ===========================
+void CqTaskPool::execute( int threadIndex )
+{
+	forever
+	{
+		int index = _next.fetchAndAddOrdered( 1 );
+		if ( index >= _count )
+		{
+			break;
+		}
+		
+		_pTask->Execute( index, threadIndex );
+	}
+}
+
+// EOF
@@ -0,0 +1,79 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef CQTASKPOOL_H
+#define CQTASKPOOL_H
+
+// Qt
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+// box2d
+#include "b2WorldCallbacks.h"
+
+// local
+class CqTaskPoolThread;
+
+/**
+	Pool of worker threads running box2d tasks, used to solve independent islands in parallel.
+	Calling thread takes part in each run, so pool of N threads starts N-1 workers.
+	Indices are handed out one by one from shared counter, so threads finishing early
+	take remaining work. Only one task may run at time.
+	@author Maciek Gajewski <maciej.gajewski0@gmail.com>
+*/
+class CqTaskPool : public b2TaskDispatcher
+{
+public:
+
+	// construction / destruction
+	explicit CqTaskPool( int threads );
+	virtual ~CqTaskPool();
+	
+	// b2TaskDispatcher
+	virtual int32 GetThreadCount() const;
+	virtual void Run( b2Task* pTask, int32 count );
+
+private:
+
+	friend class CqTaskPoolThread;
+	
+	// methods
+	
+	void work( int threadIndex );		///< Worker thread loop
+	void execute( int threadIndex );	///< Executes indices of current task until none is left
+	
+	// data
+	
+	QList<CqTaskPoolThread*>	_threads;	///< Worker threads
+	QMutex			_mutex;			///< Guards state below
+	QWaitCondition	_taskStarted;	///< Signalled when new task is started
+	QWaitCondition	_taskDone;		///< Signalled when last worker finishes task
+	b2Task*			_pTask;			///< Current task
+	int				_count;			///< Indices in current task
+	QAtomicInt		_next;			///< Next index to execute
+	int				_busy;			///< Workers still executing current task
+	int				_generation;	///< Incremented with each task
+	bool			_finish;		///< Workers should finish
+};
+
+#endif // CQTASKPOOL_H
+
+// EOF
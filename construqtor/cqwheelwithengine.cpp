@@ -150,6 +150,7 @@ void CqWheelWithEngine::setSimulation( CqSimulation* pSimulation )
 	Q_ASSERT( pSimulation );
 	CqCompoundItem::setSimulation( pSimulation );
 	
+	_controller.setOwner( this );
 	pSimulation->addController( &_controller );
 }
 
@@ -18,14 +18,25 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+// box2d
+#include "b2Body.h"
+#include "b2Joint.h"
+#include "b2RevoluteJoint.h"
+#include "b2PrismaticJoint.h"
 
+// local
 #include "cqworld.h"
 
-CqWorld::CqWorld( const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, QObject* parent )
+CqWorld::CqWorld( const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep
+	, b2BroadPhaseType broadPhaseType, QObject* parent )
 	: QObject( parent )
-	, b2World( worldAABB, gravity, doSleep )
+	, b2World( worldAABB, gravity, doSleep, broadPhaseType )
+	, _mutex( QMutex::Recursive )
 {
-	// nothing more
+	_front				= 0;
+	_published			= false;
+	_previousPublished	= false;
+	_interpolation		= 1.0;
 }
 
 // ======================== destructor ==========================
@@ -34,6 +45,304 @@ CqWorld::~CqWorld()
 	// nope
 }
 
+// ======================== add body ============================
+int CqWorld::addBody( const b2Body* pBody )
+{
+	Q_ASSERT( pBody );
+	
+	int slot;
+	if ( ! _freeBodySlots.isEmpty() )
+	{
+		slot = _freeBodySlots.last();
+		_freeBodySlots.pop_back();
+		_bodies[ slot ] = pBody;
+	}
+	else
+	{
+		slot = _bodies.size();
+		_bodies.append( pBody );
+		for( int i = 0; i < 2; i++ )
+		{
+			_poses[i].bodies.resize( _bodies.size() );
+		}
+	}
+	
+	for( int i = 0; i < 2; i++ )
+	{
+		_poses[i].bodies[ slot ].valid = false;
+		_poses[i].bodies[ slot ].previousValid = false;
+	}
+	
+	return slot;
+}
+
+// ======================== forget body =========================
+/// Frees body slot, so new body added to the same slot will not inherit its pose
+void CqWorld::forgetBody( int slot )
+{
+	Q_ASSERT( slot >= 0 && slot < _bodies.size() && _bodies[ slot ] );
+	
+	_bodies[ slot ] = NULL;
+	for( int i = 0; i < 2; i++ )
+	{
+		_poses[i].bodies[ slot ].valid = false;
+		_poses[i].bodies[ slot ].previousValid = false;
+	}
+	_freeBodySlots.append( slot );
+}
+
+// ======================== add joint ===========================
+int CqWorld::addJoint( const b2Joint* pJoint )
+{
+	Q_ASSERT( pJoint );
+	
+	int slot;
+	if ( ! _freeJointSlots.isEmpty() )
+	{
+		slot = _freeJointSlots.last();
+		_freeJointSlots.pop_back();
+		_joints[ slot ] = pJoint;
+		_jointTemperatures[ slot ] = 0.0f;
+	}
+	else
+	{
+		slot = _joints.size();
+		_joints.append( pJoint );
+		_jointTemperatures.append( 0.0f );
+		for( int i = 0; i < 2; i++ )
+		{
+			_poses[i].joints.resize( _joints.size() );
+		}
+	}
+	
+	for( int i = 0; i < 2; i++ )
+	{
+		_poses[i].joints[ slot ].valid = false;
+		_poses[i].joints[ slot ].previousValid = false;
+	}
+	
+	return slot;
+}
+
+// ======================== forget joint ========================
+void CqWorld::forgetJoint( int slot )
+{
+	Q_ASSERT( slot >= 0 && slot < _joints.size() && _joints[ slot ] );
+	
+	_joints[ slot ] = NULL;
+	for( int i = 0; i < 2; i++ )
+	{
+		_poses[i].joints[ slot ].valid = false;
+		_poses[i].joints[ slot ].previousValid = false;
+	}
+	_freeJointSlots.append( slot );
+}
+
+// ===================== set joint temperature ==================
+void CqWorld::setJointTemperature( int slot, float32 temperature )
+{
+	Q_ASSERT( slot >= 0 && slot < _joints.size() && _joints[ slot ] );
+	
+	_jointTemperatures[ slot ] = temperature;
+}
+
+// ======================== same pose ===========================
+static inline bool samePose( const CqBodyPose& a, const CqBodyPose& b )
+{
+	return a.position.x == b.position.x && a.position.y == b.position.y && a.rotation == b.rotation;
+}
+
+// ======================== record poses ========================
+/// Writes current poses to back buffer, either as poses before last step (previous == true),
+/// or as poses after it. Static and sleeping bodies, whose pose is already in the buffer, are skipped.
+void CqWorld::recordPoses( bool previous )
+{
+	Poses& back = _poses[ 1 - _front ];
+	
+	for( int slot = 0; slot < _bodies.size(); slot++ )
+	{
+		const b2Body* pBody = _bodies[ slot ];
+		if ( ! pBody )
+		{
+			continue;
+		}
+		
+		CqBodyPose pose;
+		pose.position = pBody->GetCenterPosition();
+		pose.rotation = pBody->GetRotation();
+		
+		PublishedBody& published = back.bodies[ slot ];
+		
+		// nothing moves static or sleeping body, buffer has it already
+		if ( ( pBody->IsStatic() || pBody->IsSleeping() ) && published.valid && published.previousValid
+			&& samePose( published.pose, pose ) && samePose( published.previous, pose ) )
+		{
+			continue;
+		}
+		
+		if ( previous )
+		{
+			published.previous = pose;
+			published.previousValid = true;
+		}
+		else
+		{
+			// no previous state - no interpolation
+			if ( ! _previousPublished || ! published.previousValid )
+			{
+				published.previous = pose;
+				published.previousValid = true;
+			}
+			published.pose = pose;
+			published.valid = true;
+		}
+	}
+	
+	for( int slot = 0; slot < _joints.size(); slot++ )
+	{
+		const b2Joint* pJoint = _joints[ slot ];
+		if ( ! pJoint )
+		{
+			continue;
+		}
+		
+		PublishedJoint& published = back.joints[ slot ];
+		if ( previous )
+		{
+			published.previous = pJoint->GetAnchor1();
+			published.previousValid = true;
+			continue;
+		}
+		
+		CqJointState& state = published.state;
+		state.anchor		= pJoint->GetAnchor1();
+		state.speed			= 0.0f;
+		state.translation	= 0.0f;
+		state.motorImpulse	= 0.0f;
+		state.temperature	= _jointTemperatures[ slot ];
+		
+		// motor impulse is what force getters return for unit inverse time step
+		if ( pJoint->GetType() == e_revoluteJoint )
+		{
+			const b2RevoluteJoint* pRevolute = (const b2RevoluteJoint*)pJoint;
+			state.speed			= pRevolute->GetJointSpeed();
+			state.motorImpulse	= pRevolute->GetMotorTorque( 1.0f );
+		}
+		else if ( pJoint->GetType() == e_prismaticJoint )
+		{
+			const b2PrismaticJoint* pPrismatic = (const b2PrismaticJoint*)pJoint;
+			state.speed			= pPrismatic->GetJointSpeed();
+			state.translation	= pPrismatic->GetJointTranslation();
+			state.motorImpulse	= pPrismatic->GetMotorForce( 1.0f );
+		}
+		
+		if ( ! _previousPublished || ! published.previousValid )
+		{
+			published.previous = state.anchor;
+			published.previousValid = true;
+		}
+		published.valid = true;
+	}
+}
+
+// ==================== publish previous poses ==================
+/// Should be called before last step of the batch
+void CqWorld::publishPreviousPoses()
+{
+	recordPoses( true );
+	_previousPublished = true;
+}
+
+// ======================== publish poses =======================
+void CqWorld::publishPoses()
+{
+	recordPoses( false );
+	
+	_published = true;
+	_previousPublished = false;
+}
+
+// ======================== swap poses ==========================
+void CqWorld::swapPoses()
+{
+	// swap only if something new was published, otherwise we would go back in time
+	if ( _published )
+	{
+		_front = 1 - _front;
+		_published = false;
+	}
+}
+
+// ======================== body pose ===========================
+bool CqWorld::bodyPose( int slot, CqBodyPose* pPose ) const
+{
+	Q_ASSERT( pPose );
+	
+	const Poses& front = _poses[ _front ];
+	
+	if ( slot < 0 || slot >= front.bodies.size() || ! front.bodies[ slot ].valid )
+	{
+		return false;
+	}
+	const PublishedBody& published = front.bodies[ slot ];
+	*pPose = published.pose;
+	
+	// interpolate. NOTE: box2d rotation is not normalized, so it can be interpolated lineary
+	if ( _interpolation < 1.0 )
+	{
+		float32 t = float32( _interpolation );
+		pPose->position = published.previous.position + t * ( pPose->position - published.previous.position );
+		pPose->rotation = published.previous.rotation + t * ( pPose->rotation - published.previous.rotation );
+	}
+	
+	return true;
+}
+
+// ======================== joint state =========================
+bool CqWorld::jointState( int slot, CqJointState* pState ) const
+{
+	Q_ASSERT( pState );
+	
+	const Poses& front = _poses[ _front ];
+	
+	if ( slot < 0 || slot >= front.joints.size() || ! front.joints[ slot ].valid )
+	{
+		return false;
+	}
+	const PublishedJoint& published = front.joints[ slot ];
+	*pState = published.state;
+	
+	if ( _interpolation < 1.0 )
+	{
+		float32 t = float32( _interpolation );
+		pState->anchor = published.previous + t * ( pState->anchor - published.previous );
+	}
+	
+	return true;
+}
+
+// ======================== kinetic energy ========================
+float32 CqWorld::kineticEnergy()
+{
+	float32 energy = 0.0f;
+	
+	for( int i = 0; i < GetBodyCount(); i++ )
+	{
+		b2Body* pBody = GetBody( i );
+		
+		// static, frozen and sleeping bodies are not moving
+		if ( pBody->IsStatic() || pBody->IsFrozen() || pBody->IsSleeping() )
+		{
+			continue;
+		}
+		
+		float32 w = pBody->GetAngularVelocity();
+		energy += 0.5f * pBody->GetMass() * b2Dot( pBody->GetLinearVelocity(), pBody->GetLinearVelocity() );
+		energy += 0.5f * pBody->GetInertia() * w * w;
+	}
+	
+	return energy;
+}
 
 
 // EOF
@@ -22,12 +22,38 @@
 
 // qt
 #include <QObject>
+#include <QVector>
+#include <QMutex>
 
 // box2d
 #include "b2World.h"
 
+/// Body position and rotation, as published by world after simulation steps
+struct CqBodyPose
+{
+	b2Vec2	position;		///< Body center position
+	float32	rotation;		///< Body rotation [radians]
+};
+
+/// Joint state, as published by world after simulation steps
+struct CqJointState
+{
+	b2Vec2	anchor;			///< Joint's first anchor position
+	float32	speed;			///< Joint speed [rad/s] or [m/s], revolute and prismatic joints only
+	float32	translation;	///< Joint translation [m], prismatic joints only
+	float32	motorImpulse;	///< Motor impulse applied in last step. Multiply by inverse time step to get force
+	float32	temperature;	///< Temperature of fragile joint, as set by setJointTemperature()
+};
+
 /**
 	Qt Wrapper around b2d World.
+	
+	World publishes body poses and joint states into double-buffered snapshot. Simulation 
+	steps (possibly on worker thread) fill back buffer with publishPoses(), GUI thread
+	makes it current with swapPoses() and reads it when updating items.
+	Snapshot holds two last physical states, so GUI can interpolate between them.
+	Bodies and joints are registered in snapshot with addBody() / addJoint(), and are
+	then identified by slot - stable index into snapshot arrays.
 
 	@author Maciek Gajewski <maciej.gajewski0@gmail.com>
 */
@@ -37,10 +63,84 @@ class CqWorld : public QObject, public b2World
 public:
 	
 	// constructor/destructor
-	CqWorld( const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, QObject* parent = NULL );
+	CqWorld( const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep
+		, b2BroadPhaseType broadPhaseType = e_sweepAndPruneBroadPhase, QObject* parent = NULL );
 	~CqWorld();
+	
+	/// Mutex guarding box2d objects. Held by worker thread while it calculates simulation steps.
+	/// GUI code modyfying world while simulation is running should lock it.
+	QMutex* mutex() { return &_mutex; }
+	
+	// published poses
+	int addBody( const b2Body* pBody );				///< Adds body to published poses, returns its slot
+	void forgetBody( int slot );					///< Removes destroyed body from published poses
+	int addJoint( const b2Joint* pJoint );			///< Adds joint to published poses, returns its slot
+	void forgetJoint( int slot );					///< Removes destroyed joint from published poses
+	/// Sets temperature published with joint state. Called by fragile joints from calculation step
+	void setJointTemperature( int slot, float32 temperature );
+	
+	void publishPreviousPoses();					///< Copies poses before last step to back buffer
+	void publishPoses();							///< Copies current poses to back buffer
+	void swapPoses();								///< Makes poses published since last swap current
+	
+	/// Sets position between previous (0.0) and current (1.0) state, used when reading poses
+	void setInterpolation( double interpolation ) { _interpolation = interpolation; }
+	double interpolation() const { return _interpolation; }
+	
+	/// Reads interpolated pose of body in slot. Returns false if pose was not published yet
+	bool bodyPose( int slot, CqBodyPose* pPose ) const;
+	/// Reads state of joint in slot, with interpolated anchor. Returns false if it was not published yet
+	bool jointState( int slot, CqJointState* pState ) const;
+	
+	// state
+	/// Sum of kinetic energy of awake dynamic bodies [J]. Call only when world is not being stepped.
+	float32 kineticEnergy();
 
 private:
+
+	/// Published body pose
+	struct PublishedBody
+	{
+		CqBodyPose	pose;				///< Body pose
+		CqBodyPose	previous;			///< Body pose before last step
+		bool		valid;				///< If pose was published for body currently in slot
+		bool		previousValid;		///< If previous pose was published for body currently in slot
+	};
+	
+	/// Published joint state
+	struct PublishedJoint
+	{
+		CqJointState	state;			///< Joint state
+		b2Vec2			previous;		///< Anchor before last step
+		bool			valid;			///< If state was published for joint currently in slot
+		bool			previousValid;	///< If previous anchor was published for joint currently in slot
+	};
+
+	/// Published poses buffer, indexed by slot
+	struct Poses
+	{
+		QVector< PublishedBody >	bodies;		///< Body poses
+		QVector< PublishedJoint >	joints;		///< Joint states
+	};
+	
+	// methods
+	
+	void recordPoses( bool previous );	///< Copies current (or previous) poses to back buffer
+	
+	// data
+	
+	QVector< const b2Body* >	_bodies;			///< Bodies by slot, NULL in free slot
+	QVector< const b2Joint* >	_joints;			///< Joints by slot, NULL in free slot
+	QVector< int >				_freeBodySlots;		///< Slots released by forgetBody()
+	QVector< int >				_freeJointSlots;	///< Slots released by forgetJoint()
+	QVector< float32 >			_jointTemperatures;	///< Temperatures to publish, by joint slot
+	
+	Poses	_poses[2];			///< Front and back buffer
+	int		_front;				///< Index of front buffer
+	bool	_published;			///< If back buffer contains fresh poses
+	bool	_previousPublished;	///< If back buffer contains fresh previous poses
+	double	_interpolation;		///< Position between previous and current state
+	QMutex	_mutex;				///< Box2d access mutex
 };
 
 
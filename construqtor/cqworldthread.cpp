@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// local
+#include "cqworldthread.h"
+#include "cqsimulation.h"
+
+// ============================== constructor =======================
+CqWorldThread::CqWorldThread( CqSimulation* pSimulation )
+	: QThread( NULL )
+{
+	Q_ASSERT( pSimulation );
+	
+	_pSimulation	= pSimulation;
+	_steps			= 0;
+	_leftSteps		= 0;
+	_finish			= false;
+}
+
+// ============================== destructor ========================
+CqWorldThread::~CqWorldThread()
+{
+	// ask thread to finish, after current batch
+	_mutex.lock();
+	_finish = true;
+	_stepsRequested.wakeAll();
+	_mutex.unlock();
+	
+	wait();
+}
+
+// ============================== start steps =======================
+void CqWorldThread::startSteps( int steps )
+{
+	QMutexLocker locker( &_mutex );
+	
+	Q_ASSERT( _steps == 0 );
+	if ( steps > 0 )
+	{
+		_steps = steps;
+		_stepsRequested.wakeAll();
+	}
+}
+
+// ============================== wait for steps ====================
+/// Returns steps of the batch that were not calculated, see CqSimulation::calculate().
+/// They are reported once.
+int CqWorldThread::waitForSteps()
+{
+	QMutexLocker locker( &_mutex );
+	
+	while ( _steps > 0 )
+	{
+		_stepsDone.wait( &_mutex );
+	}
+	
+	int leftSteps = _leftSteps;
+	_leftSteps = 0;
+	
+	return leftSteps;
+}
+
+// ============================== is busy ===========================
+bool CqWorldThread::isBusy() const
+{
+	QMutexLocker locker( &_mutex );
+	
+	return _steps > 0;
+}
+
+// ============================== run ===============================
+void CqWorldThread::run()
+{
+	QMutexLocker locker( &_mutex );
+	
+	forever
+	{
+		while ( _steps == 0 && ! _finish )
+		{
+			_stepsRequested.wait( &_mutex );
+		}
+		
+		if ( _finish )
+		{
+			break;
+		}
+		
+		// calculate with mutex unlocked, so GUI can check if we're busy
+		int steps = _steps;
+		locker.unlock();
+		
+		int calculated = _pSimulation->calculate( steps );
+		
+		locker.relock();
+		_leftSteps = steps - calculated;
+		_steps = 0;
+		_stepsDone.wakeAll();
+	}
+}
+
+// EOF
@@ -0,0 +1,70 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski   *
+ *   maciej.gajewski0@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef CQWORLDTHREAD_H
+#define CQWORLDTHREAD_H
+
+// Qt
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+// local
+class CqSimulation;
+
+/**
+	Worker thread calculating simulation steps in background.
+	GUI thread requests batch of steps with startSteps(), and collects results with waitForSteps().
+	Only one batch can be calculated at time.
+	@author Maciek Gajewski <maciej.gajewski0@gmail.com>
+*/
+class CqWorldThread : public QThread
+{
+	Q_OBJECT
+public:
+
+	// construction / destruction
+	explicit CqWorldThread( CqSimulation* pSimulation );
+	virtual ~CqWorldThread();
+	
+	// operations
+	void startSteps( int steps );	///< Starts calculating steps in background
+	int waitForSteps();				///< Blocks until batch is calculated, returns steps it left out
+	bool isBusy() const;			///< If batch of steps is being calculated
+
+protected:
+
+	virtual void run();
+
+private:
+
+	// data
+	
+	CqSimulation*	_pSimulation;	///< Simulation calculating steps
+	mutable QMutex	_mutex;			///< Guards state below
+	QWaitCondition	_stepsRequested;///< Signalled when new batch is requested
+	QWaitCondition	_stepsDone;		///< Signalled when batch is calculated
+	int				_steps;			///< Steps in current batch, 0 when idle
+	int				_leftSteps;		///< Steps left out of last batch, when joint overheated
+	bool			_finish;		///< Thread should finish
+};
+
+#endif // CQWORLDTHREAD_H
+
+// EOF
@@ -32,6 +32,8 @@
 #include "cqgirder.h"
 #include "cqdocument.h"
 #include "cqelement.h"
+#include "cqrandom.h"
+#include "cqrecording.h"
 
 // tags
 static const char*	TAG_GAME			= "game";	// root element
@@ -46,6 +48,8 @@ GameManager::GameManager(QObject *parent)
 	_pSim			= NULL;
 	_pBox			= NULL;
 	_pInstructions	= NULL;
+	_interactive	= true;
+	_deliveryTime	= -1.0;
 }
 
 // ========================================================
@@ -114,7 +118,7 @@ void GameManager::startGame( CqSimulation* pSim, double maxSlope, double stoneSi
 	{
 		CqStone* pStone = CqStone::createRandomStone( stoneSize );
 		double stoneX = worldRect.left() + stoneMargin
-			+ ( worldRect.width() - 2 * stoneMargin ) * qrand() / RAND_MAX;
+			+ ( worldRect.width() - 2 * stoneMargin ) * CqRandom::uniform();
 			
 		double stoneY = pGround->height( stoneX ) + stoneSize;
 		
@@ -151,12 +155,13 @@ void GameManager::startGame( CqSimulation* pSim, double maxSlope, double stoneSi
 	pInstructions->show();
 	pInstructions->setZValue( 20.0 );
 	
-	// run for 5 seconds, to lest stone settle
-	pSim->run( 5.0 );
+	// let stones settle, but don't wait longer than 5 seconds
+	pSim->runUntilSettled( 5.0 );
 	
 	// set these pointers after sim is pre-run
 	_pInstructions = pInstructions;
 	_pBox = pBox;
+	_deliveryTime = -1.0;
 	
 }
 // ===========================================================================
@@ -192,7 +197,11 @@ void GameManager::simulationStep()
 		{
 			qDebug("success!");
 			_pBox = NULL;
-			QMessageBox::information( NULL, "Success!", "You managed to deliver the package, congratulations!" );
+			_deliveryTime = _pSim->simulationTime();
+			if ( _interactive )
+			{
+				QMessageBox::information( NULL, "Success!", "You managed to deliver the package, congratulations!" );
+			}
 		}
 	}
 }
@@ -205,13 +214,7 @@ void GameManager::loadGame( const QString& path )
 		CqDocument doc;
 		doc.loadFromFile( path );
 		
-		CqElement root = doc.readElement( TAG_GAME );
-		
-		CqElement simulation = root.readElement( TAG_SIMULATION );
-		_pSim->load( simulation );
-		
-		_pInstructions = NULL; // TODO create CqSvgItem, read it
-		_pBox = root.readItemPointer( TAG_BOX );
+		loadGame( doc );
 	}
 }
 
@@ -221,21 +224,108 @@ void GameManager::saveGame( const QString& path )
 	if ( _pSim )
 	{
 		CqDocument doc;
-		CqElement root = doc.createElement();
-		
-		CqElement simulation = doc.createElement();
-		_pSim->store( simulation );
-		
-		root.appendElement( TAG_SIMULATION, simulation );
-		if ( _pBox )
-		{
-			root.appendItemPointer( TAG_BOX, _pBox );
-		}
+		saveGame( doc );
 		
-		doc.appenElement( TAG_GAME, root );
 		doc.saveToFile( path );
 	}
 }
 
+// ===========================================================================
+void GameManager::loadGameFromString( const QString& game )
+{
+	if ( _pSim )
+	{
+		CqDocument doc;
+		doc.loadFromString( game );
+		
+		loadGame( doc );
+	}
+}
+
+// ===========================================================================
+QString GameManager::saveGameToString() const
+{
+	CqDocument doc;
+	if ( _pSim )
+	{
+		saveGame( doc );
+	}
+	
+	return doc.saveToString();
+}
+
+// ===========================================================================
+void GameManager::loadGame( CqDocument& doc )
+{
+	CqElement root = doc.readElement( TAG_GAME );
+	
+	CqElement simulation = root.readElement( TAG_SIMULATION );
+	_pSim->load( simulation );
+	
+	_pInstructions = NULL; // TODO create CqSvgItem, read it
+	_pBox = root.readItemPointer( TAG_BOX );
+	_deliveryTime = -1.0;
+}
+
+// ===========================================================================
+void GameManager::saveGame( CqDocument& doc ) const
+{
+	CqElement root = doc.createElement();
+	
+	CqElement simulation = doc.createElement();
+	_pSim->store( simulation );
+	
+	root.appendElement( TAG_SIMULATION, simulation );
+	if ( _pBox )
+	{
+		root.appendItemPointer( TAG_BOX, _pBox );
+	}
+	
+	doc.appenElement( TAG_GAME, root );
+}
+
+// ===========================================================================
+void GameManager::startRecording( CqRecording* pRecording )
+{
+	Q_ASSERT( pRecording );
+	Q_ASSERT( _pSim );
+	
+	pRecording->clear();
+	pRecording->setInitialState( saveGameToString() );
+	
+	// XML doesn't hold exact state, so recorded session starts from the same state as replay will
+	loadGameFromString( pRecording->initialState() );
+	
+	quint32 seed = CqRandom::next();
+	CqRandom::setSeed( seed );
+	pRecording->setSeed( seed );
+	pRecording->setConstraintColoring( _pSim->constraintColoring() );
+	
+	_pSim->startRecording( pRecording );
+}
+
+// ===========================================================================
+void GameManager::stopRecording()
+{
+	if ( _pSim )
+	{
+		_pSim->stopRecording();
+	}
+}
+
+// ===========================================================================
+void GameManager::startReplay( const CqRecording* pRecording )
+{
+	Q_ASSERT( pRecording );
+	Q_ASSERT( _pSim );
+	
+	loadGameFromString( pRecording->initialState() );
+	CqRandom::setSeed( pRecording->seed() );
+	
+	// constraint order changes results, replay with the one session was recorded with
+	_pSim->setConstraintColoring( pRecording->constraintColoring() );
+	_pSim->startReplay( pRecording );
+}
+
 // EOF
 
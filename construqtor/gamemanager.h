@@ -26,6 +26,8 @@
 // Cq
 class CqSimulation;
 class CqItem;
+class CqRecording;
+class CqDocument;
 class QGraphicsItem;
 
 /**
@@ -42,6 +44,15 @@ public:
 	void setSimulation( CqSimulation* pSim );
 	CqSimulation* simulation() const { return _pSim; }
 	
+	/// If set to false, manager will not pop up any dialogs (used by headless runner)
+	void setInteractive( bool interactive ) { _interactive = interactive; }
+	bool interactive() const { return _interactive; }
+	
+	/// If package was delivered to target area
+	bool packageDelivered() const { return _deliveryTime >= 0.0; }
+	/// Simulation time at which package was delivered, negative if not delivered yet [s]
+	double deliveryTime() const { return _deliveryTime; }
+	
 public slots:
 
 	void startEasyGame();
@@ -50,6 +61,19 @@ public slots:
 	
 	void loadGame( const QString& path );
 	void saveGame( const QString& path );
+	
+public:
+
+	// in-memory saved game
+	QString saveGameToString() const;
+	void loadGameFromString( const QString& game );
+	
+	// recording / replay
+	/// Restarts game from its saved state and records session from now on
+	void startRecording( CqRecording* pRecording );
+	void stopRecording();
+	/// Loads recording's initial state and replays its inputs
+	void startReplay( const CqRecording* pRecording );
 
 private slots:
 
@@ -58,10 +82,14 @@ private slots:
 private:
 
 	void startGame( CqSimulation* pSim, double maxSlope, double stoneSize, int stones );
+	void loadGame( CqDocument& doc );			///< Loads game from document
+	void saveGame( CqDocument& doc ) const;		///< Stores game into document
 	
 	CqSimulation*	_pSim;
 	CqItem*			_pBox;
 	QGraphicsItem*	_pInstructions;
+	bool			_interactive;
+	double			_deliveryTime;
 };
 
 #endif // GAMEMANAGER_H
@@ -18,16 +18,20 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 #include <QApplication>
+#include <QStringList>
 
 #include "mainwindow.h"
 #include "gamemanager.h"
 #include "cqsimulation.h"
 #include "difficultyselector.h"
+#include "cqrandom.h"
+#include "cqrecording.h"
+#include "gexception.h"
 
 int main(int argc, char *argv[])
 {
 	// initrandom generator
-	qsrand( time(NULL) );
+	CqRandom::setSeed( time(NULL) );
 	
 	QApplication app(argc, argv);
 	MainWindow window;
@@ -36,27 +40,71 @@ int main(int argc, char *argv[])
 	DifficultySelector selector;
 	
 	manager.setSimulation( &simulation );
-	// select difficulty
-	int d = selector.execute();
-	switch( d )
+	
+	QStringList args = app.arguments();
+	
+	// calculate physics on separate thread
+	if ( args.contains( "--threaded" ) )
 	{
-		case 1:
-			manager.startEasyGame();
-			break;
-		case 2:
-			manager.startIntermediateGame();
-			break;
-		case 3:
-			manager.startHardGame();
-			break;
-		
-		default:
-		// bye
-			return 0;
+		simulation.setThreaded( true );
+	}
+	
+	// --record file: record session, --replay file: replay recorded session in real time
+	CqRecording recording;
+	QString recordPath, replayPath;
+	int recordIndex = args.indexOf( "--record" );
+	if ( recordIndex > 0 && recordIndex + 1 < args.size() )
+	{
+		recordPath = args[ recordIndex + 1 ];
+	}
+	int replayIndex = args.indexOf( "--replay" );
+	if ( replayIndex > 0 && replayIndex + 1 < args.size() )
+	{
+		replayPath = args[ replayIndex + 1 ];
 	}
 	
 	window.setGame( &manager );
 	
+	if ( ! replayPath.isEmpty() )
+	{
+		try
+		{
+			recording.loadFromFile( replayPath );
+		}
+		catch( const GException& e )
+		{
+			qWarning( "%s", qPrintable( e.getMessage() ) );
+			return 1;
+		}
+		manager.startReplay( &recording );
+	}
+	else
+	{
+		// select difficulty
+		int d = selector.execute();
+		switch( d )
+		{
+			case 1:
+				manager.startEasyGame();
+				break;
+			case 2:
+				manager.startIntermediateGame();
+				break;
+			case 3:
+				manager.startHardGame();
+				break;
+			
+			default:
+			// bye
+				return 0;
+		}
+		
+		if ( ! recordPath.isEmpty() )
+		{
+			window.setRecording( &recording );
+		}
+	}
+	
 	// configure view
 	window.view->setSimulation( &simulation );
 	//window.view->rotate( 180 );
@@ -64,5 +112,26 @@ int main(int argc, char *argv[])
 	
 	window.show();
 	
-	return app.exec();
+	if ( ! replayPath.isEmpty() )
+	{
+		window.on_buttonStart_clicked();
+	}
+	
+	int result = app.exec();
+	
+	if ( ! recordPath.isEmpty() )
+	{
+		manager.stopRecording();
+		try
+		{
+			recording.saveToFile( recordPath );
+		}
+		catch( const GException& e )
+		{
+			qWarning( "%s", qPrintable( e.getMessage() ) );
+			result = 1;
+		}
+	}
+	
+	return result;
 }
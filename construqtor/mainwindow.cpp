@@ -20,6 +20,7 @@
 
 // Qt
 #include <QFileDialog>
+#include <QMessageBox>
 
 // Cq
 #include "cqnail.h"
@@ -43,6 +44,7 @@ MainWindow::MainWindow(QWidget *parent)
 {
 	setupUi( this );
 	_pSimulation = NULL;
+	_pRecording = NULL;
 	
 	connect( view, SIGNAL(pointerPos(double,double)), SLOT(scenePointerPos(double,double)));
 	connect( view, SIGNAL(selectedDescription( const QString&)), SLOT(selectedDescription( const QString&)));
@@ -52,7 +54,21 @@ MainWindow::MainWindow(QWidget *parent)
 void MainWindow::on_buttonStart_clicked()
 {
 	simulationStarted();
+	
+	// record from first start
+	if ( _pRecording && ! _pSimulation->isRecording() && ! _pSimulation->isReplaying() )
+	{
+		_pGameManager->startRecording( _pRecording );
+	}
+	
 	_pSimulation->start();
+	
+	// remember state to reset to, if not started after pause. Resetting would break recording
+	if ( _resetSnapshot.isEmpty() && ! _pSimulation->isRecording() && ! _pSimulation->isReplaying() )
+	{
+		_resetSnapshot = _pSimulation->takeSnapshot();
+		buttonReset->setEnabled( true );
+	}
 }
 
 // =========================== stop =======================
@@ -62,6 +78,23 @@ void MainWindow::on_buttonStop_clicked()
 	simulationPaused();
 }
 
+// =========================== reset =======================
+void MainWindow::on_buttonReset_clicked()
+{
+	_pSimulation->stop();
+	simulationPaused();
+	
+	if ( ! _pSimulation->restoreSnapshot( _resetSnapshot ) )
+	{
+		QMessageBox::information( this, tr("Reset")
+			, tr("Construction has changed since simulation was started and can't be reset.") );
+	}
+	
+	// next start creates new reset point
+	_resetSnapshot.clear();
+	buttonReset->setEnabled( false );
+}
+
 // ================================= on start =============
 void MainWindow::simulationStarted()
 {
@@ -279,6 +312,9 @@ void MainWindow::on_buttonLoad_clicked()
 	if ( ! path.isNull() )
 	{
 		_pGameManager->loadGame( path );
+		
+		_resetSnapshot.clear();
+		buttonReset->setEnabled( false );
 	}
 }
 
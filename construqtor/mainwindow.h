@@ -25,6 +25,7 @@
 #include "ui_mainwindow.h"
 class CqMotorController;
 class GameManager;
+class CqRecording;
 
 class MainWindow: public QWidget, public Ui::MainWindow
 {
@@ -33,6 +34,8 @@ public:
 	MainWindow( QWidget *parent = 0 );
 	
 	void setGame( GameManager* pManager );
+	/// Session will be recorded into recording, starting with first start of simulation
+	void setRecording( CqRecording* pRecording ) { _pRecording = pRecording; }
 	
 public slots:
 	
@@ -40,6 +43,7 @@ public slots:
 	
 	void on_buttonStart_clicked();
 	void on_buttonStop_clicked();
+	void on_buttonReset_clicked();
 	
 	// save/load
 	void on_buttonSave_clicked();
@@ -99,6 +103,8 @@ public slots:
 private:
 	CqSimulation*	_pSimulation;
 	GameManager*	_pGameManager;
+	QByteArray		_resetSnapshot;		///< State simulation was started from, empty if none
+	CqRecording*	_pRecording;		///< Recording to record session into, or NULL
 };
 
 #endif
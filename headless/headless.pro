@@ -0,0 +1,35 @@
+TEMPLATE = app
+
+include(../construqtor/construqtor.pri)
+
+SOURCES += main.cpp
+
+CONFIG += debug \
+qt \
+warn_on \
+rtti \
+console
+QT += core \
+gui \
+xml \
+svg
+TARGET = ../bin/construqtor-headless
+
+OBJECTS_DIR = .obj
+
+MOC_DIR = .moc
+
+CONFIG -= release \
+app_bundle
+
+INCLUDEPATH += ../box2d \
+../gpc \
+../box2d/Dynamics/Joints \
+../box2d/Collision \
+../box2d/Dynamics \
+../box2d/Common
+LIBS += ../lib/libbox2d.a \
+../lib/libgpc.a
+TARGETDEPS += ../lib/libbox2d.a \
+../lib/libgpc.a
+RESOURCES += ../graphics/graphics.qrc
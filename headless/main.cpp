@@ -0,0 +1,220 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski                                 *
+ *   maciej.gajewski0@gmail.com                                            *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// std
+#include <stdio.h>
+#include <time.h>
+
+// Qt
+#include <QApplication>
+#include <QStringList>
+
+// local
+#include "cqevaluator.h"
+
+// constants
+static const double DEFAULT_TIME_SPAN	= 60.0;	// [s]
+
+// ============================== usage =====================
+static void usage()
+{
+	fprintf( stderr,
+		"Usage: construqtor-headless [-t seconds] [-j threads] [-b sap | tree] [-i threads] [-c on | off] [-s | -r] file...\n"
+		"Runs saved constructions without GUI and prints outcome metrics, one line per file.\n"
+		"  -t seconds  simulated time span (default: %g)\n"
+		"  -j threads  number of files evaluated in parallel (default: one per core)\n"
+		"  -b type     broad-phase: sap - sweep and prune (default), tree - dynamic AABB tree\n"
+		"  -i threads  threads solving independent islands of each file (default: 1)\n"
+		"  -c on|off   solve constraints of large islands in parallel colored batches (default: on,\n"
+		"              replays use recorded setting)\n"
+		"  -s          files are plain simulations, not saved games\n"
+		"  -r          files are recorded sessions, replayed for their recorded length\n"
+		, DEFAULT_TIME_SPAN );
+}
+
+// ============================== main =====================
+int main(int argc, char *argv[])
+{
+	// GUI disabled - we need only QtGui classes, not a display
+	QApplication app( argc, argv, false );
+	
+	// parse arguments
+	double timeSpan		= DEFAULT_TIME_SPAN;
+	int threads				= 0;
+	b2BroadPhaseType broadPhase	= e_sweepAndPruneBroadPhase;
+	int solverThreads		= 1;
+	bool constraintColoring	= true;
+	bool plainSimulation	= false;
+	bool replay				= false;
+	QStringList files;
+	
+	QStringList args = app.arguments();
+	for( int i = 1; i < args.size(); i++ )
+	{
+		if ( args[i] == "-t" && i + 1 < args.size() )
+		{
+			bool ok = false;
+			timeSpan = args[++i].toDouble( &ok );
+			if ( ! ok || timeSpan <= 0.0 )
+			{
+				usage();
+				return 1;
+			}
+		}
+		else if ( args[i] == "-j" && i + 1 < args.size() )
+		{
+			bool ok = false;
+			threads = args[++i].toInt( &ok );
+			if ( ! ok || threads <= 0 )
+			{
+				usage();
+				return 1;
+			}
+		}
+		else if ( args[i] == "-b" && i + 1 < args.size() )
+		{
+			QString type = args[++i];
+			if ( type == "sap" )
+			{
+				broadPhase = e_sweepAndPruneBroadPhase;
+			}
+			else if ( type == "tree" )
+			{
+				broadPhase = e_dynamicTreeBroadPhase;
+			}
+			else
+			{
+				usage();
+				return 1;
+			}
+		}
+		else if ( args[i] == "-i" && i + 1 < args.size() )
+		{
+			bool ok = false;
+			solverThreads = args[++i].toInt( &ok );
+			if ( ! ok || solverThreads <= 0 )
+			{
+				usage();
+				return 1;
+			}
+		}
+		else if ( args[i] == "-c" && i + 1 < args.size() )
+		{
+			QString coloring = args[++i];
+			if ( coloring == "on" )
+			{
+				constraintColoring = true;
+			}
+			else if ( coloring == "off" )
+			{
+				constraintColoring = false;
+			}
+			else
+			{
+				usage();
+				return 1;
+			}
+		}
+		else if ( args[i] == "-s" )
+		{
+			plainSimulation = true;
+		}
+		else if ( args[i] == "-r" )
+		{
+			replay = true;
+		}
+		else if ( args[i].startsWith( "-" ) )
+		{
+			usage();
+			return 1;
+		}
+		else
+		{
+			files.append( args[i] );
+		}
+	}
+	
+	if ( files.isEmpty() || ( plainSimulation && replay ) )
+	{
+		usage();
+		return 1;
+	}
+	
+	// every scenario gets its own simulation, seeded the same
+	CqEvaluator evaluator;
+	quint32 seed = time(NULL);
+	foreach( QString file, files )
+	{
+		CqEvaluator::Scenario scenario;
+		scenario.path		= file;
+		scenario.timeSpan	= timeSpan;
+		scenario.seed		= seed;
+		scenario.broadPhase	= broadPhase;
+		scenario.solverThreads	= solverThreads;
+		scenario.constraintColoring	= constraintColoring;
+		scenario.type		= CqEvaluator::SavedGame;
+		if ( plainSimulation )
+		{
+			scenario.type = CqEvaluator::PlainSimulation;
+		}
+		else if ( replay )
+		{
+			scenario.type = CqEvaluator::RecordedSession;
+		}
+		
+		evaluator.addScenario( scenario );
+	}
+	
+	evaluator.run( threads );
+	
+	int failed = 0;
+	for( int i = 0; i < files.size(); i++ )
+	{
+		const CqEvaluator::Result& result = evaluator.results()[i];
+		
+		if ( ! result.ok )
+		{
+			fprintf( stderr, "%s: %s\n", qPrintable( files[i] ), qPrintable( result.error ) );
+			failed++;
+			continue;
+		}
+		
+		QString timeToTarget = "-";
+		if ( result.delivered )
+		{
+			timeToTarget = QString::number( result.timeToTarget, 'f', 2 );
+		}
+		
+		printf( "%s: delivered=%s time_to_target=%s broken_joints=%d simulated=%.2f wall=%.3f wall_per_sim_second=%.4f\n"
+			, qPrintable( files[i] )
+			, result.delivered ? "yes" : "no"
+			, qPrintable( timeToTarget )
+			, result.brokenJoints
+			, result.simulated
+			, result.wallTime
+			, result.simulated > 0.0 ? result.wallTime / result.simulated : 0.0
+			);
+	}
+	fflush( stdout );
+	
+	return failed > 0 ? 2 : 0;
+}
+
+// EOF
@@ -0,0 +1,302 @@
+/***************************************************************************
+ *   Copyright (C) 2007 by Maciek Gajewski                                 *
+ *   maciej.gajewski0@gmail.com                                            *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// Checks that the SIMD polygon vertex search picks the same vertex as the
+// scalar loop, on random polygons, ties and degenerate inputs, and measures
+// both for each vertex count. b2_minSimdVertices is chosen from the timings.
+
+// std
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <float.h>
+#include <math.h>
+
+// box2d
+#include "b2VertexSearch.h"
+
+// constants
+static const int	CHECKS_PER_COUNT	= 200000;	// random searches per vertex count and case
+static const int	BENCH_POLYGONS		= 4096;		// polygons searched by the timing loop, power of 2
+static const int	BENCH_ROUNDS		= 500;		// timing loop passes over all polygons
+static const int	BENCH_REPEATS		= 7;		// timing loops per measurement, fastest one counts
+static const unsigned int SEED			= 12345;
+
+// ============================== random =====================
+static float32 random( float32 lo, float32 hi )
+{
+	return lo + ( hi - lo ) * float32( rand() ) / float32( RAND_MAX );
+}
+
+// ============================== polygon =====================
+/// Vertex array as polygon shapes store it
+struct Polygon
+{
+	b2Vec2 vertices[ b2_maxPolyVertices ];
+};
+
+// ============================== cases =====================
+enum Case
+{
+	RandomPolygon,		///< random vertices and direction
+	RegularPolygon,		///< regular polygon, axis directions - ties between symmetric vertices
+	DuplicateVertices,	///< some vertices repeated - exact ties
+	ZeroDirection,		///< zero direction - all projections tie at zero
+	Collinear,			///< vertices on a line, direction perpendicular - all tie
+	ExtremeValues,		///< huge, tiny, infinite and NaN coordinates
+	CASE_COUNT
+};
+
+static const char* CASE_NAMES[ CASE_COUNT ] =
+{
+	"random", "regular", "duplicates", "zero-direction", "collinear", "extreme"
+};
+
+// ============================== extreme value =====================
+static float32 extremeValue()
+{
+	static const float32 values[] =
+	{
+		0.0f, -0.0f, 1.0f, -1.0f, FLT_MAX, -FLT_MAX, FLT_MIN, -FLT_MIN, 1e-40f /* denormal */,
+		1e30f, -1e30f, HUGE_VALF, -HUGE_VALF, NAN
+	};
+	
+	return values[ rand() % ( sizeof( values ) / sizeof( values[0] ) ) ];
+}
+
+// ============================== make case =====================
+/// Fills polygon and direction for given case. Vertices past count get garbage, search must ignore them
+static void makeCase( Case c, int count, Polygon* pPolygon, b2Vec2* pDirection )
+{
+	for( int i = 0; i < b2_maxPolyVertices; i++ )
+	{
+		pPolygon->vertices[i].Set( random( -1e3f, 1e3f ), random( -1e3f, 1e3f ) );
+	}
+	pDirection->Set( random( -1.0f, 1.0f ), random( -1.0f, 1.0f ) );
+	
+	switch( c )
+	{
+		case RegularPolygon:
+		{
+			float32 radius = random( 0.1f, 10.0f );
+			for( int i = 0; i < count; i++ )
+			{
+				float32 angle = 2.0f * b2_pi * i / count;
+				pPolygon->vertices[i].Set( radius * cosf( angle ), radius * sinf( angle ) );
+			}
+			static const b2Vec2 directions[] =
+			{
+				b2Vec2( 1.0f, 0.0f ), b2Vec2( -1.0f, 0.0f ), b2Vec2( 0.0f, 1.0f ), b2Vec2( 0.0f, -1.0f )
+			};
+			*pDirection = directions[ rand() % 4 ];
+			break;
+		}
+		
+		case DuplicateVertices:
+			for( int i = 1; i < count; i++ )
+			{
+				if ( rand() % 2 )
+				{
+					pPolygon->vertices[i] = pPolygon->vertices[ rand() % i ];
+				}
+			}
+			break;
+		
+		case ZeroDirection:
+			pDirection->Set( rand() % 2 ? 0.0f : -0.0f, rand() % 2 ? 0.0f : -0.0f );
+			break;
+		
+		case Collinear:
+		{
+			float32 y = random( -10.0f, 10.0f );
+			for( int i = 0; i < count; i++ )
+			{
+				pPolygon->vertices[i].Set( random( -10.0f, 10.0f ), y );
+			}
+			pDirection->Set( 0.0f, random( -1.0f, 1.0f ) );
+			break;
+		}
+		
+		case ExtremeValues:
+			for( int i = 0; i < b2_maxPolyVertices; i++ )
+			{
+				if ( rand() % 2 )
+				{
+					pPolygon->vertices[i].Set( extremeValue(), extremeValue() );
+				}
+			}
+			if ( rand() % 4 == 0 )
+			{
+				pDirection->Set( extremeValue(), extremeValue() );
+			}
+			break;
+		
+		default:
+			break;
+	}
+}
+
+#ifdef B2_SIMD_COLLISION
+
+// ============================== check equivalence =====================
+/// Returns number of searches in which SIMD and scalar results differ
+static int checkEquivalence()
+{
+	int mismatches = 0;
+	
+	for( int c = 0; c < CASE_COUNT; c++ )
+	{
+		for( int count = 1; count <= b2_maxPolyVertices; count++ )
+		{
+			int caseMismatches = 0;
+			for( int i = 0; i < CHECKS_PER_COUNT; i++ )
+			{
+				Polygon polygon;
+				b2Vec2 d;
+				makeCase( Case( c ), count, &polygon, &d );
+				
+				int32 maxScalar	= b2FindMaxVertexScalar( polygon.vertices, count, d );
+				int32 maxSimd	= b2FindExtremeVertexSIMD<true>( polygon.vertices, count, d );
+				int32 minScalar	= b2FindMinVertexScalar( polygon.vertices, count, d );
+				int32 minSimd	= b2FindExtremeVertexSIMD<false>( polygon.vertices, count, d );
+				
+				if ( maxScalar != maxSimd || minScalar != minSimd )
+				{
+					if ( caseMismatches == 0 )
+					{
+						fprintf( stderr, "mismatch: case=%s count=%d d=(%g, %g) max %d/%d min %d/%d\n"
+							, CASE_NAMES[c], count, d.x, d.y, maxScalar, maxSimd, minScalar, minSimd );
+					}
+					caseMismatches++;
+				}
+			}
+			
+			mismatches += caseMismatches;
+		}
+		
+		printf( "%-15s counts 1-%d: %d searches checked\n", CASE_NAMES[c], b2_maxPolyVertices, 2 * CHECKS_PER_COUNT * b2_maxPolyVertices );
+	}
+	
+	return mismatches;
+}
+
+// ============================== bench =====================
+static volatile int32 s_sink;	///< Keeps benchmarked results alive
+
+/// Returns nanoseconds per search, fastest of several timing loops
+template < int32 (*search)( const b2Vec2*, int32, const b2Vec2& ) >
+static double bench( const Polygon* polygons, const b2Vec2* directions, int count )
+{
+	double fastest = DBL_MAX;
+	
+	for( int repeat = 0; repeat < BENCH_REPEATS; repeat++ )
+	{
+		int32 sum = 0;
+		
+		clock_t start = clock();
+		for( int round = 0; round < BENCH_ROUNDS; round++ )
+		{
+			for( int i = 0; i < BENCH_POLYGONS; i++ )
+			{
+				sum += search( polygons[i].vertices, count, directions[ ( i + round ) & ( BENCH_POLYGONS - 1 ) ] );
+			}
+		}
+		double elapsed = double( clock() - start ) / CLOCKS_PER_SEC;
+		s_sink = sum;
+		
+		fastest = b2Min( fastest, elapsed );
+	}
+	
+	return fastest * 1e9 / ( double( BENCH_ROUNDS ) * BENCH_POLYGONS );
+}
+
+static int32 simdMax( const b2Vec2* vertices, int32 count, const b2Vec2& d )
+{
+	return b2FindExtremeVertexSIMD<true>( vertices, count, d );
+}
+
+// ============================== measure =====================
+/// Prints time of scalar and SIMD search for each vertex count
+static void measure()
+{
+	Polygon* polygons = new Polygon[ BENCH_POLYGONS ];
+	b2Vec2* directions = new b2Vec2[ BENCH_POLYGONS ];
+	for( int i = 0; i < BENCH_POLYGONS; i++ )
+	{
+		makeCase( RandomPolygon, b2_maxPolyVertices, polygons + i, directions + i );
+	}
+	
+	printf( "vertices  scalar[ns]  simd[ns]  used\n" );
+	for( int count = 3; count <= b2_maxPolyVertices; count++ )
+	{
+		double scalar	= bench< b2FindMaxVertexScalar >( polygons, directions, count );
+		double simd		= bench< simdMax >( polygons, directions, count );
+		
+		printf( "%8d  %10.2f  %8.2f  %s\n", count, scalar, simd, count >= b2_minSimdVertices ? "simd" : "scalar" );
+	}
+	
+	delete[] polygons;
+	delete[] directions;
+}
+
+#endif
+
+// ============================== main =====================
+int main( int argc, char* argv[] )
+{
+	bool timing = true;
+	if ( argc == 2 && ! strcmp( argv[1], "-n" ) )
+	{
+		timing = false;
+	}
+	else if ( argc > 1 )
+	{
+		fprintf( stderr,
+			"Usage: vertexsearchtest [-n]\n"
+			"Checks SIMD polygon vertex search against the scalar loop, then times both.\n"
+			"  -n  skip timing\n" );
+		return 1;
+	}
+	
+#ifdef B2_SIMD_COLLISION
+	srand( SEED );
+	
+	int mismatches = checkEquivalence();
+	if ( mismatches )
+	{
+		printf( "FAILED: %d mismatches\n", mismatches );
+		return 2;
+	}
+	printf( "OK: SIMD and scalar search agree\n" );
+	
+	if ( timing )
+	{
+		measure();
+	}
+	
+	return 0;
+#else
+	printf( "SIMD vertex search is disabled in this build, nothing to check\n" );
+	return 0;
+#endif
+}
+
+// EOF
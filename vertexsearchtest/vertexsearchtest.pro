@@ -0,0 +1,18 @@
+TEMPLATE = app
+
+SOURCES += main.cpp
+
+CONFIG += release \
+warn_on \
+console
+CONFIG -= qt \
+app_bundle
+TARGET = ../bin/vertexsearchtest
+
+OBJECTS_DIR = .obj
+
+INCLUDEPATH += ../box2d \
+../box2d/Collision \
+../box2d/Common
+LIBS += ../lib/libbox2d.a
+TARGETDEPS += ../lib/libbox2d.a